@@ -38,6 +38,7 @@
 #include "ttftp.h"
 #include "config.h"
 #include "dan2volumes.h"
+#include "dan2trace.h"
 
 /*************************************************/
 // => See DAN2config.h for configuration options!
@@ -47,6 +48,12 @@
 #include "w5500.h"
 #endif
 
+// the socket commands and the receive filter need more flash than the ATmega328P has
+#if !defined(USE_ETHERNET) || !defined(__AVR_ATmega644P__)
+  #undef USE_ETHERNET_SOCKETS
+  #undef USE_ETHERNET_FILTER
+#endif
+
 // Include header with selected boot program
 #if BOOTPG<=1
   #warning No bootpg selected.
@@ -89,18 +96,17 @@
 #define EEPROM_SLOT1   2
 #define EEPROM_A2SLOT  3
 #define EEPROM_MAC_IP  4 // bytes 4-13: MAC + IP address for FTP server
-#define EEPROM_FREE   14 // next available byte, for future extensions
+#define EEPROM_WRBACK 14 // write-back mode: 1=enabled
+#define EEPROM_FREE   15 // next available byte, for future extensions
 
 #ifdef USE_ETHERNET
+#define ETH_MACRAW  1 // the 6502 uses the WIZnet in MACRAW mode (commands 0x10-0x15)
+#define ETH_SOCKETS 2 // the 6502 uses the WIZnet's TCP/UDP sockets (commands 0x40-0x47)
 uint8_t ethernet_initialized = 0;
 Wiznet5500 eth(8);
 #endif
 
-uint8_t drive_fileno[2];
 uint8_t drive_fileno_eeprom[2];
-uint8_t a2slot;
-
-uint8_t  unit;
 static uint16_t bufaddr; // buffer address in Apple II memory
 
 #ifdef DEBUG_BYTES
@@ -163,6 +169,10 @@ void read_eeprom(void)
 
   drive_fileno_eeprom[0] = drive_fileno[0];
   drive_fileno_eeprom[1] = drive_fileno[1];
+
+#ifdef USE_WRITE_BACK
+  vol_write_back = (EEPROM.read(EEPROM_WRBACK) == 1);
+#endif
 }
 
 void write_eeprom(void)
@@ -216,6 +226,9 @@ void setup_serial(void)
 
 void write_dataport(uint8_t ch)
 {
+#ifdef USE_TRACE
+  trace_result(ch);
+#endif
   while (READ_IBFA() != 0);
   DATAPORT_MODE_TRANS();
   WRITE_DATAPORT(ch);
@@ -224,6 +237,12 @@ void write_dataport(uint8_t ch)
   DATAPORT_MODE_RECEIVE();
 }
 
+void write_word(uint16_t w)
+{
+  write_dataport(w & 0xff);
+  write_dataport(w >> 8);
+}
+
 uint8_t read_dataport(void)
 {
   uint8_t byt;
@@ -235,6 +254,32 @@ uint8_t read_dataport(void)
   return byt;
 }
 
+void write_block(uint8_t* buf)
+{
+  DATAPORT_MODE_TRANS();
+  for (uint16_t i = 0; i < 512; i++)
+  {
+    while (READ_IBFA() != 0);
+    WRITE_DATAPORT(buf[i]);
+    STB_LOW();
+    STB_HIGH();
+  }
+  DATAPORT_MODE_RECEIVE();
+}
+
+#ifdef USE_BLOCK_CACHE
+void read_block(uint8_t* buf)
+{
+  for (uint16_t i = 0; i < 512; i++)
+  {
+    while (READ_OBFA() != 0);
+    ACK_LOW();
+    buf[i] = READ_DATAPORT();
+    ACK_HIGH();
+  }
+}
+#endif
+
 void get_unit_buf_blk(void)
 {
   unit = read_dataport();
@@ -254,70 +299,9 @@ void get_unit_buf_blk(void)
   SERIALPORT()->print("0000 blk=");
   SERIALPORT()->println(request.blk, HEX);
 #endif
-}
-
-// take care of special mapping in "ALLVOLS" mode
-void calculate_allvols()
-{
-  uint8_t drive  = (unit >> 7); // access drive 0 or drive 1?
-
-  uint8_t drive1fno = drive_fileno[0];
-  uint8_t drive2fno = drive_fileno[1]^0x80;
-
-  if (drive1fno == drive2fno)
-  {
-    // multiple drive access disabled when both are configured to the same volume
-    request.filenum = request.sdslot = 0xff;
-    return;
-  }
-
-  request.filenum  = ((drive==0) ? drive1fno : drive2fno) & 0x80; // map to the SD card to SD card of drive 1 or drive 2
-  request.filenum |= ((unit>>4) & 0x7); // requested file number according to request slot
-
-  if ((drive==1)&&(((drive1fno ^ drive2fno)&0x80) == 0))
-  {
-    // D2 requested, and both drives are configured to the same SD card = "wide access"
-    request.filenum |= 0x8;
-  }
-
-  // now some checks to avoid mapping the same drive multiple times
-  if ((request.filenum == drive1fno)||(request.filenum == drive2fno))
-  {
-    request.filenum &= 0x88; // try volume 0 or 8 instead (on current SDcard)
-  }
-
-  if ((request.filenum == drive1fno)||(request.filenum == drive2fno))
-  {
-    // still in conflict? Then don't map any drive for this request...
-    request.filenum = request.sdslot = 0xff;
-    return;
-  }
-
-  // success: properly decode SDcard and file
-  request.sdslot   = (request.filenum >> 7) & 0x1;
-  request.filenum &= 0xF;
-}
-
-// calculate: sdslot and filenum
-void calculate_sd_filenum()
-{
-  uint8_t drive  = (unit >> 7); // access drive 0 or drive 1?
-
-  if ((drive == 1)&&(drive_fileno[0] == (drive_fileno[1]^0x80)))
-  {
-    // multiple drive access disabled when both are configured to the same volume
-    request.filenum = request.sdslot = 0xff;
-    return;
-  }
-
-  request.filenum = drive_fileno[drive];            // which file to access on this drive by default?
-  request.sdslot  = (request.filenum >> 7) ^ drive; // on SD slot 0 or 1?
-  request.filenum &= 0x7f;                          // mask file number (get rid of slot selection bit)
-
-  // check if the request was received with the "normal" slot number (otherwise the "ALLVOLS" magic is active)
-  uint8_t current_slot = (unit >> 4) & 7;
-  if (current_slot != a2slot)
-    calculate_allvols();
+#ifdef USE_TRACE
+  trace_params(unit, bufaddr, request.blk);
+#endif
 }
 
 uint8_t do_status(void)
@@ -370,10 +354,21 @@ uint8_t read_bootblock(uint8_t rdtype, uint8_t* buf)
 }
 #endif
 
-void do_read(uint8_t rdtype)
+#if BOOTPG>1
+// kept out of do_read, so the 512 byte buffer is only on the stack for boot blocks
+__attribute__((noinline)) void send_bootblock(uint8_t rdtype)
 {
   uint8_t buf[512];
 
+  uint8_t returncode = read_bootblock(rdtype, buf);
+  write_dataport(returncode);
+  if (returncode==0)
+    write_block(buf);
+}
+#endif
+
+void do_read(uint8_t rdtype)
+{
   get_unit_buf_blk();
 
   uint8_t returncode = 0;
@@ -383,32 +378,69 @@ void do_read(uint8_t rdtype)
 #endif
   {
     calculate_sd_filenum();
-    returncode = vol_read_block(buf);
+#ifdef USE_BLOCK_CACHE
+    // send the block from the cache (reading it into the cache first, when necessary)
+    uint8_t* data;
+    returncode = vol_read_cached(&data);
+    if (returncode == 0)
+    {
+      write_dataport(0);
+      write_block(data);
+      return;
+    }
+#else
+    // stream the block from the SD card straight to the Apple II
+    returncode = vol_read_start(1);
+    if (returncode == 0)
+      returncode = vol_read_next(NULL);
+    vol_read_stop();
+    // status and data were already sent (a CRC error can't be reported here)
+    if ((returncode == 0)||(returncode == VOL_CRC_ERR))
+      return;
+#endif
   }
 
 #if BOOTPG>1
   if ( (rdtype>=RD_BOOT_BLOCK)||  // RD_BOOT_BLOCK || RD_A3_BOOT_BLOCK
-      ((rdtype==RD_FAILSAFE)&&(returncode != 0)))
+      (rdtype==RD_FAILSAFE))
   {
     // transmit bootpg if requested or volume is missing
-    returncode = read_bootblock(rdtype, buf);
+    send_bootblock(rdtype);
+    return;
   }
 #endif
 
   write_dataport(returncode);
+}
 
-  if (returncode==0)
+/* Multi-block read: reads up to 255 consecutive blocks with a single command.
+   The block count is passed in the low byte of the buffer address (the buffer
+   address is not needed by the firmware). Every block is preceded by a status
+   byte and followed by a check byte, since the block is streamed from the SD
+   card while its CRC is still unknown: a non-zero check byte means the block
+   data is corrupt. The transfer is aborted after the first non-zero status or
+   check byte. */
+void do_read_multi(void)
+{
+  get_unit_buf_blk();
+  calculate_sd_filenum();
+
+  uint8_t count = bufaddr & 0xff;
+  uint8_t returncode = vol_read_start(count);
+  do
   {
-    DATAPORT_MODE_TRANS();
-    for (uint16_t i = 0; i < 512; i++)
+    if (returncode == 0)
+      returncode = vol_read_next(NULL);
+    if (returncode == VOL_CRC_ERR)
     {
-      while (READ_IBFA() != 0);
-      WRITE_DATAPORT(buf[i]);
-      STB_LOW();
-      STB_HIGH();
+      write_dataport(PRODOS_IO_ERR); // check byte: block data is corrupt
+      break;
     }
-    DATAPORT_MODE_RECEIVE();
-  }
+    write_dataport(returncode); // status byte or check byte
+    if (returncode != 0)
+      break;
+  } while (--count);
+  vol_read_stop();
 }
 
 void do_write(void)
@@ -417,19 +449,88 @@ void do_write(void)
   if (returncode != 0)
     return;
 
-  uint8_t buf[512];
-  for (uint16_t i = 0; i < 512; i++)
+#ifdef DEBUG_SERIAL
+  // no block buffer on the stack anymore: check the free memory during a write
+  SERIALPORT()->print(" f=");
+  SERIALPORT()->println(freeRam());
+#endif
+
+#ifdef USE_WRITE_BACK
+  if (vol_write_back)
   {
-    while (READ_OBFA() != 0);
-    ACK_LOW();
-    buf[i] = READ_DATAPORT();
-    ACK_HIGH();
+    // write-back: the block is received into the cache, it is written to disk when the Apple II is idle
+    read_block(vol_write_deferred());
+    return;
+  }
+#endif
+
+#ifdef USE_BLOCK_CACHE
+  // write-through: a cached block is received into the cache, then written to disk
+  uint8_t* data = vol_cache_block();
+  if (data)
+  {
+    read_block(data);
+    vol_write_block(data);
+    return;
   }
+#endif
 
+  // stream the block from the Apple II straight to the SD card
+  vol_write_start(1, true);
+  vol_write_next(NULL); // always receives the block, even on errors
+  vol_write_stop();
+}
+
+/* Multi-block write: writes up to 255 consecutive blocks with a single command.
+   The block count is passed in the low byte of the buffer address. The command
+   is confirmed with a status byte, then every block received from the Apple II
+   is confirmed with a status byte. The Apple II must stop sending blocks after
+   the first non-zero status byte. */
+void do_write_multi(void)
+{
+  get_unit_buf_blk();
   calculate_sd_filenum();
-  vol_write_block(buf);
+
+  uint8_t count = bufaddr & 0xff;
+  uint8_t returncode = vol_write_start(count, true);
+  write_dataport(returncode);
+  if (returncode != 0)
+    return;
+
+  do
+  {
+    returncode = vol_write_next(NULL);
+    write_dataport(returncode);
+  } while ((returncode == 0)&&(--count));
+  vol_write_stop();
 }
 
+// write all deferred blocks to disk (always successful, unless write-back mode is used)
+void do_flush(void)
+{
+  get_unit_buf_blk();
+  uint8_t returncode = 0;
+#ifdef USE_WRITE_BACK
+  returncode = vol_cache_flush();
+  vol_cache_error = 0; // error was reported
+#endif
+  write_dataport(returncode);
+}
+
+#ifdef USE_WRITE_BACK
+// enable (block number=1) or disable (block number=0) the write-back mode, setting is stored in EEPROM
+void do_set_write_back(void)
+{
+  get_unit_buf_blk();
+  uint8_t returncode = vol_cache_flush();
+  vol_cache_error = 0;
+  vol_write_back = (request.blk == 1);
+  if (EEPROM.read(EEPROM_WRBACK) != vol_write_back)
+    EEPROM.write(EEPROM_WRBACK, vol_write_back);
+  write_dataport(returncode);
+}
+#endif
+
 void do_format(void)
 {
   do_status();
@@ -449,6 +550,15 @@ void write_zeros(uint16_t num)
   DATAPORT_MODE_RECEIVE();
 }
 
+void read_discard(uint16_t num)
+{
+  while (num > 0)
+  {
+    read_dataport();
+    num--;
+  }
+}
+
 void do_set_volume(uint8_t cmd)
 {
   // cmd=4: permanently selects drives 0+1, single byte response (used by eprom+bootpg for volume selection)
@@ -472,6 +582,10 @@ void do_set_volume(uint8_t cmd)
     drive_fileno[1] = 0x88; // select volume 8 on SD1
   }
 
+#ifdef USE_BLOCK_CACHE
+  vol_cache_invalidate();
+#endif
+
   if (cmd != 6) // don't update EEPROM for temporary selection
     write_eeprom();
 
@@ -523,7 +637,7 @@ void do_initialize_ethernet(void)
 #ifdef DEBUG_SERIAL
     SERIALPORT()->println("initialized");
 #endif
-    ethernet_initialized = 1;
+    ethernet_initialized = ETH_MACRAW;
     write_dataport(0);
     return;
   }
@@ -540,7 +654,7 @@ void do_poll_ethernet(void)
 #ifdef DEBUG_SERIAL
   SERIALPORT()->println("poll eth");
 #endif
-  if (ethernet_initialized)
+  if (ethernet_initialized == ETH_MACRAW)
   {
     len = read_dataport();
     len |= ((uint16_t)read_dataport()) << 8;
@@ -561,13 +675,64 @@ void do_poll_ethernet(void)
   }
 }
 
+// Command 0x13: like 0x11, but returns all received frames, which fit into the given number of bytes.
+// Each frame is preceded by its length (16bit), the list ends with a length of 0. The budget includes
+// all length bytes, so 2+n*(2+1514) bytes are needed to fetch n full size frames with one command.
+void do_poll_ethernet_batch(void)
+{
+  uint16_t budget;
+#ifdef DEBUG_SERIAL
+  SERIALPORT()->println("poll eth batch");
+#endif
+  budget = read_dataport();
+  budget |= ((uint16_t)read_dataport()) << 8;
+  if (ethernet_initialized == ETH_MACRAW)
+  {
+    mmc_wait_busy_spi(); // make no MMC card is blocking the SPI bus before accessing WIZnet SPI
+    eth.readFrames(budget);
+  } else
+  {
+    write_dataport(0);
+    write_dataport(0);
+  }
+}
+
+#ifdef USE_ETHERNET_FILTER
+// Command 0x14: configure the receive filter of the MACRAW mode, after command 0x10 (which disables the filter).
+// Parameters: flags (Wiznet5500::FILTER_*, 0=no filter), own IP address (4 bytes), two further EtherTypes and
+// four TCP/UDP destination ports (16bit each, 0=unused). Frames delivered and dropped since command 0x10 are
+// counted in the version block.
+void do_filter_ethernet(void)
+{
+  eth.filter.flags = read_dataport();
+  for (uint8_t i=0;i<4;i++)
+    eth.filter.ip[i] = read_dataport();
+  for (uint8_t i=0;i<6;i++)
+  {
+    uint16_t w = read_dataport();
+    w |= ((uint16_t)read_dataport()) << 8;
+    if (i < 2)
+      eth.filter.ethertypes[i] = w;
+    else
+      eth.filter.ports[i-2] = w;
+  }
+  if (ethernet_initialized == ETH_MACRAW)
+    write_dataport(0);
+  else
+  {
+    eth.filter.flags = 0;
+    write_dataport(1);
+  }
+}
+#endif
+
 void do_send_ethernet(void)
 {
   uint16_t len;
 #ifdef DEBUG_SERIAL
   SERIALPORT()->println("send eth");
 #endif
-  if (ethernet_initialized)
+  if (ethernet_initialized == ETH_MACRAW)
   {
     len = read_dataport();
     len |= ((uint16_t)read_dataport()) << 8;
@@ -576,10 +741,128 @@ void do_send_ethernet(void)
     SERIALPORT()->println(len, HEX);
 #endif
     mmc_wait_busy_spi(); // make no MMC card is blocking the SPI bus before accessing WIZnet SPI
-    eth.sendFrame(NULL, len);
+    if (eth.sendFrame(NULL, len) != len)
+      read_discard(len);
   }
   write_dataport(0);
 }
+
+// Command 0x15: send a list of frames, each preceded by its length (16bit), the list ends with a length of 0.
+// Each frame is copied to the WIZnet while the previous one is still being sent, so a burst of frames needs
+// no command round trip and no wait for the transmission per frame. Returns 0 if all frames were sent.
+void do_send_ethernet_batch(void)
+{
+  uint8_t status = 0;
+  uint16_t len;
+#ifdef DEBUG_SERIAL
+  SERIALPORT()->println("send eth batch");
+#endif
+  if (ethernet_initialized == ETH_MACRAW)
+    mmc_wait_busy_spi(); // make no MMC card is blocking the SPI bus before accessing WIZnet SPI
+  for (;;)
+  {
+    len = read_dataport();
+    len |= ((uint16_t)read_dataport()) << 8;
+    if (len == 0)
+      break;
+    if ((ethernet_initialized != ETH_MACRAW)||(eth.sendFrame(NULL, len) != len))
+    {
+      read_discard(len);
+      status = 1;
+    }
+  }
+  write_dataport(status);
+}
+#endif
+
+#ifdef USE_ETHERNET_SOCKETS
+// Commands 0x40-0x47: the WIZnet's TCP/UDP sockets, so the 6502 does not need its own IP stack.
+// Command 0x40 is followed by the IP configuration, all other commands by a socket number (or protocol)
+// and a 16bit value (little-endian). Unused values are ignored.
+//  0x40 init    MAC(6), IP(4), subnet(4), gateway(4) => status (0=ok). Stops the FTP server.
+//  0x41 open    protocol (1=TCP, 2=UDP), local port (0=any) => socket number (0xFF=no free socket)
+//  0x42 connect socket, remote port, followed by the IP address(4) => status. TCP: connects in the
+//               background (see 0x46), UDP: sets the destination of the following datagrams.
+//  0x43 listen  socket, unused => status
+//  0x44 send    socket, length => accepted length (16bit), then the 6502 sends the accepted bytes
+//  0x45 recv    socket, buffer size => length (16bit) and data (UDP: one datagram with its header)
+//  0x46 status  socket, unused => socket state (W5500 Sn_SR, 0xFF=invalid socket), received bytes,
+//               free TX buffer space (16bit each)
+//  0x47 close   socket, mode (0=disconnect, 1=close immediately) => status
+void do_socket(uint8_t cmd)
+{
+  uint8_t  param[18];
+  uint8_t  s;
+  uint8_t  status = 1;
+  uint16_t len;
+
+  if (cmd == 0x40)
+  {
+    for (uint8_t i=0;i<18;i++)
+      param[i] = read_dataport();
+    mmc_wait_busy_spi(); // make no MMC card is blocking the SPI bus before accessing WIZnet SPI
+    if (ethernet_initialized == ETH_MACRAW)
+      eth.end();
+    ethernet_initialized = (eth.beginSockets(param)) ? ETH_SOCKETS : 0;
+    write_dataport((ethernet_initialized) ? 0 : 1);
+    return;
+  }
+
+  s = read_dataport(); // protocol (0x41) or socket number
+  len = read_dataport();
+  len |= ((uint16_t)read_dataport()) << 8;
+  if ((cmd != 0x41)&&(s >= Wiznet5500::SocketCount))
+    s = 0xff;
+  if (ethernet_initialized != ETH_SOCKETS)
+    s = 0xff;
+  else
+    mmc_wait_busy_spi(); // make no MMC card is blocking the SPI bus before accessing WIZnet SPI
+
+  switch (cmd)
+  {
+    case 0x41:
+      write_dataport((s == 0xff) ? 0xff : eth.socketOpen(s, len));
+      return;
+    case 0x42:
+      for (uint8_t i=0;i<4;i++)
+        param[i] = read_dataport();
+      if ((s != 0xff)&&(eth.socketConnect(s, param, len)))
+        status = 0;
+      break;
+    case 0x43:
+      if ((s != 0xff)&&(eth.socketListen(s)))
+        status = 0;
+      break;
+    case 0x44:
+      if (s == 0xff)
+        write_word(0);
+      else
+        eth.socketSend(s, NULL, len);
+      return;
+    case 0x45:
+      if (s == 0xff)
+        write_word(0);
+      else
+        eth.socketRecv(s, NULL, len);
+      return;
+    case 0x46:
+    {
+      uint16_t received = 0, txfree = 0;
+      write_dataport((s == 0xff) ? 0xff : eth.socketStatus(s, &received, &txfree));
+      write_word(received);
+      write_word(txfree);
+      return;
+    }
+    case 0x47:
+      if (s != 0xff)
+      {
+        eth.socketClose(s, len & 0xff);
+        status = 0;
+      }
+      break;
+  }
+  write_dataport(status);
+}
 #endif
 
 
@@ -620,6 +903,108 @@ void do_get_ip_config(void)
 }
 #endif
 
+/* Obtain volume diagnostics for the given unit (for example to find fragmented volumes).
+   Uses standard ProDOS reply format with a 512byte block.
+
+   Format of the returned 512 byte block:
+    Offset   Usage
+    0x00     SD card format: 1=FAT, 2=RAW
+    0x01     Volume file number
+    0x02     Number of fragments (16bit): 1=contiguous (fast direct access), 0=unknown
+    0x04     Start sector on the SD card (32bit, contiguous volumes only)
+    0x08     Volume size in blocks (32bit)
+    0x0C     reserved (0)
+    ...      reserved (0)
+    0x1ff    reserved (0)
+*/
+void do_volume_info(void)
+{
+  get_unit_buf_blk();
+  calculate_sd_filenum();
+
+  uint32_t blocks, sector;
+  uint16_t frags;
+  uint8_t returncode = vol_get_extents(&blocks, &sector, &frags);
+  write_dataport(returncode);
+  if (returncode != 0)
+    return;
+
+  write_dataport(slot_type[request.sdslot]);
+  write_dataport(request.filenum);
+  write_word(frags);
+  write_word(sector & 0xffff);
+  write_word(sector >> 16);
+  write_word(blocks & 0xffff);
+  write_word(blocks >> 16);
+  write_zeros(512-12);
+}
+
+/* Obtain a catalog of ProDOS volume names and sizes (i.e. for the boot menu), with 16 volumes per 512 byte block.
+   The first volume is passed in the low byte of the block number (bit 7: SD2), the number of blocks (1-8) in the
+   high byte (0: single block, as with the standard ProDOS reply format). The same information is used by the FTP
+   directory listing (and comes from the volume catalog, when available). Entries behind the last volume of the
+   SD card (127) are all 0.
+
+   Format of each 32 byte entry:
+    Offset   Usage
+    0x00     Volume file number (bit 7: SD2)
+    0x01     Flags: 0x01=ProDOS volume (all following fields are 0 otherwise)
+    0x02     Volume size in blocks (16bit)
+    0x04     ProDOS storage type and name length ($F1-$FF), as in the ProDOS volume header
+    0x05     ProDOS volume name (15 characters, ASCII, padded with spaces)
+    0x14     reserved (0)
+    ...      reserved (0)
+    0x1f     reserved (0)
+*/
+void do_volume_catalog(void)
+{
+  get_unit_buf_blk();
+
+  uint8_t volume  = request.blk & 0xff;
+  uint8_t count   = request.blk >> 8;
+  if (count > 8)
+    count = 8;
+  uint8_t entries = (count) ? count*16 : 16;
+
+  // volumes behind the last volume of the SD card (127) are returned as empty entries
+  uint8_t empty = 0;
+  if (entries > 128 - (volume & 0x7f))
+  {
+    empty   = entries - (128 - (volume & 0x7f));
+    entries = 128 - (volume & 0x7f);
+  }
+
+  request.sdslot = volume >> 7;
+  uint8_t* buf = vol_header_buffer();
+
+  write_dataport(0x00);
+  do
+  {
+    char     VolName[16];
+    uint32_t blocks;
+    request.filenum = volume & 0x7f;
+    vol_get_volume_name(buf, VolName, &blocks);
+
+    write_dataport(volume++);
+    if (VolName[0])
+    {
+      // length of the space padded name
+      uint8_t len = 15;
+      while ((len > 0)&&(VolName[len-1] == ' '))
+        len--;
+      write_dataport(0x01);
+      write_word(blocks);
+      write_dataport(0xf0 | len);
+      for (uint8_t i=0;i<15;i++)
+        write_dataport(VolName[i]);
+      write_zeros(32-20);
+    }
+    else
+      write_zeros(32-1);
+  } while (--entries);
+  write_zeros(((uint16_t) empty)*32);
+}
+
 /* Obtain firmware version and type information
    Uses standard ProDOS reply format with a 512byte block.
 
@@ -630,7 +1015,19 @@ void do_get_ip_config(void)
     0x02     Firmware maintenance version (_._.X)
     0x03     DAN][ board/hardware type: 0x3=standard ATmega328p, 0x4=ATmega644p, ...
     0x04     Firmware feature flags (see below)
-    0x05     reserved (0)
+    0x05     Run-time flags: 0x01=write-back mode enabled
+    0x06     Block cache hits (16bit)
+    0x08     Block cache misses (16bit)
+    0x0A     Blocks read ahead (16bit)
+    0x0C     Blocks read ahead, which were then requested (16bit)
+    0x0E     Read-aheads aborted by Apple II commands (16bit)
+    0x10     FAT mount operations (16bit)
+    0x12     More firmware feature flags: 0x01=volume catalog command (0x31),
+             0x02=batched Ethernet poll (0x13), 0x04=TCP/UDP socket commands (0x40-0x47),
+             0x08=Ethernet receive filter (0x14), 0x10=batched Ethernet send (0x15)
+    0x13     Ethernet frames delivered to the Apple II (16bit, with receive filter support)
+    0x15     Ethernet frames dropped by the receive filter or the 0x13 budget (16bit)
+    0x17     reserved (0)
     ...      reserved (0)
     0x1ff    reserver (0)
 */
@@ -658,11 +1055,66 @@ void do_version(void)
 #ifdef USE_FTP
       FwFlags |= 0x10;
 #endif
-      // flags 8,4,2,1 reserved for future features
+      FwFlags |= 0x08; // multi-block read command (0x0C)
+      FwFlags |= 0x04; // multi-block write command (0x0D)
+#ifdef USE_BLOCK_CACHE
+      FwFlags |= 0x02; // block cache
+#endif
+#ifdef USE_WRITE_BACK
+      FwFlags |= 0x01; // write-back mode supported (command 0x0F)
+#endif
       write_dataport(FwFlags);
     }
 
-    write_zeros(512-5);
+    {
+      uint8_t RtFlags = 0x00;
+#ifdef USE_WRITE_BACK
+      if (vol_write_back)
+        RtFlags |= 0x01; // write-back mode enabled
+#endif
+      write_dataport(RtFlags);
+    }
+
+    // statistics (16bit counters, little-endian)
+#ifdef USE_BLOCK_CACHE
+    write_word(vol_cache_hits);        // block cache hits
+    write_word(vol_cache_misses);      // block cache misses
+#else
+    write_zeros(4);
+#endif
+#ifdef USE_READ_AHEAD
+    write_word(vol_ahead_reads);       // blocks read ahead
+    write_word(vol_ahead_hits);        // blocks read ahead, which were then requested
+    write_word(vol_ahead_aborts);      // read-aheads aborted by Apple II commands
+#else
+    write_zeros(6);
+#endif
+
+    write_word(vol_mounts);            // FAT mount operations
+
+    {
+      uint8_t FwFlags2 = 0x01;         // volume catalog command (0x31)
+#ifdef USE_ETHERNET
+      FwFlags2 |= 0x02;                // batched Ethernet poll (0x13)
+      FwFlags2 |= 0x10;                // batched Ethernet send (0x15)
+#endif
+#ifdef USE_ETHERNET_SOCKETS
+      FwFlags2 |= 0x04;                // TCP/UDP socket commands (0x40-0x47)
+#endif
+#ifdef USE_ETHERNET_FILTER
+      FwFlags2 |= 0x08;                // Ethernet receive filter (0x14)
+#endif
+      write_dataport(FwFlags2);
+    }
+
+#ifdef USE_ETHERNET_FILTER
+    write_word(eth.framesDelivered);   // Ethernet frames delivered
+    write_word(eth.framesDropped);     // Ethernet frames dropped by the filter or the budget
+#else
+    write_zeros(4);
+#endif
+
+    write_zeros(512-23);
 }
 
 void do_command(uint8_t cmd)
@@ -672,6 +1124,9 @@ void do_command(uint8_t cmd)
 #ifdef DEBUG_SERIAL
   SERIALPORT()->print("0000 cmd=");
   SERIALPORT()->println(cmd, HEX);
+#endif
+#ifdef USE_TRACE
+  trace_start(cmd);
 #endif
   switch (cmd)
   {
@@ -695,6 +1150,16 @@ void do_command(uint8_t cmd)
       break;
     case 0x0B: do_version();
       break;
+    case 0x0C: do_read_multi();
+      break;
+    case 0x0D: do_write_multi();
+      break;
+    case 0x0E: do_flush();
+      break;
+#ifdef USE_WRITE_BACK
+    case 0x0F: do_set_write_back();
+      break;
+#endif
 #ifdef USE_ETHERNET
     case 0x10: do_initialize_ethernet();
       break;
@@ -702,6 +1167,25 @@ void do_command(uint8_t cmd)
       break;
     case 0x12: do_send_ethernet();
       break;
+    case 0x13: do_poll_ethernet_batch();
+      break;
+    case 0x15: do_send_ethernet_batch();
+      break;
+#endif
+#ifdef USE_ETHERNET_FILTER
+    case 0x14: do_filter_ethernet();
+      break;
+#endif
+#ifdef USE_ETHERNET_SOCKETS
+    case 0x40:
+    case 0x41:
+    case 0x42:
+    case 0x43:
+    case 0x44:
+    case 0x45:
+    case 0x46:
+    case 0x47: do_socket(cmd);
+      break;
 #endif
 #ifdef USE_FTP
     case 0x20: do_set_ip_config();
@@ -709,6 +1193,10 @@ void do_command(uint8_t cmd)
     case 0x21: do_get_ip_config();
       break;
 #endif
+    case 0x30: do_volume_info();
+      break;
+    case 0x31: do_volume_catalog();
+      break;
 #if BOOTPG>1
     case 13+128:
     case 32+128:  do_read(RD_BOOT_BLOCK);
@@ -720,6 +1208,9 @@ void do_command(uint8_t cmd)
     default:      write_dataport(0x27);
       break;
   }
+#ifdef USE_TRACE
+  trace_end();
+#endif
 }
 
 int freeRam ()
@@ -816,7 +1307,7 @@ void loop()
   if (ethernet_initialized==0)  // when slave eth is initialized, we stop FTP processing: the 6502 is now controlling the Wiznet...
  #endif
   {
-    // this will temporarily suspend Apple II requests while an FTP connection is busy
+    // one step of the FTP server (a command byte, directory entry or block), then the Apple II commands
     loopTinyFtp();
     CHECK_MEM(1); // memory overflow check (when enabled)
   }
@@ -827,4 +1318,12 @@ void loop()
     if (instr == 0xAC) do_command(instr);
     CHECK_MEM(0); // memory overflow check (when enabled)
   }
+#ifdef USE_WRITE_BACK
+  // Apple II is idle: write a deferred block to disk
+  vol_cache_flush_idle();
+#endif
+#ifdef USE_READ_AHEAD
+  // Apple II is idle: fetch the next block of a sequential read
+  vol_read_ahead();
+#endif
 }
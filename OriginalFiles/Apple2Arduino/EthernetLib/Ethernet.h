@@ -54,6 +54,11 @@
 // does not always seem to work in practice (maybe WIZnet bugs?)
 //#define ETHERNET_LARGE_BUFFERS
 
+// DAN][: W5500 only. Distribute the 16K transmit and receive buffers unevenly: sockets 0+1 get
+// 8K+4K, sockets 2+3 get 2K each. Servers created with large_buffers=true (FTP data connections)
+// prefer sockets 0+1, all others prefer sockets 3+2.
+#define ETHERNET_DAN_BUFFERS
+
 
 #include <Arduino.h>
 #include "Client.h"
@@ -126,7 +131,7 @@ public:
 	friend class EthernetUDP;
 private:
 	// Opens a socket(TCP or UDP or IP_RAW mode)
-	static uint8_t socketBegin(uint8_t protocol, uint16_t port);
+	static uint8_t socketBegin(uint8_t protocol, uint16_t port, bool large_buffers=false);
 	static uint8_t socketBeginMulticast(uint8_t protocol, IPAddress ip,uint16_t port);
 	static uint8_t socketStatus(uint8_t s);
 	// Close socket
@@ -140,6 +145,9 @@ private:
 	// Send data (TCP)
 	static uint16_t socketSend(uint8_t s, const uint8_t * buf, uint16_t len);
 	static uint16_t socketSendAvailable(uint8_t s);
+	// DAN][: Send data (TCP), without waiting for the completion of the previous send
+	static uint16_t socketSendQueued(uint8_t s, const uint8_t * buf, uint16_t len);
+	static bool socketSendPending(uint8_t s);
 	// Receive data (TCP)
 	static int socketRecv(uint8_t s, uint8_t * buf, int16_t len);
 	static uint16_t socketRecvAvailable(uint8_t s);
@@ -240,6 +248,10 @@ public:
 	virtual int availableForWrite(void);
 	virtual size_t write(uint8_t);
 	virtual size_t write(const uint8_t *buf, size_t size);
+	// DAN][: queue data without waiting for the transmission: returns 0 when the TX buffer has no room
+	size_t writeQueued(const uint8_t *buf, size_t size);
+	// DAN][: true while queued data is still being transmitted
+	bool sendPending(void);
 	virtual int available();
 	virtual int read();
 	virtual int read(uint8_t *buf, size_t size);
@@ -271,8 +283,9 @@ private:
 class EthernetServer : public Server {
 private:
 	uint16_t _port;
+	bool     _large_buffers;
 public:
-	EthernetServer(uint16_t port) : _port(port) { }
+	EthernetServer(uint16_t port, bool large_buffers=false) : _port(port), _large_buffers(large_buffers) { }
 	EthernetClient available();
 	EthernetClient accept();
 	virtual void begin();
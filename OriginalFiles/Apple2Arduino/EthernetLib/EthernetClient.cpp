@@ -92,6 +92,18 @@ size_t EthernetClient::write(const uint8_t *buf, size_t size)
 	return 0;
 }
 
+size_t EthernetClient::writeQueued(const uint8_t *buf, size_t size)
+{
+	if (_sockindex >= MAX_SOCK_NUM) return 0;
+	return Ethernet.socketSendQueued(_sockindex, buf, size);
+}
+
+bool EthernetClient::sendPending(void)
+{
+	if (_sockindex >= MAX_SOCK_NUM) return false;
+	return Ethernet.socketSendPending(_sockindex);
+}
+
 int EthernetClient::available()
 {
 	if (_sockindex >= MAX_SOCK_NUM) return 0;
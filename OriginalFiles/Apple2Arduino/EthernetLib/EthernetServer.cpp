@@ -27,7 +27,7 @@ uint16_t EthernetServer::server_port[MAX_SOCK_NUM];
 
 void EthernetServer::begin()
 {
-	uint8_t sockindex = Ethernet.socketBegin(SnMR::TCP, _port);
+	uint8_t sockindex = Ethernet.socketBegin(SnMR::TCP, _port, _large_buffers);
 	if (sockindex < MAX_SOCK_NUM) {
 		if (Ethernet.socketListen(sockindex)) {
 			server_port[sockindex] = _port;
@@ -36,8 +36,13 @@ typedef struct {
 	uint16_t RX_RD;  // Address to read
 	uint16_t TX_FSR; // Free space ready for transmit
 	uint8_t  RX_inc; // how much have we advanced RX_RD
+	uint8_t  TX_flags; // DAN][: queued transmission state
 } socketstate_t;
 
+// DAN][: TX_flags
+#define TX_QUEUED  0x01 // data was written, but no SEND command was issued yet
+#define TX_SENDING 0x02 // SEND command was issued, SEND_OK is still pending
+
 static socketstate_t state[MAX_SOCK_NUM];
 
 
@@ -60,9 +65,11 @@ void EthernetClass::socketPortRand(uint16_t n)
 	//Serial.printf("socketPortRand %d, srcport=%d\n", n, local_port);
 }
 
-uint8_t EthernetClass::socketBegin(uint8_t protocol, uint16_t port)
+uint8_t EthernetClass::socketBegin(uint8_t protocol, uint16_t port, bool large_buffers)
 {
 	uint8_t s, status[MAX_SOCK_NUM], chip, maxindex=MAX_SOCK_NUM;
+	uint8_t i, first=0;
+	int8_t step=1;
 
 	// first check hardware compatibility
 	chip = W5100.getChip();
@@ -72,14 +79,23 @@ uint8_t EthernetClass::socketBegin(uint8_t protocol, uint16_t port)
 #endif
 	//Serial.printf("W5000socket begin, protocol=%d, port=%d\n", protocol, port);
 	SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+#ifdef ETHERNET_DAN_BUFFERS
+	// sockets with large buffers come first: search them upwards for large_buffers, downwards otherwise
+	if ((chip == 55)&&(!large_buffers)) {
+		first = maxindex-1;
+		step = -1;
+	}
+#else
+	(void) large_buffers;
+#endif
 	// look at all the hardware sockets, use any that are closed (unused)
-	for (s=0; s < maxindex; s++) {
+	for (i=0, s=first; i < maxindex; i++, s+=step) {
 		status[s] = W5100.readSnSR(s);
 		if (status[s] == SnSR::CLOSED) goto makesocket;
 	}
 	//Serial.printf("W5000socket step2\n");
 	// as a last resort, forcibly close any already closing
-	for (s=0; s < maxindex; s++) {
+	for (i=0, s=first; i < maxindex; i++, s+=step) {
 		uint8_t stat = status[s];
 		if (stat == SnSR::LAST_ACK) goto closemakesocket;
 		if (stat == SnSR::TIME_WAIT) goto closemakesocket;
@@ -118,6 +134,7 @@ makesocket:
 	state[s].RX_RD  = W5100.readSnRX_RD(s); // always zero?
 	state[s].RX_inc = 0;
 	state[s].TX_FSR = 0;
+	state[s].TX_flags = 0;
 	//Serial.printf("W5000socket prot=%d, RX_RD=%d\n", W5100.readSnMR(s), state[s].RX_RD);
 	SPI.endTransaction();
 	return s;
@@ -190,6 +207,7 @@ makesocket:
 	state[s].RX_RD  = W5100.readSnRX_RD(s); // always zero?
 	state[s].RX_inc = 0;
 	state[s].TX_FSR = 0;
+	state[s].TX_flags = 0;
 	//Serial.printf("W5000socket prot=%d, RX_RD=%d\n", W5100.readSnMR(s), state[s].RX_RD);
 	SPI.endTransaction();
 	return s;
@@ -286,6 +304,12 @@ static void read_data(uint8_t s, uint16_t src, uint8_t *dst, uint16_t len)
 	uint16_t src_ptr;
 
 	//Serial.printf("read_data, len=%d, at:%d\n", len, src);
+#ifdef ETHERNET_DAN_BUFFERS
+	if (W5100.hasOffsetAddressMapping()) {
+		W5100.readSnRX(s, src, dst, len);
+		return;
+	}
+#endif
 	src_mask = (uint16_t)src & W5100.SMASK;
 	src_ptr = W5100.RBASE(s) + src_mask;
 
@@ -368,7 +392,7 @@ uint8_t EthernetClass::socketPeek(uint8_t s)
 	uint8_t b;
 	SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
 	uint16_t ptr = state[s].RX_RD;
-	W5100.read((ptr & W5100.SMASK) + W5100.RBASE(s), &b, 1);
+	read_data(s, ptr, &b, 1);
 	SPI.endTransaction();
 	return b;
 }
@@ -399,6 +423,13 @@ static void write_data(uint8_t s, uint16_t data_offset, const uint8_t *data, uin
 {
 	uint16_t ptr = W5100.readSnTX_WR(s);
 	ptr += data_offset;
+#ifdef ETHERNET_DAN_BUFFERS
+	if (W5100.hasOffsetAddressMapping()) {
+		W5100.writeSnTX(s, ptr, data, len);
+		W5100.writeSnTX_WR(s, ptr + len);
+		return;
+	}
+#endif
 	uint16_t offset = ptr & W5100.SMASK;
 	uint16_t dstAddr = offset + W5100.SBASE(s);
 
@@ -480,6 +511,51 @@ uint16_t EthernetClass::socketSendAvailable(uint8_t s)
 	return 0;
 }
 
+// DAN][: Send data (TCP), without waiting for SEND_OK. The data is only written when the TX buffer
+// has enough room for all of it, otherwise 0 is returned. Data written while a previous SEND is still
+// in progress is sent by the next call of socketSendQueued/socketSendPending.
+uint16_t EthernetClass::socketSendQueued(uint8_t s, const uint8_t * buf, uint16_t len)
+{
+	SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+	uint8_t status = W5100.readSnSR(s);
+	if (((status != SnSR::ESTABLISHED) && (status != SnSR::CLOSE_WAIT)) ||
+	    (getSnTX_FSR(s) < len)) {
+		SPI.endTransaction();
+		return 0;
+	}
+	write_data(s, 0, buf, len);
+	state[s].TX_flags |= TX_QUEUED;
+	SPI.endTransaction();
+	socketSendPending(s);
+	return len;
+}
+
+// DAN][: Issue a SEND for queued data, once the previous SEND has completed.
+// Returns true while data is still queued or being sent.
+bool EthernetClass::socketSendPending(uint8_t s)
+{
+	uint8_t flags = state[s].TX_flags;
+	if (!flags)
+		return false;
+	SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+	if (flags & TX_SENDING) {
+		if (W5100.readSnIR(s) & SnIR::SEND_OK) {
+			W5100.writeSnIR(s, SnIR::SEND_OK);
+			flags &= ~TX_SENDING;
+		} else
+		if (W5100.readSnSR(s) == SnSR::CLOSED) {
+			flags = 0; // connection is gone, and so is the data
+		}
+	}
+	if (flags == TX_QUEUED) {
+		W5100.execCmdSn(s, Sock_SEND);
+		flags = TX_SENDING;
+	}
+	SPI.endTransaction();
+	state[s].TX_flags = flags;
+	return (flags != 0);
+}
+
 uint16_t EthernetClass::socketBufferData(uint8_t s, uint16_t offset, const uint8_t* buf, uint16_t len)
 {
 	//Serial.printf("  bufferData, offset=%d, len=%d\n", offset, len);
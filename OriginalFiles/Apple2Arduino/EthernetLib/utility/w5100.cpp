@@ -161,6 +161,13 @@ uint8_t W5100Class::init(void)
 			writeSnRX_SIZE(i, 0);
 			writeSnTX_SIZE(i, 0);
 		}
+#elif defined(ETHERNET_DAN_BUFFERS)
+		// buffer sizes in KB: 8, 4, 2, 2, 0, 0, 0, 0 (16K in total)
+		for (i=0; i<8; i++) {
+			uint8_t size = (i < 2) ? (8 >> i) : ((i < 4) ? 2 : 0);
+			writeSnRX_SIZE(i, size);
+			writeSnTX_SIZE(i, size);
+		}
 #endif
 #ifdef FEATURE_DAN_W5100
 	// Try W5100 last.  This simple chip uses fixed 4 byte frames
@@ -497,6 +504,40 @@ uint16_t W5100Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
 	return len;
 }
 
+// W5500: the chip masks the pointer with the socket's buffer size, the block select bits pick the socket
+uint16_t W5100Class::writeSnTX(SOCKET s, uint16_t ptr, const uint8_t *buf, uint16_t len)
+{
+	uint8_t cmd[3];
+	cmd[0] = ptr >> 8;
+	cmd[1] = ptr & 0xFF;
+	cmd[2] = (s << 5) | 0x14;
+	setSS();
+	SPI.transfer(cmd, 3);
+#ifdef SPI_HAS_TRANSFER_BUF
+	SPI.transfer(buf, NULL, len);
+#else
+	for (uint16_t i=0; i < len; i++) {
+		SPI.transfer(buf[i]);
+	}
+#endif
+	resetSS();
+	return len;
+}
+
+uint16_t W5100Class::readSnRX(SOCKET s, uint16_t ptr, uint8_t *buf, uint16_t len)
+{
+	uint8_t cmd[3];
+	cmd[0] = ptr >> 8;
+	cmd[1] = ptr & 0xFF;
+	cmd[2] = (s << 5) | 0x18;
+	setSS();
+	SPI.transfer(cmd, 3);
+	memset(buf, 0, len);
+	SPI.transfer(buf, len);
+	resetSS();
+	return len;
+}
+
 void W5100Class::execCmdSn(SOCKET s, SockCMD _cmd)
 {
 	// Send command to socket
@@ -160,6 +160,9 @@ public:
     read(addr, &data, 1);
     return data;
   }
+  // DAN][: W5500 socket buffers, addressed by the (unmasked) TX/RX pointer - for any buffer size
+  static uint16_t writeSnTX(SOCKET s, uint16_t ptr, const uint8_t *buf, uint16_t len);
+  static uint16_t readSnRX(SOCKET s, uint16_t ptr, uint8_t *buf, uint16_t len);
 
 #define __GP_REGISTER8(name, address)             \
   static inline void write##name(uint8_t _data) { \
@@ -8,113 +8,112 @@ const uint8_t bootblocks[] PROGMEM = {
   0xa0, 0x00, 0x84, 0xf1, 0x88, 0xb1, 0xf1, 0x85, 0xf1, 0xa9, 0x02, 0x85,
   0xf9, 0xe6, 0x46, 0xe6, 0x45, 0xe6, 0x45, 0x20, 0xf0, 0x00, 0x90, 0x06,
   0x20, 0xe2, 0xfb, 0x4c, 0xba, 0xfa, 0xc6, 0xf9, 0xd0, 0xeb, 0xa9, 0x00,
-  0x85, 0xfc, 0x20, 0x93, 0xfe, 0x20, 0x89, 0xfe, 0x20, 0xc4, 0x0b, 0x20,
-  0xb6, 0x08, 0x20, 0x01, 0x09, 0xa5, 0xf5, 0x85, 0x46, 0xa5, 0xf6, 0x85,
-  0x47, 0x20, 0xab, 0x0b, 0x4c, 0xe6, 0x0c, 0x20, 0xd4, 0x08, 0x20, 0x6c,
-  0x08, 0xa5, 0xf7, 0x85, 0x46, 0xa5, 0xf8, 0x85, 0x47, 0x4c, 0xaf, 0x0b,
-  0xa9, 0x00, 0x85, 0xfb, 0xa9, 0x04, 0x85, 0x25, 0x20, 0x22, 0xfc, 0xa5,
-  0xfb, 0x05, 0xfc, 0x85, 0x46, 0x09, 0x80, 0x85, 0x47, 0x20, 0xaf, 0x0b,
-  0xa9, 0x00, 0x20, 0x42, 0x0a, 0xa9, 0xff, 0x85, 0x32, 0xa5, 0x43, 0x09,
-  0x80, 0x85, 0x43, 0xa5, 0xfb, 0x09, 0x80, 0x85, 0xfb, 0xa9, 0x14, 0x20,
-  0x42, 0x0a, 0xa9, 0xff, 0x85, 0x32, 0x4a, 0x25, 0x43, 0x85, 0x43, 0xe6,
-  0x25, 0xe6, 0xfb, 0xa5, 0xfb, 0x29, 0x7f, 0x85, 0xfb, 0xc9, 0x10, 0x90,
-  0xbf, 0x60, 0xa5, 0xf7, 0x85, 0xf5, 0xa5, 0xf8, 0x85, 0xf6, 0x60, 0xa0,
-  0x00, 0x84, 0x24, 0xa0, 0x03, 0x84, 0x25, 0x20, 0x22, 0xfc, 0x20, 0x83,
-  0x0b, 0xa0, 0x14, 0x84, 0x24, 0x4c, 0x7e, 0x0b, 0xa5, 0xfa, 0x48, 0xa9,
-  0x15, 0x20, 0x62, 0x0b, 0x20, 0x8b, 0x0b, 0xa9, 0x14, 0x85, 0x24, 0x20,
-  0x87, 0x0b, 0xa9, 0x01, 0x85, 0xfa, 0x20, 0x14, 0x0a, 0xc6, 0xfa, 0x10,
-  0xf9, 0x68, 0x85, 0xfa, 0x60, 0x20, 0xc0, 0x0c, 0x20, 0xb6, 0x08, 0x68,
-  0x68, 0x18, 0x4c, 0xe6, 0x0c, 0x20, 0x02, 0x0a, 0x20, 0xbf, 0x08, 0xa5,
-  0xf5, 0x29, 0x70, 0x85, 0xfc, 0xa9, 0x00, 0x85, 0xfa, 0x20, 0x5b, 0x08,
-  0x20, 0xda, 0x0b, 0xa9, 0x40, 0x20, 0x9e, 0x0a, 0x20, 0x14, 0x0a, 0x20,
-  0x0c, 0xfd, 0x48, 0xa9, 0x01, 0x20, 0x9e, 0x0a, 0xa6, 0xfa, 0xb5, 0xf5,
-  0x29, 0x8f, 0xa8, 0x68, 0xc9, 0x8d, 0xd0, 0x1f, 0xa9, 0x00, 0x20, 0x9e,
-  0x0a, 0xa5, 0xfa, 0x49, 0x01, 0x85, 0xfa, 0xd0, 0x01, 0x60, 0xaa, 0xb5,
-  0xf5, 0x29, 0x70, 0xc5, 0xfc, 0xf0, 0xcc, 0x85, 0xfc, 0x20, 0x5b, 0x08,
-  0x4c, 0x17, 0x09, 0xc9, 0x9b, 0xf0, 0x9e, 0xc9, 0xa1, 0xd0, 0x05, 0xa9,
-  0xff, 0x85, 0xf5, 0x60, 0xc9, 0xac, 0xf0, 0x04, 0xc9, 0x8b, 0xd0, 0x13,
-  0x98, 0x0a, 0x08, 0x38, 0xe9, 0x02, 0x29, 0x1e, 0x28, 0x6a, 0x29, 0x8f,
-  0x05, 0xfc, 0x95, 0xf5, 0x4c, 0x17, 0x09, 0xc9, 0xa0, 0xf0, 0x04, 0xc9,
-  0x8a, 0xd0, 0x04, 0xc8, 0x98, 0xd0, 0xeb, 0xc9, 0x88, 0xd0, 0x1e, 0x98,
-  0x49, 0x80, 0xa8, 0x05, 0xfc, 0x95, 0xf5, 0x10, 0xe3, 0xa9, 0xf0, 0x18,
-  0x65, 0xfc, 0x29, 0x70, 0x85, 0xfc, 0x98, 0x48, 0x20, 0x5b, 0x08, 0xa6,
-  0xfa, 0x68, 0x4c, 0x72, 0x09, 0xc9, 0x95, 0xd0, 0x0e, 0x98, 0x49, 0x80,
-  0xa8, 0x05, 0xfc, 0x95, 0xf5, 0x30, 0xc1, 0xa9, 0x10, 0xd0, 0xdc, 0xc9,
-  0xe1, 0x90, 0x03, 0x38, 0xe9, 0x20, 0xc9, 0xc1, 0x90, 0x09, 0xc9, 0xc7,
-  0xb0, 0x05, 0x38, 0xe9, 0x07, 0xd0, 0x08, 0xc9, 0xb0, 0x90, 0x11, 0xc9,
-  0xba, 0xb0, 0x0d, 0x29, 0x0f, 0x85, 0xf9, 0x98, 0x29, 0x80, 0x05, 0xf9,
-  0xa8, 0x4c, 0x72, 0x09, 0xc9, 0xc9, 0xf0, 0x02, 0xd0, 0x8e, 0x20, 0x02,
-  0x0a, 0x20, 0xda, 0x0b, 0x20, 0x0c, 0x0c, 0x4c, 0x01, 0x09, 0xc9, 0xff,
-  0xf0, 0x03, 0x4c, 0xda, 0xfd, 0xa9, 0xa1, 0x4c, 0xed, 0xfd, 0x20, 0x58,
-  0xfc, 0xa9, 0x3f, 0x20, 0x6b, 0x0b, 0xa9, 0x17, 0x20, 0x62, 0x0b, 0xa9,
-  0x23, 0x4c, 0x6b, 0x0b, 0xa2, 0x0b, 0xa5, 0xfa, 0xf0, 0x02, 0xa2, 0x1f,
-  0x86, 0x24, 0xa0, 0x15, 0x84, 0x25, 0x20, 0x22, 0xfc, 0xa4, 0xfa, 0xb9,
-  0xf5, 0x00, 0x48, 0x30, 0x04, 0xa0, 0x01, 0xd0, 0x02, 0xa0, 0x02, 0x98,
-  0x20, 0xe3, 0xfd, 0xe6, 0x24, 0x68, 0x29, 0x7f, 0x20, 0xf6, 0x09, 0xc6,
-  0x24, 0x60, 0x85, 0x24, 0xa5, 0xfb, 0x05, 0xfc, 0x48, 0x29, 0x7f, 0x20,
-  0xda, 0xfd, 0xa9, 0xba, 0x20, 0xed, 0xfd, 0xe6, 0x24, 0x68, 0xc5, 0xf5,
-  0xf0, 0x04, 0xc5, 0xf6, 0xd0, 0x04, 0xa9, 0x3f, 0x85, 0x32, 0x20, 0x9e,
-  0x0b, 0xb0, 0x32, 0xad, 0x05, 0x10, 0x30, 0x2d, 0xad, 0x04, 0x10, 0xaa,
-  0x29, 0xf0, 0xc9, 0xf0, 0xd0, 0x23, 0x8a, 0x29, 0x0f, 0xf0, 0x1e, 0x85,
-  0xf9, 0xa2, 0x00, 0xbd, 0x05, 0x10, 0x09, 0x80, 0x20, 0xed, 0xfd, 0xe8,
-  0xe4, 0xf9, 0xd0, 0xf3, 0xe0, 0x0f, 0xd0, 0x01, 0x60, 0xa9, 0xa0, 0x20,
-  0xed, 0xfd, 0xe8, 0xd0, 0xf3, 0xa2, 0x00, 0x4c, 0x92, 0x0b, 0xa6, 0xfa,
-  0xc9, 0x01, 0xd0, 0x0a, 0xa9, 0x80, 0xa4, 0xf5, 0xc4, 0xf6, 0xd0, 0x02,
-  0xa9, 0x00, 0x85, 0xf9, 0xb5, 0xf5, 0x30, 0x04, 0xa0, 0x04, 0xd0, 0x02,
-  0xa0, 0x18, 0x84, 0x24, 0x29, 0x7f, 0x45, 0xfc, 0xc9, 0x10, 0xb0, 0x17,
-  0x69, 0x04, 0x85, 0x25, 0x20, 0x22, 0xfc, 0xa4, 0x24, 0xa2, 0x0f, 0xb1,
-  0x28, 0x29, 0x3f, 0x05, 0xf9, 0x91, 0x28, 0xc8, 0xca, 0xd0, 0xf4, 0x60,
-  0xad, 0xad, 0xad, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0,
-  0xa0, 0xa0, 0xa0, 0x00, 0xc4, 0xd2, 0xc9, 0xd6, 0xc5, 0xa0, 0xb1, 0xba,
-  0xa0, 0xd3, 0xc4, 0xbf, 0xaf, 0x00, 0xd3, 0xc4, 0xb1, 0xba, 0x00, 0x20,
-  0x20, 0x01, 0x10, 0x10, 0x0c, 0x05, 0x20, 0x09, 0x09, 0x20, 0x06, 0x0f,
-  0x12, 0x05, 0x16, 0x05, 0x12, 0x21, 0x20, 0x20, 0x16, 0x33, 0x2e, 0x34,
-  0x2e, 0x32, 0x00, 0x04, 0x01, 0x0e, 0x20, 0x09, 0x09, 0x20, 0x16, 0x0f,
-  0x0c, 0x15, 0x0d, 0x05, 0x20, 0x13, 0x05, 0x0c, 0x05, 0x03, 0x14, 0x0f,
-  0x12, 0x00, 0xa0, 0xcf, 0xcb, 0xa1, 0x00, 0xc5, 0xd2, 0xd2, 0xcf, 0xd2,
-  0xa1, 0x87, 0x87, 0x87, 0x00, 0xc6, 0xd4, 0xd0, 0xaf, 0xc9, 0xd0, 0xba,
-  0xa0, 0x00, 0xce, 0xc5, 0xd7, 0xa0, 0xc9, 0xd0, 0xba, 0xa0, 0xa0, 0xa0,
-  0xa0, 0xae, 0xa0, 0xa0, 0xa0, 0xae, 0xa0, 0xa0, 0xa0, 0xae, 0xa0, 0xa0,
-  0xa0, 0x00, 0x85, 0x25, 0xa9, 0x00, 0x85, 0x24, 0x4c, 0x22, 0xfc, 0x48,
-  0xa2, 0x26, 0xa9, 0x20, 0x20, 0xed, 0xfd, 0xca, 0x10, 0xf8, 0x68, 0xaa,
-  0xa9, 0x08, 0x85, 0x24, 0xd0, 0x14, 0xa9, 0xb2, 0x8d, 0xfc, 0x0a, 0xa2,
-  0x1e, 0xd0, 0x0b, 0xa9, 0xb2, 0xd0, 0x02, 0xa9, 0xb1, 0x8d, 0xf2, 0x0a,
-  0xa2, 0x10, 0xbd, 0xdc, 0x0a, 0xf0, 0x06, 0x20, 0xed, 0xfd, 0xe8, 0xd0,
-  0xf5, 0x60, 0xa0, 0x00, 0x84, 0x47, 0xc8, 0x84, 0x42, 0xc8, 0x84, 0x46,
-  0x4c, 0xb9, 0x0b, 0xa9, 0x07, 0xd0, 0x02, 0xa9, 0x06, 0x85, 0x42, 0xa5,
-  0x47, 0x49, 0x80, 0x85, 0x47, 0xa9, 0x00, 0x85, 0x44, 0xa9, 0x10, 0x85,
-  0x45, 0x4c, 0xf0, 0x00, 0xa9, 0x05, 0x85, 0x42, 0x20, 0xb9, 0x0b, 0xad,
-  0x00, 0x10, 0x85, 0xf7, 0xad, 0x01, 0x10, 0x49, 0x80, 0x85, 0xf8, 0x4c,
-  0xb6, 0x08, 0xa9, 0x21, 0x20, 0xb1, 0x0b, 0xb0, 0xbc, 0xad, 0x10, 0x10,
-  0xf0, 0xb7, 0xa9, 0x01, 0x20, 0x62, 0x0b, 0xa2, 0x09, 0x86, 0x24, 0xa2,
-  0x65, 0x20, 0x92, 0x0b, 0xad, 0x06, 0x10, 0x20, 0xb4, 0x0c, 0xad, 0x07,
-  0x10, 0x20, 0xb4, 0x0c, 0xad, 0x08, 0x10, 0x20, 0xb4, 0x0c, 0xad, 0x09,
-  0x10, 0x4c, 0x13, 0x0d, 0xa5, 0x43, 0x48, 0xa9, 0x0a, 0x20, 0x62, 0x0b,
-  0xa2, 0x6e, 0x20, 0x92, 0x0b, 0xa9, 0x08, 0x85, 0x24, 0x20, 0x54, 0x0c,
-  0xb0, 0xed, 0x85, 0x44, 0xe6, 0x24, 0x20, 0x54, 0x0c, 0xb0, 0xe4, 0x85,
-  0x45, 0xe6, 0x24, 0x20, 0x54, 0x0c, 0xb0, 0xdb, 0x85, 0x46, 0xe6, 0x24,
-  0x20, 0x54, 0x0c, 0xb0, 0xd2, 0x85, 0x47, 0x85, 0x43, 0xa9, 0x20, 0x85,
-  0x42, 0x20, 0xf0, 0x00, 0x18, 0xaa, 0x68, 0x85, 0x43, 0xca, 0xf0, 0x01,
-  0x38, 0x4c, 0xd0, 0x0c, 0xa9, 0x00, 0x85, 0xf9, 0xa2, 0x03, 0x8a, 0x48,
-  0x20, 0x93, 0x0c, 0xb0, 0x17, 0xc9, 0xff, 0xf0, 0x17, 0xa8, 0x20, 0x84,
-  0x0c, 0xb0, 0x0d, 0x98, 0x65, 0xf9, 0x85, 0xf9, 0xb0, 0x06, 0x68, 0xaa,
-  0xca, 0xd0, 0xe3, 0x48, 0x68, 0xa5, 0xf9, 0x60, 0x68, 0x18, 0x65, 0x24,
-  0x85, 0x24, 0x90, 0xf5, 0xa2, 0x0a, 0xa9, 0x00, 0x18, 0x65, 0xf9, 0xb0,
-  0x05, 0xca, 0xd0, 0xf9, 0x85, 0xf9, 0x60, 0x20, 0x0c, 0xfd, 0xc9, 0xa0,
-  0xd0, 0x04, 0xa9, 0xff, 0x18, 0x60, 0xc9, 0x8d, 0xf0, 0xf8, 0xc9, 0xae,
-  0xf0, 0xf4, 0xc9, 0xb0, 0x30, 0xe9, 0xc9, 0xba, 0xb0, 0xe5, 0x20, 0xed,
-  0xfd, 0x29, 0x0f, 0x60, 0x20, 0x13, 0x0d, 0xa9, 0xae, 0x4c, 0xed, 0xfd,
-  0xa9, 0x00, 0xf0, 0x02, 0xa9, 0x80, 0xa2, 0x01, 0x86, 0xfa, 0x48, 0x20,
-  0x9e, 0x0a, 0x68, 0xc6, 0xfa, 0x10, 0xf7, 0x60, 0xa2, 0x56, 0x90, 0x02,
-  0xa2, 0x5b, 0x20, 0x92, 0x0b, 0xa2, 0x06, 0xa9, 0xff, 0x20, 0xa8, 0xfc,
-  0xca, 0xd0, 0xf8, 0x4c, 0x58, 0xfc, 0x08, 0x20, 0xd4, 0x08, 0x20, 0xbc,
-  0x0c, 0xa9, 0x16, 0x20, 0x62, 0x0b, 0xa9, 0x11, 0x85, 0x24, 0x28, 0x20,
-  0xd0, 0x0c, 0xa9, 0x08, 0x48, 0x85, 0x45, 0xa9, 0x00, 0x48, 0x85, 0x44,
-  0x85, 0x46, 0x85, 0x47, 0xa2, 0x01, 0x81, 0x44, 0xa9, 0x0a, 0x85, 0x42,
-  0x6c, 0xf1, 0x00, 0xc9, 0x0a, 0x90, 0x1e, 0xa2, 0x64, 0x86, 0xf9, 0x20,
-  0x38, 0x0d, 0xe0, 0x00, 0xf0, 0x06, 0x48, 0x8a, 0x20, 0xe3, 0xfd, 0x68,
-  0xa2, 0x0a, 0x86, 0xf9, 0x20, 0x38, 0x0d, 0x48, 0x8a, 0x20, 0xe3, 0xfd,
-  0x68, 0x4c, 0xe3, 0xfd, 0xa2, 0x00, 0xc5, 0xf9, 0x90, 0x06, 0xe8, 0x38,
-  0xe5, 0xf9, 0xb0, 0xf6, 0x60
+  0x85, 0xfc, 0x20, 0x93, 0xfe, 0x20, 0x89, 0xfe, 0x20, 0xbe, 0x0b, 0x20,
+  0xa4, 0x08, 0x20, 0xef, 0x08, 0xa5, 0xf5, 0x85, 0x46, 0xa5, 0xf6, 0x85,
+  0x47, 0x20, 0xa5, 0x0b, 0x4c, 0xe0, 0x0c, 0x20, 0xc2, 0x08, 0xa5, 0xfc,
+  0x85, 0x46, 0xa9, 0x10, 0x20, 0x96, 0x0b, 0xa5, 0xfc, 0x09, 0x80, 0x85,
+  0x46, 0xa9, 0x12, 0x20, 0x96, 0x0b, 0xa9, 0x00, 0x85, 0xfb, 0xa9, 0x04,
+  0x85, 0x25, 0x20, 0x22, 0xfc, 0xa9, 0x00, 0x20, 0x30, 0x0a, 0xa9, 0xff,
+  0x85, 0x32, 0xa5, 0xfb, 0x09, 0x80, 0x85, 0xfb, 0xa9, 0x14, 0x20, 0x30,
+  0x0a, 0xa9, 0xff, 0x85, 0x32, 0xe6, 0x25, 0xe6, 0xfb, 0xa5, 0xfb, 0x29,
+  0x7f, 0x85, 0xfb, 0xc9, 0x10, 0x90, 0xd7, 0x60, 0xa5, 0xf7, 0x85, 0xf5,
+  0xa5, 0xf8, 0x85, 0xf6, 0x60, 0xa0, 0x00, 0x84, 0x24, 0xa0, 0x03, 0x84,
+  0x25, 0x20, 0x22, 0xfc, 0x20, 0x7b, 0x0b, 0xa0, 0x14, 0x84, 0x24, 0x4c,
+  0x76, 0x0b, 0xa5, 0xfa, 0x48, 0xa9, 0x15, 0x20, 0x5a, 0x0b, 0x20, 0x83,
+  0x0b, 0xa9, 0x14, 0x85, 0x24, 0x20, 0x7f, 0x0b, 0xa9, 0x01, 0x85, 0xfa,
+  0x20, 0x02, 0x0a, 0xc6, 0xfa, 0x10, 0xf9, 0x68, 0x85, 0xfa, 0x60, 0x20,
+  0xba, 0x0c, 0x20, 0xa4, 0x08, 0x68, 0x68, 0x18, 0x4c, 0xe0, 0x0c, 0x20,
+  0xf0, 0x09, 0x20, 0xad, 0x08, 0xa5, 0xf5, 0x29, 0x70, 0x85, 0xfc, 0xa9,
+  0x00, 0x85, 0xfa, 0x20, 0x5b, 0x08, 0x20, 0xd4, 0x0b, 0xa9, 0x40, 0x20,
+  0x96, 0x0a, 0x20, 0x02, 0x0a, 0x20, 0x0c, 0xfd, 0x48, 0xa9, 0x01, 0x20,
+  0x96, 0x0a, 0xa6, 0xfa, 0xb5, 0xf5, 0x29, 0x8f, 0xa8, 0x68, 0xc9, 0x8d,
+  0xd0, 0x1f, 0xa9, 0x00, 0x20, 0x96, 0x0a, 0xa5, 0xfa, 0x49, 0x01, 0x85,
+  0xfa, 0xd0, 0x01, 0x60, 0xaa, 0xb5, 0xf5, 0x29, 0x70, 0xc5, 0xfc, 0xf0,
+  0xcc, 0x85, 0xfc, 0x20, 0x5b, 0x08, 0x4c, 0x05, 0x09, 0xc9, 0x9b, 0xf0,
+  0x9e, 0xc9, 0xa1, 0xd0, 0x05, 0xa9, 0xff, 0x85, 0xf5, 0x60, 0xc9, 0xac,
+  0xf0, 0x04, 0xc9, 0x8b, 0xd0, 0x13, 0x98, 0x0a, 0x08, 0x38, 0xe9, 0x02,
+  0x29, 0x1e, 0x28, 0x6a, 0x29, 0x8f, 0x05, 0xfc, 0x95, 0xf5, 0x4c, 0x05,
+  0x09, 0xc9, 0xa0, 0xf0, 0x04, 0xc9, 0x8a, 0xd0, 0x04, 0xc8, 0x98, 0xd0,
+  0xeb, 0xc9, 0x88, 0xd0, 0x1e, 0x98, 0x49, 0x80, 0xa8, 0x05, 0xfc, 0x95,
+  0xf5, 0x10, 0xe3, 0xa9, 0xf0, 0x18, 0x65, 0xfc, 0x29, 0x70, 0x85, 0xfc,
+  0x98, 0x48, 0x20, 0x5b, 0x08, 0xa6, 0xfa, 0x68, 0x4c, 0x60, 0x09, 0xc9,
+  0x95, 0xd0, 0x0e, 0x98, 0x49, 0x80, 0xa8, 0x05, 0xfc, 0x95, 0xf5, 0x30,
+  0xc1, 0xa9, 0x10, 0xd0, 0xdc, 0xc9, 0xe1, 0x90, 0x03, 0x38, 0xe9, 0x20,
+  0xc9, 0xc1, 0x90, 0x09, 0xc9, 0xc7, 0xb0, 0x05, 0x38, 0xe9, 0x07, 0xd0,
+  0x08, 0xc9, 0xb0, 0x90, 0x11, 0xc9, 0xba, 0xb0, 0x0d, 0x29, 0x0f, 0x85,
+  0xf9, 0x98, 0x29, 0x80, 0x05, 0xf9, 0xa8, 0x4c, 0x60, 0x09, 0xc9, 0xc9,
+  0xf0, 0x02, 0xd0, 0x8e, 0x20, 0xf0, 0x09, 0x20, 0xd4, 0x0b, 0x20, 0x06,
+  0x0c, 0x4c, 0xef, 0x08, 0xc9, 0xff, 0xf0, 0x03, 0x4c, 0xda, 0xfd, 0xa9,
+  0xa1, 0x4c, 0xed, 0xfd, 0x20, 0x58, 0xfc, 0xa9, 0x3f, 0x20, 0x63, 0x0b,
+  0xa9, 0x17, 0x20, 0x5a, 0x0b, 0xa9, 0x23, 0x4c, 0x63, 0x0b, 0xa2, 0x0b,
+  0xa5, 0xfa, 0xf0, 0x02, 0xa2, 0x1f, 0x86, 0x24, 0xa0, 0x15, 0x84, 0x25,
+  0x20, 0x22, 0xfc, 0xa4, 0xfa, 0xb9, 0xf5, 0x00, 0x48, 0x30, 0x04, 0xa0,
+  0x01, 0xd0, 0x02, 0xa0, 0x02, 0x98, 0x20, 0xe3, 0xfd, 0xe6, 0x24, 0x68,
+  0x29, 0x7f, 0x20, 0xe4, 0x09, 0xc6, 0x24, 0x60, 0x85, 0x24, 0xa5, 0xfb,
+  0x05, 0xfc, 0x48, 0x29, 0x7f, 0x20, 0xda, 0xfd, 0xa9, 0xba, 0x20, 0xed,
+  0xfd, 0xe6, 0x24, 0x68, 0xc5, 0xf5, 0xf0, 0x04, 0xc5, 0xf6, 0xd0, 0x04,
+  0xa9, 0x3f, 0x85, 0x32, 0xa5, 0xfb, 0xa2, 0x10, 0x0a, 0x90, 0x02, 0xe8,
+  0xe8, 0x0a, 0x0a, 0x0a, 0x0a, 0x90, 0x01, 0xe8, 0x85, 0x44, 0x86, 0x45,
+  0xa0, 0x01, 0xb1, 0x44, 0x4a, 0x90, 0x26, 0xa0, 0x04, 0xb1, 0x44, 0x29,
+  0x0f, 0xf0, 0x1e, 0x85, 0xf9, 0xa2, 0x00, 0xc8, 0xb1, 0x44, 0x09, 0x80,
+  0x20, 0xed, 0xfd, 0xe8, 0xe4, 0xf9, 0xd0, 0xf3, 0xe0, 0x0f, 0xd0, 0x01,
+  0x60, 0xa9, 0xa0, 0x20, 0xed, 0xfd, 0xe8, 0xd0, 0xf3, 0xa2, 0x00, 0x4c,
+  0x8a, 0x0b, 0xa6, 0xfa, 0xc9, 0x01, 0xd0, 0x0a, 0xa9, 0x80, 0xa4, 0xf5,
+  0xc4, 0xf6, 0xd0, 0x02, 0xa9, 0x00, 0x85, 0xf9, 0xb5, 0xf5, 0x30, 0x04,
+  0xa0, 0x04, 0xd0, 0x02, 0xa0, 0x18, 0x84, 0x24, 0x29, 0x7f, 0x45, 0xfc,
+  0xc9, 0x10, 0xb0, 0x17, 0x69, 0x04, 0x85, 0x25, 0x20, 0x22, 0xfc, 0xa4,
+  0x24, 0xa2, 0x0f, 0xb1, 0x28, 0x29, 0x3f, 0x05, 0xf9, 0x91, 0x28, 0xc8,
+  0xca, 0xd0, 0xf4, 0x60, 0xad, 0xad, 0xad, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0,
+  0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0x00, 0xc4, 0xd2, 0xc9, 0xd6,
+  0xc5, 0xa0, 0xb1, 0xba, 0xa0, 0xd3, 0xc4, 0xbf, 0xaf, 0x00, 0xd3, 0xc4,
+  0xb1, 0xba, 0x00, 0x20, 0x20, 0x01, 0x10, 0x10, 0x0c, 0x05, 0x20, 0x09,
+  0x09, 0x20, 0x06, 0x0f, 0x12, 0x05, 0x16, 0x05, 0x12, 0x21, 0x20, 0x20,
+  0x16, 0x33, 0x2e, 0x34, 0x2e, 0x32, 0x00, 0x04, 0x01, 0x0e, 0x20, 0x09,
+  0x09, 0x20, 0x16, 0x0f, 0x0c, 0x15, 0x0d, 0x05, 0x20, 0x13, 0x05, 0x0c,
+  0x05, 0x03, 0x14, 0x0f, 0x12, 0x00, 0xa0, 0xcf, 0xcb, 0xa1, 0x00, 0xc5,
+  0xd2, 0xd2, 0xcf, 0xd2, 0xa1, 0x87, 0x87, 0x87, 0x00, 0xc6, 0xd4, 0xd0,
+  0xaf, 0xc9, 0xd0, 0xba, 0xa0, 0x00, 0xce, 0xc5, 0xd7, 0xa0, 0xc9, 0xd0,
+  0xba, 0xa0, 0xa0, 0xa0, 0xa0, 0xae, 0xa0, 0xa0, 0xa0, 0xae, 0xa0, 0xa0,
+  0xa0, 0xae, 0xa0, 0xa0, 0xa0, 0x00, 0x85, 0x25, 0xa9, 0x00, 0x85, 0x24,
+  0x4c, 0x22, 0xfc, 0x48, 0xa2, 0x26, 0xa9, 0x20, 0x20, 0xed, 0xfd, 0xca,
+  0x10, 0xf8, 0x68, 0xaa, 0xa9, 0x08, 0x85, 0x24, 0xd0, 0x14, 0xa9, 0xb2,
+  0x8d, 0xf4, 0x0a, 0xa2, 0x1e, 0xd0, 0x0b, 0xa9, 0xb2, 0xd0, 0x02, 0xa9,
+  0xb1, 0x8d, 0xea, 0x0a, 0xa2, 0x10, 0xbd, 0xd4, 0x0a, 0xf0, 0x06, 0x20,
+  0xed, 0xfd, 0xe8, 0xd0, 0xf5, 0x60, 0x85, 0x45, 0xa9, 0x00, 0x85, 0x44,
+  0x85, 0x47, 0xa9, 0x31, 0x85, 0x42, 0x4c, 0xf0, 0x00, 0xa9, 0x07, 0xd0,
+  0x02, 0xa9, 0x06, 0x85, 0x42, 0xa5, 0x47, 0x49, 0x80, 0x85, 0x47, 0xa9,
+  0x00, 0x85, 0x44, 0xa9, 0x10, 0x85, 0x45, 0x4c, 0xf0, 0x00, 0xa9, 0x05,
+  0x85, 0x42, 0x20, 0xb3, 0x0b, 0xad, 0x00, 0x10, 0x85, 0xf7, 0xad, 0x01,
+  0x10, 0x49, 0x80, 0x85, 0xf8, 0x4c, 0xa4, 0x08, 0xa9, 0x21, 0x20, 0xab,
+  0x0b, 0xb0, 0xba, 0xad, 0x10, 0x10, 0xf0, 0xb5, 0xa9, 0x01, 0x20, 0x5a,
+  0x0b, 0xa2, 0x09, 0x86, 0x24, 0xa2, 0x65, 0x20, 0x8a, 0x0b, 0xad, 0x06,
+  0x10, 0x20, 0xae, 0x0c, 0xad, 0x07, 0x10, 0x20, 0xae, 0x0c, 0xad, 0x08,
+  0x10, 0x20, 0xae, 0x0c, 0xad, 0x09, 0x10, 0x4c, 0x0d, 0x0d, 0xa5, 0x43,
+  0x48, 0xa9, 0x0a, 0x20, 0x5a, 0x0b, 0xa2, 0x6e, 0x20, 0x8a, 0x0b, 0xa9,
+  0x08, 0x85, 0x24, 0x20, 0x4e, 0x0c, 0xb0, 0xed, 0x85, 0x44, 0xe6, 0x24,
+  0x20, 0x4e, 0x0c, 0xb0, 0xe4, 0x85, 0x45, 0xe6, 0x24, 0x20, 0x4e, 0x0c,
+  0xb0, 0xdb, 0x85, 0x46, 0xe6, 0x24, 0x20, 0x4e, 0x0c, 0xb0, 0xd2, 0x85,
+  0x47, 0x85, 0x43, 0xa9, 0x20, 0x85, 0x42, 0x20, 0xf0, 0x00, 0x18, 0xaa,
+  0x68, 0x85, 0x43, 0xca, 0xf0, 0x01, 0x38, 0x4c, 0xca, 0x0c, 0xa9, 0x00,
+  0x85, 0xf9, 0xa2, 0x03, 0x8a, 0x48, 0x20, 0x8d, 0x0c, 0xb0, 0x17, 0xc9,
+  0xff, 0xf0, 0x17, 0xa8, 0x20, 0x7e, 0x0c, 0xb0, 0x0d, 0x98, 0x65, 0xf9,
+  0x85, 0xf9, 0xb0, 0x06, 0x68, 0xaa, 0xca, 0xd0, 0xe3, 0x48, 0x68, 0xa5,
+  0xf9, 0x60, 0x68, 0x18, 0x65, 0x24, 0x85, 0x24, 0x90, 0xf5, 0xa2, 0x0a,
+  0xa9, 0x00, 0x18, 0x65, 0xf9, 0xb0, 0x05, 0xca, 0xd0, 0xf9, 0x85, 0xf9,
+  0x60, 0x20, 0x0c, 0xfd, 0xc9, 0xa0, 0xd0, 0x04, 0xa9, 0xff, 0x18, 0x60,
+  0xc9, 0x8d, 0xf0, 0xf8, 0xc9, 0xae, 0xf0, 0xf4, 0xc9, 0xb0, 0x30, 0xe9,
+  0xc9, 0xba, 0xb0, 0xe5, 0x20, 0xed, 0xfd, 0x29, 0x0f, 0x60, 0x20, 0x0d,
+  0x0d, 0xa9, 0xae, 0x4c, 0xed, 0xfd, 0xa9, 0x00, 0xf0, 0x02, 0xa9, 0x80,
+  0xa2, 0x01, 0x86, 0xfa, 0x48, 0x20, 0x96, 0x0a, 0x68, 0xc6, 0xfa, 0x10,
+  0xf7, 0x60, 0xa2, 0x56, 0x90, 0x02, 0xa2, 0x5b, 0x20, 0x8a, 0x0b, 0xa2,
+  0x06, 0xa9, 0xff, 0x20, 0xa8, 0xfc, 0xca, 0xd0, 0xf8, 0x4c, 0x58, 0xfc,
+  0x08, 0x20, 0xc2, 0x08, 0x20, 0xb6, 0x0c, 0xa9, 0x16, 0x20, 0x5a, 0x0b,
+  0xa9, 0x11, 0x85, 0x24, 0x28, 0x20, 0xca, 0x0c, 0xa9, 0x08, 0x48, 0x85,
+  0x45, 0xa9, 0x00, 0x48, 0x85, 0x44, 0x85, 0x46, 0x85, 0x47, 0xa2, 0x01,
+  0x81, 0x44, 0xa9, 0x0a, 0x85, 0x42, 0x6c, 0xf1, 0x00, 0xc9, 0x0a, 0x90,
+  0x1e, 0xa2, 0x64, 0x86, 0xf9, 0x20, 0x32, 0x0d, 0xe0, 0x00, 0xf0, 0x06,
+  0x48, 0x8a, 0x20, 0xe3, 0xfd, 0x68, 0xa2, 0x0a, 0x86, 0xf9, 0x20, 0x32,
+  0x0d, 0x48, 0x8a, 0x20, 0xe3, 0xfd, 0x68, 0x4c, 0xe3, 0xfd, 0xa2, 0x00,
+  0xc5, 0xf9, 0x90, 0x06, 0xe8, 0x38, 0xe5, 0xf9, 0xb0, 0xf6, 0x60
 };
 
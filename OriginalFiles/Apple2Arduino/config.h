@@ -1,9 +1,13 @@
 /* DAN][ configuration */
 
+#ifndef _CONFIG_H
+#define _CONFIG_H
+
 /**********************************************************************************
  MAIN FEATURES
  *********************************************************************************/
 #define USE_ETHERNET     // enable 6502 Ethernet support (IP forwarding / IP65)
+#define USE_ETHERNET_SOCKETS // enable 6502 access to the WIZnet's TCP/UDP sockets (ATmega644P only)
 #define USE_FTP          // enable FTP support (integrated FTP server, independent of IP65)
 #define USE_FAT_DISK     // enable FAT support
 #define USE_RAW_DISK     // enable raw disk support
@@ -62,8 +66,47 @@
 // Maximum number of VOLxx.PO files supported by FTP (usually 128 for VOL00.PO - VOL7F.PO)
 #define FTP_MAX_VOL_FILES 128
 
+// Keep the FAT file systems of both SD cards mounted simultaneously, instead of remounting when
+// switching between the cards. Only used for the ATmega644P, the ATmega328P does not have enough
+// RAM for a second file system (about 560 bytes).
+#define USE_DUAL_MOUNT
+
+// Number of 512 byte blocks kept in a write-through cache for frequently accessed ProDOS blocks
+// (volume directory, bitmap...). Only used for the ATmega644P, the ATmega328P does not have enough
+// RAM. Set to 0 to disable the cache (or reduce the cache size to make room for other features).
+#define BLOCK_CACHE_SIZE 2
+
+// Read the block following the most recently read block into the block cache, while the Apple II
+// is busy processing the data (requires the block cache, so ATmega644P only).
+#define USE_READ_AHEAD
+
+// Support a deferred write-back mode: written blocks are only stored in the block cache and are
+// written to disk while the Apple II is idle (requires the block cache, so ATmega644P only).
+// The mode also needs to be enabled at run-time (command 0x0F, stored in EEPROM).
+#define USE_WRITE_BACK
+
+// Number of bytes reserved for a catalog of the ProDOS volume names and sizes, which is built by the first FTP
+// directory listing. Further listings do not need to open the cataloged volume files and read their headers (again).
+// Each ProDOS volume needs 4 bytes plus its name length (9 bytes for "VOL01"), volumes which do not fit are read from
+// disk on every listing: the default size only holds about 19 volumes, 128 volumes with 15 character names need 2.4KB.
+// Only used for the ATmega644P. Set to 0 to disable the catalog.
+#define VOL_CATALOG_SIZE 256
+
+// Record the most recent Apple II commands (command, unit, block, status, duration) in a trace buffer
+// with TRACE_ENTRIES entries (10 bytes each). The FTP server offers the trace as the read-only file
+// "TRACE.BIN" in its root directory (decode with hostsim/dan2trace.py). Only used for the ATmega644P.
+// Set to 0 to disable the trace.
+#define TRACE_ENTRIES 24
+
+// Filter received Ethernet frames on the card (MACRAW mode, configured by the 6502 with command 0x14): frames for
+// other MAC addresses, multicasts, ARP for other hosts, other EtherTypes or TCP/UDP ports are dropped in the WIZnet's
+// buffer, instead of being copied to the Apple II. Only used for the ATmega644P.
+#define USE_ETHERNET_FILTER
+
 // Enable/disable the use of the customized Ethernet library. This library saves a lot of
 // space, removes some workarounds which are not needed for the DAN][ card. The customized
 // library should normally be enabled. Otherwise the stock Arduino library is used - which
 // should only be done for reference/comparisons.
 #define FEATURE_CUSTOM_ETHERNET_LIBRARY
+
+#endif /* _CONFIG_H */
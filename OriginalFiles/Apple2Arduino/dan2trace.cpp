@@ -0,0 +1,113 @@
+/* dan2trace.cpp - trace of the Apple II commands, for analyzing ProDOS access patterns.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dan2trace.h"
+
+#ifdef USE_TRACE
+
+trace_entry_t trace_buf[TRACE_ENTRIES]; // ring buffer with the most recent commands
+uint8_t       trace_next;               // entry of the current command (the oldest entry when idle)
+uint8_t       trace_status;             // status byte of the current command was not sent yet
+static uint8_t  trace_used;             // number of valid entries (stops at TRACE_ENTRIES)
+static uint16_t trace_count;            // number of commands traced since power-up (wraps)
+static uint32_t trace_start_us;         // start time of the current command
+
+// called when a command byte was received
+void trace_start(uint8_t cmd)
+{
+  trace_entry_t* e = &trace_buf[trace_next];
+  trace_start_us = micros();
+  e->time     = millis();
+  e->cmd      = cmd;
+  e->unit     = 0;
+  e->blk      = 0;
+  e->count    = 0;
+  e->result   = 0; // streamed blocks don't send the (zero) status byte with write_dataport
+  trace_status = 1;
+}
+
+// called when the parameters of a command were received
+void trace_params(uint8_t unit, uint16_t bufaddr, uint16_t blk)
+{
+  trace_entry_t* e = &trace_buf[trace_next];
+  e->unit  = unit;
+  e->count = bufaddr & 0xff;
+  e->blk   = blk;
+}
+
+// called when a command is complete
+void trace_end(void)
+{
+  uint32_t ticks = (micros() - trace_start_us) / TRACE_TICK_US;
+  trace_buf[trace_next].duration = (ticks > 0xffff) ? 0xffff : ticks;
+  if (++trace_next >= TRACE_ENTRIES)
+    trace_next = 0;
+  if (trace_used < TRACE_ENTRIES)
+    trace_used++;
+  trace_count++;
+  trace_status = 0;
+}
+
+// size of the trace file
+uint16_t trace_size(void)
+{
+  return TRACE_HEADER_SIZE + trace_used*sizeof(trace_entry_t);
+}
+
+// copy a part of the trace file to the given buffer, returns the number of bytes
+uint16_t trace_read(uint8_t* buf, uint16_t offset, uint16_t size)
+{
+  uint16_t filesize = trace_size();
+  uint16_t entries  = (filesize - TRACE_HEADER_SIZE) / sizeof(trace_entry_t);
+  uint8_t  oldest   = (trace_used < TRACE_ENTRIES) ? 0 : trace_next;
+  uint8_t  header[TRACE_HEADER_SIZE];
+  uint32_t now = millis();
+
+  memcpy(header, TRACE_MAGIC, 4);
+  header[4]  = TRACE_VERSION;
+  header[5]  = sizeof(trace_entry_t);
+  header[6]  = TRACE_TICK_US;
+  header[7]  = 0;
+  header[8]  = entries & 0xff;
+  header[9]  = entries >> 8;
+  header[10] = trace_count & 0xff;
+  header[11] = trace_count >> 8;
+  for (uint8_t i=0;i<4;i++)
+    header[12+i] = now >> (8*i);
+
+  uint16_t sz = 0;
+  while ((sz < size)&&(offset < filesize))
+  {
+    if (offset < TRACE_HEADER_SIZE)
+      buf[sz] = header[offset];
+    else
+    {
+      uint16_t pos   = offset - TRACE_HEADER_SIZE;
+      uint8_t  entry = (oldest + pos / sizeof(trace_entry_t)) % TRACE_ENTRIES;
+      buf[sz] = ((uint8_t*) &trace_buf[entry])[pos % sizeof(trace_entry_t)];
+    }
+    sz++;
+    offset++;
+  }
+  return sz;
+}
+
+#endif
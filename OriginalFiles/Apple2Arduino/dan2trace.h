@@ -0,0 +1,81 @@
+/* dan2trace.h - trace of the Apple II commands, for analyzing ProDOS access patterns.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+// the trace buffer needs more RAM than the ATmega328P has
+#if defined(__AVR_ATmega644P__) && defined(TRACE_ENTRIES) && (TRACE_ENTRIES > 0)
+  #define USE_TRACE
+#endif
+
+/* Format of the trace file (/TRACE.BIN on the FTP server, all values little-endian):
+    Offset   Usage
+    0x00     Magic "DTRC"
+    0x04     Format version (1)
+    0x05     Size of a trace entry in bytes (10)
+    0x06     Timer tick of the command durations in microseconds (4)
+    0x07     reserved (0)
+    0x08     Number of trace entries in the file (16bit)
+    0x0A     Number of commands traced since power-up (16bit, wraps)
+    0x0C     Time when the file was read: milliseconds since power-up (32bit)
+    0x10     Trace entries, the oldest first (see trace_entry_t)
+*/
+#define TRACE_MAGIC        "DTRC"
+#define TRACE_VERSION      1
+#define TRACE_TICK_US      4
+#define TRACE_HEADER_SIZE  16
+
+typedef struct {
+  uint16_t time;      // start of the command: milliseconds since power-up (16bit, wraps)
+  uint16_t duration;  // duration of the command in timer ticks (0xffff: or longer)
+  uint8_t  cmd;       // command code (see do_command)
+  uint8_t  unit;      // ProDOS unit (commands without parameters: 0)
+  uint16_t blk;       // block number
+  uint8_t  count;     // low byte of the buffer address: block count of commands 0x0C/0x0D
+  uint8_t  result;    // first status byte sent to the Apple II
+} trace_entry_t;
+
+#ifdef USE_TRACE
+#define TRACE_FILE_SIZE    (TRACE_HEADER_SIZE + TRACE_ENTRIES*sizeof(trace_entry_t))
+
+extern trace_entry_t trace_buf[TRACE_ENTRIES];
+extern uint8_t       trace_next;    // entry of the current command
+extern uint8_t       trace_status;  // status byte of the current command was not sent yet
+
+void     trace_start (uint8_t cmd);
+void     trace_params(uint8_t unit, uint16_t bufaddr, uint16_t blk);
+void     trace_end   (void);
+uint16_t trace_size  (void);
+uint16_t trace_read  (uint8_t* buf, uint16_t offset, uint16_t size);
+
+// the first byte sent to the Apple II is the command's status (called for every write_dataport)
+static inline void trace_result(uint8_t result)
+{
+  if (trace_status)
+  {
+    trace_status = 0;
+    trace_buf[trace_next].result = result;
+  }
+}
+#endif
@@ -29,17 +29,51 @@
 #define INVALID_FILENUM 254
 
 request_t request;               // the slot/file/volume which is requested for access
+uint8_t   unit;                  // the ProDOS unit number of the current Apple II command
+uint8_t   drive_fileno[2];       // the SD card and file mapped to drive 1 and 2 (bit 7: SD card)
+uint8_t   a2slot;                // the Apple II slot of the DAN][ card
+#ifdef USE_DUAL_MOUNT
+FATFS     vol_fs[2];             // the FATFS of both SD cards, which are mounted simultaneously
+#define   VOL_FS(sdslot) (&vol_fs[sdslot])
+#else
 FATFS     current_fs;            // the FATFS which is currently mounted
-FIL       current_file;          // the FAT file which is currently mounted
+#define   VOL_FS(sdslot) (&current_fs)
+#endif
+uint16_t  vol_mounts;            // statistics: number of FAT mount operations
+FIL*      current_file;          // the FAT file which is currently accessed
 uint8_t   current_filenum = INVALID_FILENUM; // the file number which is currently accessed (FAT or RAW)
+FIL       vol_files[VOL_OPEN_FILES];    // FAT files kept open simultaneously (for the currently mounted FATFS)
+uint8_t   vol_filenums[VOL_OPEN_FILES]; // file numbers of the open FAT files
+uint8_t   vol_files_lastuse[VOL_OPEN_FILES]; // file clock of the most recent access (to close the least recently used file)
+uint8_t   vol_files_clock;       // incremented with every file switch
+LBA_t     vol_files_lba[VOL_OPEN_FILES];   // start sectors of the open FAT files, when contiguous (0: fragmented)
+uint16_t  vol_files_frags[VOL_OPEN_FILES]; // number of fragments of the open FAT files (0: unknown)
+LBA_t     current_lba;           // start sector of the current FAT file, when contiguous (0: access through FatFs)
 int8_t    slot_type[2]  = {SLOT_TYPE_UNKNOWN, SLOT_TYPE_UNKNOWN}; // the detected disk format (RAW/FAT/nothing)
 uint8_t   max_volumes[2];        // maximum allowed number of volumes for each SD card (depends on disk size)
 
+uint8_t   vol_xfer_blocks;       // multi-block transfer: number of blocks still to be transferred
+UINT      vol_xfer_sectors;      // multi-block transfer: remaining sectors of the current (contiguous) SD card transfer
+bool      vol_xfer_preerase;     // multi-block write: the SD card may pre-erase the sectors (the write is never stopped early)
+
 char vol_filename[] = "X:BLKDEVXX.PO"; // the currently mounted drive (and file)
 uint8_t vol_filename_length = 11; // we can switch the vol_filename template to "X:VOLxx.PO" and shorten the name
 
 #define FILE_VALID(file) ((file)->obj.fs != NULL) // check if the FS object is valid
 
+#ifdef USE_FAT_DISK
+// close all open FAT files
+static void vol_close_files(void)
+{
+  for (uint8_t i=0;i<VOL_OPEN_FILES;i++)
+  {
+    if (FILE_VALID(&vol_files[i]))
+      f_close(&vol_files[i]);
+  }
+  current_filenum = INVALID_FILENUM;
+}
+#endif
+
 // map number 0-$F to single hex character
 uint8_t hex_digit(uint8_t ch)
 {
@@ -52,28 +86,105 @@ uint8_t hex_digit(uint8_t ch)
 bool vol_mount(void)
 {
   char sdslot = request.sdslot+'0';  // map to alphanum character
+#ifdef USE_DUAL_MOUNT
+  // both SD cards stay mounted: just select the drive
+  if (vol_filename[0] != sdslot)
+  {
+    current_filenum = INVALID_FILENUM;
+    vol_filename[0] = sdslot;
+  }
+  if (vol_fs[request.sdslot].fs_type == 0) // not mounted yet?
+  {
+    vol_mounts++;
+    if (f_mount(&vol_fs[request.sdslot], vol_filename, 1) != FR_OK) // this only mounts the volume, ignores the filename
+      return false;
+  }
+#else
   if (vol_filename[0] != sdslot)     // already mounted?
   {
     if (vol_filename[0] != 'X')      // anything else mounted?
     {
-      if (FILE_VALID(&current_file)) // any open file?
-      {
-        f_close(&current_file);
-      }
+      vol_close_files();             // close any open files
       f_unmount(vol_filename);       // unmount the volume (ignores the filename)
     }
     current_filenum = INVALID_FILENUM;
     vol_filename[0] = sdslot;
+    vol_mounts++;
     if (f_mount(&current_fs, vol_filename, 1) != FR_OK) // this only mounts the volume, ignores the filename
     {
       vol_filename[0] = 'X';         // invalidate current drive
       return false;
     }
   }
+#endif
   return true;
 }
 #endif
 
+// take care of special mapping in "ALLVOLS" mode
+void calculate_allvols()
+{
+  uint8_t drive  = (unit >> 7); // access drive 0 or drive 1?
+
+  uint8_t drive1fno = drive_fileno[0];
+  uint8_t drive2fno = drive_fileno[1]^0x80;
+
+  if (drive1fno == drive2fno)
+  {
+    // multiple drive access disabled when both are configured to the same volume
+    request.filenum = request.sdslot = 0xff;
+    return;
+  }
+
+  request.filenum  = ((drive==0) ? drive1fno : drive2fno) & 0x80; // map to the SD card to SD card of drive 1 or drive 2
+  request.filenum |= ((unit>>4) & 0x7); // requested file number according to request slot
+
+  if ((drive==1)&&(((drive1fno ^ drive2fno)&0x80) == 0))
+  {
+    // D2 requested, and both drives are configured to the same SD card = "wide access"
+    request.filenum |= 0x8;
+  }
+
+  // now some checks to avoid mapping the same drive multiple times
+  if ((request.filenum == drive1fno)||(request.filenum == drive2fno))
+  {
+    request.filenum &= 0x88; // try volume 0 or 8 instead (on current SDcard)
+  }
+
+  if ((request.filenum == drive1fno)||(request.filenum == drive2fno))
+  {
+    // still in conflict? Then don't map any drive for this request...
+    request.filenum = request.sdslot = 0xff;
+    return;
+  }
+
+  // success: properly decode SDcard and file
+  request.sdslot   = (request.filenum >> 7) & 0x1;
+  request.filenum &= 0xF;
+}
+
+// calculate: sdslot and filenum
+void calculate_sd_filenum()
+{
+  uint8_t drive  = (unit >> 7); // access drive 0 or drive 1?
+
+  if ((drive == 1)&&(drive_fileno[0] == (drive_fileno[1]^0x80)))
+  {
+    // multiple drive access disabled when both are configured to the same volume
+    request.filenum = request.sdslot = 0xff;
+    return;
+  }
+
+  request.filenum = drive_fileno[drive];            // which file to access on this drive by default?
+  request.sdslot  = (request.filenum >> 7) ^ drive; // on SD slot 0 or 1?
+  request.filenum &= 0x7f;                          // mask file number (get rid of slot selection bit)
+
+  // check if the request was received with the "normal" slot number (otherwise the "ALLVOLS" magic is active)
+  uint8_t current_slot = (unit >> 4) & 7;
+  if (current_slot != a2slot)
+    calculate_allvols();
+}
+
 // determine the SD card format (RAW/FAT/nothing)
 void vol_check_sdslot_type(void)
 {
@@ -109,15 +220,16 @@ void vol_check_sdslot_type(void)
 
 #ifdef USE_RAW_DISK
       // It's not a FAT disk. But is it raw/ProDOS disk?
-      current_fs.winsect = -1; // invalidate sector window
-      if (disk_read(request.sdslot, current_fs.win, 2, 1) != 0) // read sector 2 with ProDOS header of volume 1
+      FATFS* fs = VOL_FS(request.sdslot);
+      fs->winsect = -1; // invalidate sector window
+      if (disk_read(request.sdslot, fs->win, 2, 1) != 0) // read sector 2 with ProDOS header of volume 1
       {
         // no disk or invalid format
         return;
       }
 
-      if ((current_fs.win[4]<=0xf0)&& // check key block (with valid volume name)
-          (0x0D27 != *((uint16_t*)&current_fs.win[0x23]))) // check entry length/entries per block=$27/$0D
+      if ((fs->win[4]<=0xf0)&& // check key block (with valid volume name)
+          (0x0D27 != *((uint16_t*)&fs->win[0x23]))) // check entry length/entries per block=$27/$0D
       {
         return;
       }
@@ -161,23 +273,55 @@ bool vol_open_drive_file(void)
     return false;
   }
 
-  // file already open?
+  // file already accessed?
   if (current_filenum == request.filenum)
     return true;
 
-  if (FILE_VALID(&current_file)) // any open file?
+  // file already open?
+  uint8_t f;
+  for (f=0;f<VOL_OPEN_FILES;f++)
   {
-    f_close(&current_file);
-    current_filenum = INVALID_FILENUM;
+    if ((vol_files[f].obj.fs == VOL_FS(request.sdslot))&&(vol_filenums[f] == request.filenum))
+    {
+      current_file    = &vol_files[f];
+      current_filenum = request.filenum;
+      current_lba     = vol_files_lba[f];
+      vol_files_lastuse[f] = ++vol_files_clock;
+      return true;
+    }
+  }
+
+  // replace a closed or the least recently used file
+  f = 0;
+  for (uint8_t i=1;(i<VOL_OPEN_FILES)&&(FILE_VALID(&vol_files[f]));i++)
+  {
+    if ((!FILE_VALID(&vol_files[i]))||
+        ((uint8_t)(vol_files_clock - vol_files_lastuse[i]) > (uint8_t)(vol_files_clock - vol_files_lastuse[f])))
+      f = i;
+  }
+  current_file = &vol_files[f];
+  vol_files_lastuse[f] = ++vol_files_clock;
+
+  current_filenum = INVALID_FILENUM;
+  if (FILE_VALID(current_file)) // close the replaced file
+  {
+    f_close(current_file);
   }
 
   // open file
   vol_filename[vol_filename_length  ] = hex_digit(request.filenum >> 4);
   vol_filename[vol_filename_length+1] = hex_digit(request.filenum & 0x0F);
 
-  if (f_open(&current_file, vol_filename, FA_READ | FA_WRITE) == FR_OK)
+  if (f_open(current_file, vol_filename, FA_READ | FA_WRITE) == FR_OK)
   {
+    // contiguous files are accessed directly, bypassing FatFs
+    if (f_getextents(current_file, &vol_files_lba[f], &vol_files_frags[f]) != FR_OK)
+      vol_files_frags[f] = 0;
+    if (vol_files_frags[f] != 1)
+      vol_files_lba[f] = 0;
+    vol_filenums[f] = request.filenum;
     current_filenum = request.filenum;
+    current_lba     = vol_files_lba[f];
     return true;
   }
 #endif
@@ -185,25 +329,71 @@ bool vol_open_drive_file(void)
   return false;
 }
 
-// read a block from disk or from the boot program area, returns 0=OK
-uint8_t vol_read_block(uint8_t* buf)
+// map request.blk to the SD card sector and the number of contiguous sectors which can be accessed
+// in one go (up to 'count'): returns 0=OK or PRODOS error code
+static uint8_t vol_map_sectors(LBA_t* sector, UINT* count)
+{
+#ifdef USE_RAW_DISK
+  if (slot_type[request.sdslot] == SLOT_TYPE_RAW)
+  {
+    *sector = request.filenum;
+    *sector <<= 16;
+    *sector |= request.blk;
+    // RAW volumes are always contiguous
+    return PRODOS_OK;
+  }
+#endif
+#ifdef USE_FAT_DISK
+  // convert blocks to bytes
+  uint32_t FileOffset = request.blk;
+  FileOffset <<= 9;
+
+  // never access beyond the current file size (seeking beyond the file size would enlarge the file)
+  if (FileOffset >= f_size(current_file))
+    return PRODOS_IO_ERR;
+
+  // contiguous file: translate directly, without following the cluster chain
+  if (current_lba)
+  {
+    uint32_t FileSectors = (f_size(current_file) - FileOffset) >> 9;
+    *sector = current_lba + request.blk;
+    if (*count > FileSectors)
+      *count = FileSectors;
+    return (*count) ? PRODOS_OK : PRODOS_IO_ERR;
+  }
+
+  // only seek when necessary
+  if ((f_tell(current_file) != FileOffset)&&(f_lseek(current_file, FileOffset) != FR_OK))
+    return PRODOS_IO_ERR;
+
+  // get physical sector and check how many sectors of the file are contiguous
+  if (f_getlba(current_file, sector, count) != FR_OK)
+    return PRODOS_IO_ERR;
+
+  return PRODOS_OK;
+#else
+  return PRODOS_NODEV_ERR;
+#endif
+}
+
+// read a block from disk, returns 0=OK
+static uint8_t vol_read_disk_block(uint8_t* buf)
 {
   if (!vol_open_drive_file())
     return PRODOS_NODEV_ERR;
 
-#ifdef USE_RAW_DISK
-  if (slot_type[request.sdslot] == SLOT_TYPE_RAW)
+  // RAW volumes and contiguous FAT files are accessed directly
+  if ((slot_type[request.sdslot] == SLOT_TYPE_RAW)||(current_lba))
   {
-      uint32_t sector = request.filenum;
-      sector <<= 16;
-      sector |= request.blk;
-      if (disk_read(request.sdslot, buf, sector, 1) != RES_OK)
-      {
-        return PRODOS_IO_ERR;
-      }
+    LBA_t sector;
+    UINT  count = 1;
+    if ((vol_map_sectors(&sector, &count) != PRODOS_OK)||
+        (disk_read(request.sdslot, buf, sector, 1) != RES_OK))
+    {
+      return PRODOS_IO_ERR;
+    }
   }
   else
-#endif
 #ifdef USE_FAT_DISK
   {
     UINT br;
@@ -212,11 +402,11 @@ uint8_t vol_read_block(uint8_t* buf)
     uint32_t FileOffset = request.blk;
     FileOffset <<= 9;
     // only seek when necessary
-    if ((f_tell(&current_file) != FileOffset)&&(f_lseek(&current_file, FileOffset) != FR_OK))
+    if ((f_tell(current_file) != FileOffset)&&(f_lseek(current_file, FileOffset) != FR_OK))
     {
       return PRODOS_IO_ERR;
     }
-    if ((f_read(&current_file, buf, 512, &br) != FR_OK) ||
+    if ((f_read(current_file, buf, 512, &br) != FR_OK) ||
         (br != 512))
     {
       return PRODOS_IO_ERR;
@@ -232,23 +422,22 @@ uint8_t vol_read_block(uint8_t* buf)
 }
 
 // write a block to disk: returns 0=OK or PRODOS error code
-uint8_t vol_write_block(uint8_t* buf)
+static uint8_t vol_write_disk_block(uint8_t* buf)
 {
   UINT br;
   if (!vol_open_drive_file())
     return PRODOS_NODEV_ERR;
 
-#ifdef USE_RAW_DISK
-  if (slot_type[request.sdslot] == SLOT_TYPE_RAW)
+  // RAW volumes and contiguous FAT files are accessed directly
+  if ((slot_type[request.sdslot] == SLOT_TYPE_RAW)||(current_lba))
   {
-    uint32_t sector = request.filenum;
-    sector <<= 16;
-    sector |= request.blk;
-    if (disk_write(request.sdslot, buf, sector, 1) != RES_OK)
+    LBA_t sector;
+    UINT  count = 1;
+    if ((vol_map_sectors(&sector, &count) != PRODOS_OK)||
+        (disk_write(request.sdslot, buf, sector, 1) != RES_OK))
       return PRODOS_IO_ERR;
   }
   else
-#endif
 #ifdef USE_FAT_DISK
   {
     // convert blocks to bytes
@@ -256,14 +445,14 @@ uint8_t vol_write_block(uint8_t* buf)
     FileOffset <<= 9;
 
     // do not allow to write beyond the current file size
-    if (FileOffset+512 > f_size(&current_file))
+    if (FileOffset+512 > f_size(current_file))
       return PRODOS_IO_ERR;
 
     // only seek when necessary
-    if ((f_tell(&current_file) != FileOffset)&&(f_lseek(&current_file, FileOffset) != FR_OK))
+    if ((f_tell(current_file) != FileOffset)&&(f_lseek(current_file, FileOffset) != FR_OK))
       return PRODOS_IO_ERR;
 
-    if ((f_write(&current_file, buf, 512, &br) != FR_OK) ||
+    if ((f_write(current_file, buf, 512, &br) != FR_OK) ||
         (br != 512))
       return PRODOS_IO_ERR;
   }
@@ -275,3 +464,678 @@ uint8_t vol_write_block(uint8_t* buf)
 
   return PRODOS_OK;
 }
+
+// get the extents of the requested volume: size in blocks, start sector (contiguous volumes only) and
+// number of fragments (1=contiguous, 0=unknown): returns 0=OK or PRODOS error code
+uint8_t vol_get_extents(uint32_t* blocks, uint32_t* sector, uint16_t* frags)
+{
+  if (!vol_open_drive_file())
+    return PRODOS_NODEV_ERR;
+
+#ifdef USE_RAW_DISK
+  if (slot_type[request.sdslot] == SLOT_TYPE_RAW)
+  {
+    // RAW volumes are always contiguous
+    *blocks = 0x10000;
+    *sector = ((uint32_t) request.filenum) << 16;
+    *frags  = 1;
+    return PRODOS_OK;
+  }
+#endif
+#ifdef USE_FAT_DISK
+  uint8_t f = current_file - vol_files;
+  *blocks = f_size(current_file) >> 9;
+  *sector = vol_files_lba[f];
+  *frags  = vol_files_frags[f];
+  return PRODOS_OK;
+#else
+  return PRODOS_NODEV_ERR;
+#endif
+}
+
+// read a block for the FTP server or the volume catalog (volume headers, bitmap blocks) from disk, so these accesses
+// do not replace the Apple II's cached blocks or start a read-ahead. A cached copy is used when there is one (it may
+// be a deferred write). Returns 0=OK or PRODOS error code.
+uint8_t vol_read_uncached(uint8_t* buf)
+{
+#ifdef USE_BLOCK_CACHE
+  uint8_t* data = vol_cache_block();
+  if (data)
+  {
+    memcpy(buf, data, 512);
+    return PRODOS_OK;
+  }
+#endif
+  uint8_t returncode = vol_read_disk_block(buf);
+  // the buffer may be the FatFs sector window (see vol_header_buffer)
+  FATFS* fs = VOL_FS(request.sdslot);
+  if (buf == fs->win)
+    fs->winsect = -1; // invalidate sector window
+  return returncode;
+}
+
+// a 512 byte buffer for vol_get_volume_name, so no block buffer is needed on the stack: the FatFs sector window of
+// the requested SD card, which FatFs reloads on its next access
+uint8_t* vol_header_buffer(void)
+{
+  return VOL_FS(request.sdslot)->win;
+}
+
+// read the ProDOS volume header (block 2) of the requested volume: returns the volume size in blocks (limited to
+// FileBlocks). Optionally obtains the volume name (15 characters, pVolName[0]==0 when there is no ProDOS header) and
+// the first block of the volume bitmap (0 when there is no ProDOS header).
+uint32_t vol_get_prodos_info(uint8_t* ProdosHeader, char* pVolName, uint32_t FileBlocks, uint16_t* pBitmapBlk)
+{
+  // read PRODOS volume name from header
+  request.blk = PRODOS_VOLUME_HEADER>>9;
+
+  if (pVolName)
+    pVolName[0] = 0; // volume name (still) invalid
+  if (pBitmapBlk)
+    *pBitmapBlk = 0; // no ProDOS volume bitmap (yet)
+
+  if (0==vol_read_uncached(ProdosHeader))
+  {
+    uint8_t len = ProdosHeader[4] ^ 0xf0; // top 4 bits must be set for PRODOS volume name lengths
+    uint16_t ProdosDirLenEntry = *((uint16_t*)&ProdosHeader[0x23]);
+
+    if ((ProdosDirLenEntry == 0x0D27)&& // check entry length/entries per block=$27/$0D
+        (len <= 0xf))                   // valid length field?
+    {
+      // write 15 ASCII characters with PRODOS volume name
+      if (pVolName)
+      {
+        for (uint8_t i=0;i<15;i++)
+        {
+          char ascii = ProdosHeader[5+i];
+          if ((i>=len)||(ascii<' ')||(ascii>'z'))
+            ascii=' ';
+          pVolName[i] = ascii;
+        }
+      }
+
+      // get PRODOS volume size
+      uint16_t ProdosBlocks = ProdosHeader[0x2A];
+      ProdosBlocks <<= 8;
+      ProdosBlocks |= ProdosHeader[0x29];
+      // report PRODOS volume size (unless physical block device file is smaller)
+      if (ProdosBlocks < FileBlocks)
+        FileBlocks = ProdosBlocks;
+
+      // get location of the PRODOS volume bitmap
+      if (pBitmapBlk)
+        *pBitmapBlk = *((uint16_t*)&ProdosHeader[0x27]);
+    }
+  }
+  return FileBlocks;
+}
+
+#ifdef USE_VOL_CATALOG
+// catalog of the ProDOS volume names and sizes, so directory listings (FTP) do not need to open each volume file
+// and read its header. Entries are packed into a byte pool: key (bit 7: SD card, bits 0-6: file number), size in
+// blocks (16bit), name length, name. Only valid ProDOS volumes need an entry: for all other cataloged volume files
+// (missing files, no ProDOS header) only the "known" bit is set.
+#define CATALOG_ENTRY_HEADER 4
+#define CATALOG_KEY          ((request.sdslot << 7) | request.filenum)
+
+uint8_t   vol_catalog[VOL_CATALOG_SIZE];
+uint16_t  vol_catalog_used;      // number of bytes used in the catalog pool
+uint8_t   vol_catalog_known[2][16]; // bitmap of the cataloged volume files of both SD cards
+
+#define CATALOG_KNOWN_BIT(filenum) (1 << ((filenum) & 7))
+
+// find the catalog entry of the requested volume
+static uint8_t* vol_catalog_find(void)
+{
+  uint8_t  key = CATALOG_KEY;
+  uint8_t* p   = vol_catalog;
+  while (p < &vol_catalog[vol_catalog_used])
+  {
+    if (p[0] == key)
+      return p;
+    p += CATALOG_ENTRY_HEADER + p[3];
+  }
+  return NULL;
+}
+
+// get the catalog entry of the requested volume: returns true when cataloged. Writes the space padded 15
+// character volume name (pVolName[0]==0 when no ProDOS volume) and the size in blocks.
+static bool vol_catalog_get(char* pVolName, uint32_t* pBlocks)
+{
+  if ((request.sdslot > 1)||(request.filenum > 127)||
+      (0 == (vol_catalog_known[request.sdslot][request.filenum >> 3] & CATALOG_KNOWN_BIT(request.filenum))))
+    return false;
+
+  uint8_t* p = vol_catalog_find();
+  if (p == NULL)
+  {
+    pVolName[0] = 0; // known, but no ProDOS volume
+    return true;
+  }
+  *pBlocks = *((uint16_t*) &p[1]);
+  memcpy(pVolName, &p[CATALOG_ENTRY_HEADER], p[3]);
+  return true;
+}
+
+// add the requested volume to the catalog (pVolName[0]==0 when no ProDOS volume)
+static void vol_catalog_put(const char* pVolName, uint32_t Blocks)
+{
+  if ((request.sdslot > 1)||(request.filenum > 127))
+    return;
+
+  uint8_t len = 0;
+  if (pVolName[0])
+  {
+    // trim the space padded name
+    len = 15;
+    while ((len > 0)&&(pVolName[len-1] == ' '))
+      len--;
+    uint8_t* p = &vol_catalog[vol_catalog_used];
+    if ((len == 0)||(Blocks > 0xFFFF)||
+        (vol_catalog_used + CATALOG_ENTRY_HEADER + len > VOL_CATALOG_SIZE)) // pool full: volume is not cataloged
+      return;
+    p[0] = CATALOG_KEY;
+    *((uint16_t*) &p[1]) = Blocks;
+    p[3] = len;
+    memcpy(&p[CATALOG_ENTRY_HEADER], pVolName, len);
+    vol_catalog_used += CATALOG_ENTRY_HEADER + len;
+  }
+  vol_catalog_known[request.sdslot][request.filenum >> 3] |= CATALOG_KNOWN_BIT(request.filenum);
+}
+
+// remove the requested volume from the catalog, when the volume header (block 2) is among the 'count' written blocks
+static void vol_catalog_drop(uint8_t count)
+{
+  if ((request.sdslot > 1)||(request.filenum > 127)||
+      ((uint16_t)(2 - request.blk) >= count))
+    return;
+
+  vol_catalog_known[request.sdslot][request.filenum >> 3] &= ~CATALOG_KNOWN_BIT(request.filenum);
+  uint8_t* p = vol_catalog_find();
+  if (p)
+  {
+    uint8_t size = CATALOG_ENTRY_HEADER + p[3];
+    vol_catalog_used -= size;
+    memmove(p, p + size, &vol_catalog[vol_catalog_used] - p);
+  }
+}
+#endif
+
+// get name and size of the requested volume (FTP directory listing, volume catalog command), from the volume catalog
+// when available: pVolName receives 15 space padded characters (pVolName[0]==0: no volume file or no ProDOS volume)
+void vol_get_volume_name(uint8_t* buf, char* pVolName, uint32_t* pBlocks)
+{
+  memset(pVolName, ' ', 15);
+#ifdef USE_VOL_CATALOG
+  if (vol_catalog_get(pVolName, pBlocks))
+    return;
+#endif
+  uint32_t blocks, sector;
+  uint16_t frags;
+  pVolName[0] = 0; // no volume file
+  *pBlocks = 0;
+  if (vol_get_extents(&blocks, &sector, &frags) == PRODOS_OK)
+  {
+    if (blocks > 65536)
+      blocks = 65536;
+    *pBlocks = vol_get_prodos_info(buf, pVolName, blocks, NULL);
+  }
+#ifdef USE_VOL_CATALOG
+  vol_catalog_put(pVolName, *pBlocks);
+#endif
+}
+
+#ifdef USE_BLOCK_CACHE
+// write-through cache for frequently accessed blocks (ProDOS directory, bitmap...)
+typedef struct {
+  request_t key;       // cached block (sdslot, filenum, blk)
+  bool      valid;     // block data is valid
+  bool      ahead;     // block was read ahead, but not requested yet
+  bool      dirty;     // write-back: block still needs to be written to disk
+  uint16_t  lastuse;   // cache clock of the most recent access (for LRU replacement)
+  uint8_t   data[512];
+} cache_block_t;
+
+cache_block_t vol_cache[BLOCK_CACHE_SIZE];
+uint16_t  vol_cache_clock;       // incremented with every cache access
+uint16_t  vol_cache_hits;        // statistics: number of blocks found in the cache
+uint16_t  vol_cache_misses;      // statistics: number of blocks read from disk
+#ifdef USE_WRITE_BACK
+bool      vol_write_back;        // write-back mode enabled (otherwise write-through)
+uint8_t   vol_cache_error;       // write-back: error of any deferred write, since the last flush command
+#endif
+#ifdef USE_READ_AHEAD
+request_t vol_ahead;             // the block to be read ahead
+bool      vol_ahead_pending;     // a block is waiting to be read ahead
+uint16_t  vol_ahead_reads;       // statistics: number of blocks read ahead
+uint16_t  vol_ahead_hits;        // statistics: number of blocks read ahead, which were then requested
+uint16_t  vol_ahead_aborts;      // statistics: number of read-aheads aborted by Apple II commands
+#endif
+
+// find the cache entry of the requested block
+static cache_block_t* vol_cache_find(void)
+{
+  for (uint8_t i=0;i<BLOCK_CACHE_SIZE;i++)
+  {
+    cache_block_t* c = &vol_cache[i];
+    if ((c->valid)&&
+        (c->key.blk     == request.blk)&&
+        (c->key.filenum == request.filenum)&&
+        (c->key.sdslot  == request.sdslot))
+    {
+      c->lastuse = ++vol_cache_clock;
+      return c;
+    }
+  }
+  return NULL;
+}
+
+#ifdef USE_WRITE_BACK
+// write a deferred block to disk
+static void vol_cache_write_back(cache_block_t* c)
+{
+  request_t saved = request;
+  request = c->key;
+  if (vol_write_disk_block(c->data) != PRODOS_OK)
+    vol_cache_error = PRODOS_IO_ERR;
+  c->dirty = false;
+  request = saved;
+}
+
+// write all deferred blocks to disk: returns 0=OK or the PRODOS error code of any failed deferred write
+uint8_t vol_cache_flush(void)
+{
+  for (uint8_t i=0;i<BLOCK_CACHE_SIZE;i++)
+  {
+    if (vol_cache[i].dirty)
+      vol_cache_write_back(&vol_cache[i]);
+  }
+  return vol_cache_error;
+}
+
+// write one deferred block to disk, while the Apple II is idle
+void vol_cache_flush_idle(void)
+{
+  for (uint8_t i=0;i<BLOCK_CACHE_SIZE;i++)
+  {
+    if (vol_cache[i].dirty)
+    {
+      vol_cache_write_back(&vol_cache[i]);
+      return;
+    }
+  }
+}
+#endif
+
+// invalidate all cached blocks (deferred blocks are written to disk first)
+void vol_cache_invalidate(void)
+{
+#ifdef USE_WRITE_BACK
+  vol_cache_flush();
+#endif
+  for (uint8_t i=0;i<BLOCK_CACHE_SIZE;i++)
+    vol_cache[i].valid = false;
+#ifdef USE_READ_AHEAD
+  vol_ahead_pending = false;
+#endif
+}
+
+// select the cache entry to be replaced: an invalid or the least recently used block
+static cache_block_t* vol_cache_victim(void)
+{
+  cache_block_t* c = &vol_cache[0];
+  for (uint8_t i=1;(i<BLOCK_CACHE_SIZE)&&(c->valid);i++)
+  {
+    cache_block_t* n = &vol_cache[i];
+    if ((!n->valid)||((uint16_t)(vol_cache_clock - n->lastuse) > (uint16_t)(vol_cache_clock - c->lastuse)))
+      c = n;
+  }
+#ifdef USE_WRITE_BACK
+  if (c->dirty)
+    vol_cache_write_back(c);
+#endif
+  c->valid = false;
+  c->ahead = false;
+  return c;
+}
+
+#ifdef USE_WRITE_BACK
+// write-back: return the cache buffer receiving the requested block, which is written to disk later
+uint8_t* vol_write_deferred(void)
+{
+#ifdef USE_VOL_CATALOG
+  vol_catalog_drop(1);
+#endif
+  cache_block_t* c = vol_cache_find();
+  if (c == NULL)
+    c = vol_cache_victim();
+  c->key     = request;
+  c->valid   = true;
+  c->ahead   = false;
+  c->dirty   = true;
+  c->lastuse = ++vol_cache_clock;
+  return c->data;
+}
+#endif
+
+// invalidate 'count' cached blocks, starting at the requested block. Pending write-backs of these blocks
+// are dropped as well, since the blocks were overwritten on disk.
+static void vol_cache_drop(uint8_t count)
+{
+  for (uint8_t i=0;i<BLOCK_CACHE_SIZE;i++)
+  {
+    cache_block_t* c = &vol_cache[i];
+    if ((c->key.filenum == request.filenum)&&
+        (c->key.sdslot  == request.sdslot)&&
+        ((uint16_t)(c->key.blk - request.blk) < count))
+    {
+      c->valid = false;
+      c->dirty = false;
+    }
+  }
+}
+
+// return the cached data of the requested block, or NULL when it is not cached
+uint8_t* vol_cache_block(void)
+{
+  cache_block_t* c = vol_cache_find();
+  return (c) ? c->data : NULL;
+}
+
+// read the requested block through the cache: returns 0=OK or PRODOS error code
+uint8_t vol_read_cached(uint8_t** data)
+{
+#ifdef USE_READ_AHEAD
+  // the following block is read ahead next time the Apple II is idle
+  vol_ahead = request;
+  vol_ahead.blk++;
+  vol_ahead_pending = (vol_ahead.blk != 0);
+#endif
+
+  cache_block_t* c = vol_cache_find();
+  if (c)
+  {
+    vol_cache_hits++;
+#ifdef USE_READ_AHEAD
+    if (c->ahead)
+    {
+      vol_ahead_hits++;
+      c->ahead = false;
+    }
+#endif
+    *data = c->data;
+    return PRODOS_OK;
+  }
+  vol_cache_misses++;
+
+  c = vol_cache_victim();
+  uint8_t returncode = vol_read_disk_block(c->data);
+  if (returncode == PRODOS_OK)
+  {
+    c->key     = request;
+    c->valid   = true;
+    c->lastuse = ++vol_cache_clock;
+    *data = c->data;
+  }
+  return returncode;
+}
+
+#ifdef USE_READ_AHEAD
+// read the next block of a sequential access into the block cache, while the Apple II is idle.
+// The read is abandoned as soon as the Apple II sends a command.
+void vol_read_ahead(void)
+{
+  if (!vol_ahead_pending)
+    return;
+
+  request_t saved = request;
+  request = vol_ahead;
+  vol_ahead_pending = false;
+
+  LBA_t sector;
+  UINT  count = 2; // also tells whether the following block is contiguous
+  if ((vol_cache_find() == NULL)&&
+      (vol_open_drive_file())&&
+      (vol_map_sectors(&sector, &count) == PRODOS_OK))
+  {
+    cache_block_t* c = vol_cache_victim();
+    // always use a multi-block read, which can be stopped at any time. The transfer of the previous
+    // read-ahead is continued, if it was kept open for this block.
+    if ((disk_read_continue(request.sdslot, sector) == RES_OK)||
+        (disk_read_start(request.sdslot, sector, 2) == RES_OK))
+    {
+      DRESULT res = disk_read_idle(c->data);
+      // keep the transfer open for the following block, if it is contiguous on the card
+      if ((res == RES_OK)&&(count > 1))
+        disk_read_keep(sector+1);
+      else
+        disk_read_stop();
+      if (res == RES_OK)
+      {
+        c->key     = request;
+        c->valid   = true;
+        c->ahead   = true;
+        c->lastuse = ++vol_cache_clock;
+        vol_ahead_reads++;
+      }
+      else
+      if (res == RES_ABORTED)
+      {
+        // try again when the Apple II is idle again (unless it reads another block now)
+        vol_ahead_aborts++;
+        vol_ahead_pending = true;
+      }
+    }
+  }
+
+  request = saved;
+}
+#endif
+#endif
+
+// read a block from disk or from the block cache, returns 0=OK
+uint8_t vol_read_block(uint8_t* buf)
+{
+#ifdef USE_BLOCK_CACHE
+  uint8_t* data;
+  uint8_t returncode = vol_read_cached(&data);
+  if (returncode == PRODOS_OK)
+    memcpy(buf, data, 512);
+  return returncode;
+#else
+  return vol_read_disk_block(buf);
+#endif
+}
+
+// write a block to disk (and update the block cache): returns 0=OK or PRODOS error code
+uint8_t vol_write_block(uint8_t* buf)
+{
+#ifdef USE_VOL_CATALOG
+  vol_catalog_drop(1);
+#endif
+  uint8_t returncode = vol_write_disk_block(buf);
+#ifdef USE_BLOCK_CACHE
+  cache_block_t* c = vol_cache_find();
+  if (c)
+  {
+    if (returncode != PRODOS_OK)
+      c->valid = false;
+    else
+    if (c->data != buf)
+      memcpy(c->data, buf, 512);
+#ifdef USE_WRITE_BACK
+    c->dirty = false;
+#endif
+  }
+#endif
+  return returncode;
+}
+
+// prepare transferring 'count' consecutive blocks, starting at request.blk: returns 0=OK or PRODOS error code
+static uint8_t vol_xfer_start(uint8_t count)
+{
+  vol_xfer_blocks  = 0;
+  vol_xfer_sectors = 0;
+
+#ifdef USE_WRITE_BACK
+  // multi-block transfers bypass the block cache: deferred blocks must be on disk
+  vol_cache_flush();
+#endif
+
+  if (!vol_open_drive_file())
+    return PRODOS_NODEV_ERR;
+
+  // the blocks must be within the volume
+  if ((count == 0)||(((uint32_t) request.blk) + count > 0x10000))
+    return PRODOS_IO_ERR;
+
+  vol_xfer_blocks = count;
+  return PRODOS_OK;
+}
+
+// prepare reading 'count' consecutive blocks, starting at request.blk: returns 0=OK or PRODOS error code
+uint8_t vol_read_start(uint8_t count)
+{
+  return vol_xfer_start(count);
+}
+
+// read the next block of a multi-block read: returns 0=OK or PRODOS error code
+// buf==NULL streams a zero status byte and the block directly to the Apple II;
+// VOL_CRC_ERR is returned when the streamed block failed the SD card CRC check
+uint8_t vol_read_next(uint8_t* buf)
+{
+  if (vol_xfer_blocks == 0)
+    return PRODOS_IO_ERR;
+
+  // start a new SD card transfer for the next contiguous run of sectors when necessary
+  if (vol_xfer_sectors == 0)
+  {
+    LBA_t sector;
+    UINT  count = vol_xfer_blocks;
+    uint8_t returncode = vol_map_sectors(&sector, &count);
+    if (returncode != PRODOS_OK)
+      return returncode;
+    if (disk_read_start(request.sdslot, sector, count) != RES_OK)
+      return PRODOS_IO_ERR;
+    vol_xfer_sectors = count;
+  }
+
+  DRESULT res = disk_read_next(buf);
+  if (res != RES_OK)
+  {
+    vol_read_stop();
+    return (res == RES_STREAMERR) ? VOL_CRC_ERR : PRODOS_IO_ERR;
+  }
+
+  request.blk++;
+  vol_xfer_blocks--;
+  if (--vol_xfer_sectors == 0)
+    disk_read_stop();
+
+  return PRODOS_OK;
+}
+
+// release the SPI bus between two blocks of a multi-block read (i.e. for the W5500)
+void vol_read_pause(void)
+{
+  if (vol_xfer_sectors)
+    disk_read_pause();
+}
+
+// continue a multi-block read after vol_read_pause
+void vol_read_resume(void)
+{
+  if (vol_xfer_sectors)
+    disk_read_resume();
+}
+
+// terminate a multi-block read (also when the transfer was aborted)
+void vol_read_stop(void)
+{
+  if (vol_xfer_sectors)
+    disk_read_stop();
+  vol_xfer_sectors = 0;
+  vol_xfer_blocks  = 0;
+}
+
+// prepare writing 'count' consecutive blocks, starting at request.blk: returns 0=OK or PRODOS error code.
+// preerase: all blocks are written (unless there is an error), so the SD card may pre-erase them.
+uint8_t vol_write_start(uint8_t count, bool preerase)
+{
+  vol_xfer_preerase = preerase;
+#ifdef USE_VOL_CATALOG
+  vol_catalog_drop(count);
+#endif
+  // multi-block writes bypass the block cache: cached copies are dropped as the blocks are written (vol_write_next)
+  return vol_xfer_start(count);
+}
+
+// without an SD card transfer, a streamed block is still received from the Apple II (and discarded)
+static uint8_t vol_write_skip(uint8_t* buf, uint8_t returncode)
+{
+  if (buf == NULL)
+    disk_write_next(NULL);
+  return returncode;
+}
+
+// write the next block of a multi-block write: returns 0=OK or PRODOS error code
+// buf==NULL streams the block directly from the Apple II: it is always received, even on errors
+uint8_t vol_write_next(uint8_t* buf)
+{
+  if (vol_xfer_blocks == 0)
+    return vol_write_skip(buf, PRODOS_IO_ERR);
+
+  // start a new SD card transfer for the next contiguous run of sectors when necessary
+  if (vol_xfer_sectors == 0)
+  {
+    LBA_t sector;
+    UINT  count = vol_xfer_blocks;
+    uint8_t returncode = vol_map_sectors(&sector, &count);
+    if (returncode != PRODOS_OK)
+      return vol_write_skip(buf, returncode);
+    if (disk_write_start(request.sdslot, sector, count, vol_xfer_preerase) != RES_OK)
+      return vol_write_skip(buf, PRODOS_IO_ERR);
+    vol_xfer_sectors = count;
+  }
+
+  if (disk_write_next(buf) != RES_OK)
+  {
+    vol_write_stop();
+    return PRODOS_IO_ERR;
+  }
+#ifdef USE_BLOCK_CACHE
+  // the block on disk is newer than a cached copy (or a deferred write-back), blocks which are not written keep theirs
+  vol_cache_drop(1);
+#endif
+
+  request.blk++;
+  vol_xfer_blocks--;
+  // end of a contiguous run: the final stop token also reports whether the card accepted the run
+  if ((--vol_xfer_sectors == 0)&&(disk_write_stop() != RES_OK))
+    return PRODOS_IO_ERR;
+
+  return PRODOS_OK;
+}
+
+// release the SPI bus between two blocks of a multi-block write (i.e. for the W5500)
+void vol_write_pause(void)
+{
+  if (vol_xfer_sectors)
+    disk_write_pause();
+}
+
+// continue a multi-block write after vol_write_pause
+void vol_write_resume(void)
+{
+  if (vol_xfer_sectors)
+    disk_write_resume();
+}
+
+// terminate a multi-block write (also when the transfer was aborted)
+void vol_write_stop(void)
+{
+  if (vol_xfer_sectors)
+    disk_write_stop();
+  vol_xfer_sectors = 0;
+  vol_xfer_blocks  = 0;
+}
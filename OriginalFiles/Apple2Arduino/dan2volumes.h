@@ -29,6 +29,9 @@
 #define PRODOS_NODEV_ERR      0x28
 #define PRODOS_WRITEPROT_ERR  0x2B
 
+// internal: block was already streamed to the Apple II, but its CRC was bad
+#define VOL_CRC_ERR           0x80
+
 #define SLOT_STATE_NODEV    0
 #define SLOT_STATE_BLOCKDEV 1
 #define SLOT_STATE_FILEDEV  2
@@ -38,9 +41,40 @@
 #define SLOT_TYPE_FAT       1
 #define SLOT_TYPE_RAW       2
 
+// offset of the ProDOS volume header
+#define PRODOS_VOLUME_HEADER 0x400
+
 #define SDSLOT1             0
 #define SDSLOT2             1
 
+// number of FAT volume files kept open simultaneously (at least one per drive)
+#if defined(__AVR_ATmega644P__)
+  #define VOL_OPEN_FILES 4
+#else
+  #define VOL_OPEN_FILES 2
+#endif
+
+// a second FATFS needs more RAM than the ATmega328P has
+#if !defined(__AVR_ATmega644P__)
+  #undef USE_DUAL_MOUNT
+#endif
+
+// the block cache needs more RAM than the ATmega328P has
+#if defined(__AVR_ATmega644P__) && (BLOCK_CACHE_SIZE > 0)
+  #define USE_BLOCK_CACHE
+#endif
+
+// the volume catalog needs more RAM than the ATmega328P has
+#if defined(__AVR_ATmega644P__) && (VOL_CATALOG_SIZE > 0)
+  #define USE_VOL_CATALOG
+#endif
+
+// blocks are read ahead into the block cache, deferred writes are kept in the block cache
+#ifndef USE_BLOCK_CACHE
+  #undef USE_READ_AHEAD
+  #undef USE_WRITE_BACK
+#endif
+
 typedef struct {
   uint8_t  sdslot;   // access: which SD slot
   uint8_t  filenum;  // access: which file/block device number
@@ -48,11 +82,54 @@ typedef struct {
 } request_t;
 
 extern request_t request;
-extern FIL       current_file;
+extern uint8_t   unit;
+extern uint8_t   drive_fileno[2];
+extern uint8_t   a2slot;
+extern FIL*      current_file;
 extern int8_t    slot_type[2];
+extern uint16_t  vol_mounts;
 
 uint8_t hex_digit          (uint8_t ch);
+void    calculate_sd_filenum(void);
 uint8_t vol_read_block     (uint8_t* buf);
 uint8_t vol_write_block    (uint8_t* buf);
+uint8_t vol_read_uncached  (uint8_t* buf);
+uint8_t vol_read_start     (uint8_t count);
+uint8_t vol_read_next      (uint8_t* buf);
+void    vol_read_pause     (void);
+void    vol_read_resume    (void);
+void    vol_read_stop      (void);
+uint8_t vol_write_start    (uint8_t count, bool preerase);
+uint8_t vol_write_next     (uint8_t* buf);
+void    vol_write_pause    (void);
+void    vol_write_resume   (void);
+void    vol_write_stop     (void);
+uint8_t vol_get_extents    (uint32_t* blocks, uint32_t* sector, uint16_t* frags);
+uint32_t vol_get_prodos_info(uint8_t* ProdosHeader, char* pVolName, uint32_t FileBlocks, uint16_t* pBitmapBlk);
+void    vol_get_volume_name(uint8_t* buf, char* pVolName, uint32_t* pBlocks);
+uint8_t* vol_header_buffer (void);
 void    vol_check_sdslot_type(void);
+#ifdef USE_BLOCK_CACHE
+extern uint16_t vol_cache_hits;
+extern uint16_t vol_cache_misses;
+
+void     vol_cache_invalidate(void);
+uint8_t* vol_cache_block     (void);
+uint8_t  vol_read_cached     (uint8_t** data);
+#endif
+#ifdef USE_WRITE_BACK
+extern bool     vol_write_back;
+extern uint8_t  vol_cache_error;
+
+uint8_t  vol_cache_flush     (void);
+void     vol_cache_flush_idle(void);
+uint8_t* vol_write_deferred  (void);
+#endif
+#ifdef USE_READ_AHEAD
+extern uint16_t vol_ahead_reads;
+extern uint16_t vol_ahead_hits;
+extern uint16_t vol_ahead_aborts;
+
+void     vol_read_ahead      (void);
+#endif
 bool    vol_open_drive_file(void);
@@ -15,10 +15,21 @@
 /* Prepare Drive Access                                                  */
 /*-----------------------------------------------------------------------*/
 
+static BYTE  kept_pdrv = 0xff;	/* drive of a paused read transfer kept open by disk_read_keep */
+static LBA_t kept_sector;		/* next sector of the kept transfer */
+
 static void disk_prep (
 	BYTE pdrv		/* Physical drive number to identify the drive */
 )
 {
+  if (kept_pdrv != 0xff)
+  {
+    // any other drive access ends a kept read transfer
+    slotno = kept_pdrv;
+    kept_pdrv = 0xff;
+    mmc_disk_read_resume();
+    mmc_disk_read_stop();
+  }
   if (slotno != pdrv)
     mmc_wait_busy_spi();  // make sure the other slot is not busy/blocking the SPI
   slotno = pdrv;        // remember the current drive
@@ -70,6 +81,81 @@ DRESULT disk_read (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Read Multiple Sectors Block by Block                                  */
+/*-----------------------------------------------------------------------*/
+/* Unlike disk_read, the caller does not need a buffer for all sectors:  */
+/* each sector is fetched separately with disk_read_next. The transfer   */
+/* keeps the drive selected at disk_read_start until disk_read_stop.     */
+/* disk_read_idle gives up when the Apple II sends a command meanwhile.  */
+/* disk_read_pause releases the SPI bus between two sectors, until       */
+/* disk_read_resume continues the transfer.                              */
+/* disk_read_keep pauses a multi-sector transfer and keeps it open after */
+/* the current operation: disk_read_continue resumes it, if the next     */
+/* sector is requested, any other drive access stops it.                 */
+
+DRESULT disk_read_start (
+	BYTE pdrv,		/* Physical drive number to identify the drive */
+	LBA_t sector,	/* Start sector in LBA */
+	UINT count		/* Number of sectors to read */
+)
+{
+  disk_prep(pdrv);
+  return mmc_disk_read_start(sector, count);
+}
+
+DRESULT disk_read_next (
+	BYTE *buff		/* Data buffer to store a single sector */
+)
+{
+  return mmc_disk_read_next(buff);
+}
+
+DRESULT disk_read_idle (
+	BYTE *buff		/* Data buffer to store a single sector */
+)
+{
+  return mmc_disk_read_idle(buff);
+}
+
+void disk_read_pause (void)
+{
+  mmc_disk_read_pause();
+}
+
+void disk_read_resume (void)
+{
+  mmc_disk_read_resume();
+}
+
+void disk_read_stop (void)
+{
+  mmc_disk_read_stop();
+}
+
+void disk_read_keep (
+	LBA_t sector	/* Next sector of the transfer */
+)
+{
+  mmc_disk_read_pause();
+  kept_pdrv = slotno;
+  kept_sector = sector;
+}
+
+DRESULT disk_read_continue (
+	BYTE pdrv,		/* Physical drive number to identify the drive */
+	LBA_t sector	/* Sector to read next */
+)
+{
+  if ((kept_pdrv != pdrv)||(kept_sector != sector))
+    return RES_NOTRDY;
+  kept_pdrv = 0xff;
+  mmc_disk_read_resume();
+  return RES_OK;
+}
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Write Sector(s)                                                       */
 /*-----------------------------------------------------------------------*/
@@ -88,6 +174,49 @@ DRESULT disk_write (
 #endif
 
 
+/*-----------------------------------------------------------------------*/
+/* Write Multiple Sectors Block by Block                                 */
+/*-----------------------------------------------------------------------*/
+/* Counterpart of disk_read_start: each sector is sent separately with   */
+/* disk_write_next. The card may program the sectors back-to-back.       */
+/* disk_write_pause/disk_write_resume release the SPI bus in between.    */
+
+#if !FF_FS_READONLY
+DRESULT disk_write_start (
+	BYTE pdrv,		/* Physical drive number to identify the drive */
+	LBA_t sector,	/* Start sector in LBA */
+	UINT count,		/* Number of sectors to write */
+	BYTE preerase	/* Pre-erase the sectors: all of them are written */
+)
+{
+  disk_prep(pdrv);
+  return mmc_disk_write_start(sector, count, preerase);
+}
+
+DRESULT disk_write_next (
+	const BYTE *buff	/* Data of a single sector */
+)
+{
+  return mmc_disk_write_next(buff);
+}
+
+void disk_write_pause (void)
+{
+  mmc_disk_write_pause();
+}
+
+void disk_write_resume (void)
+{
+  mmc_disk_write_resume();
+}
+
+DRESULT disk_write_stop (void)
+{
+  return mmc_disk_write_stop();
+}
+#endif
+
+
 /*-----------------------------------------------------------------------*/
 /* Miscellaneous Functions                                               */
 /*-----------------------------------------------------------------------*/
@@ -33,7 +33,9 @@ typedef enum {
 	RES_ERROR,		/* 1: R/W Error */
 	RES_WRPRT,		/* 2: Write Protected */
 	RES_NOTRDY,		/* 3: Not Ready */
-	RES_PARERR		/* 4: Invalid Parameter */
+	RES_PARERR,		/* 4: Invalid Parameter */
+	RES_STREAMERR,	/* 5: Streamed block failed the CRC check (DAN][) */
+	RES_ABORTED		/* 6: Read aborted by an Apple II command (DAN][) */
 } DRESULT;
 
 /* Command structure for iSDIO ioctl command */
@@ -54,6 +56,19 @@ DSTATUS disk_status (BYTE pdrv);
 DRESULT disk_read (BYTE pdrv, BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
+DRESULT disk_read_start (BYTE pdrv, LBA_t sector, UINT count);
+DRESULT disk_read_next (BYTE* buff);
+DRESULT disk_read_idle (BYTE* buff);
+void disk_read_pause (void);
+void disk_read_resume (void);
+void disk_read_stop (void);
+void disk_read_keep (LBA_t sector);
+DRESULT disk_read_continue (BYTE pdrv, LBA_t sector);
+DRESULT disk_write_start (BYTE pdrv, LBA_t sector, UINT count, BYTE preerase);
+DRESULT disk_write_next (const BYTE* buff);
+void disk_write_pause (void);
+void disk_write_resume (void);
+DRESULT disk_write_stop (void);
 /* void disk_timerproc (void); */
 
 
@@ -4539,6 +4539,100 @@ FRESULT f_lseek (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Get Physical Sectors at the File Pointer (DAN][ extension)            */
+/*-----------------------------------------------------------------------*/
+/* Maps the sector aligned file pointer to a physical sector and counts  */
+/* the sectors which follow contiguously on the disk, so the caller can  */
+/* access them directly with a single multiple block transfer.           */
+
+FRESULT f_getlba (
+	FIL* fp,		/* Pointer to the file object */
+	LBA_t* sect,	/* Pointer to return the physical sector number */
+	UINT* count		/* In: maximum number of sectors, Out: number of contiguous sectors */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD clst, nclst, csect, nsect;
+
+	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
+	if (res == FR_OK) res = (FRESULT)fp->err;
+	if (res != FR_OK) LEAVE_FF(fs, res);
+	if (fp->fptr % SS(fs) || fp->fptr >= fp->obj.objsize) LEAVE_FF(fs, FR_INVALID_PARAMETER);
+
+	csect = (DWORD)(fp->fptr / SS(fs)) & (fs->csize - 1);	/* Sector offset in the cluster */
+	if (fp->fptr == 0) {				/* Top of the file? */
+		clst = fp->obj.sclust;
+	} else if (csect == 0) {			/* On a cluster boundary? (fp->clust is the previous cluster) */
+		clst = get_fat(&fp->obj, fp->clust);
+	} else {
+		clst = fp->clust;
+	}
+	if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
+	*sect = clst2sect(fs, clst);
+	if (*sect == 0) ABORT(fs, FR_INT_ERR);
+	*sect += csect;
+
+	nsect = (DWORD)((fp->obj.objsize - fp->fptr) / SS(fs));	/* Sectors up to the end of the file */
+	if (nsect > *count) nsect = *count;
+	*count = fs->csize - csect;			/* Sectors up to the end of the cluster */
+	while (*count < nsect) {			/* Follow the chain while the clusters are contiguous */
+		nclst = get_fat(&fp->obj, clst);
+		if (nclst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
+		if (nclst != clst + 1) break;
+		clst = nclst;
+		*count += fs->csize;
+	}
+	if (*count > nsect) *count = nsect;
+
+	LEAVE_FF(fs, FR_OK);
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Get the Extents of a File (DAN][ extension)                           */
+/*-----------------------------------------------------------------------*/
+/* Follows the cluster chain of the whole file and counts its fragments  */
+/* (runs of contiguous clusters). A file with a single fragment can be   */
+/* accessed directly, starting at the returned physical sector.          */
+
+FRESULT f_getextents (
+	FIL* fp,		/* Pointer to the file object */
+	LBA_t* sect,	/* Pointer to return the physical start sector (0:empty file) */
+	WORD* frags		/* Pointer to return the number of fragments */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD clst, nclst, ncl;
+
+	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
+	if (res == FR_OK) res = (FRESULT)fp->err;
+	if (res != FR_OK) LEAVE_FF(fs, res);
+
+	*sect = 0; *frags = 0;
+	clst = fp->obj.sclust;
+	if (fp->obj.objsize == 0 || clst == 0) LEAVE_FF(fs, FR_OK);	/* Empty file */
+	*sect = clst2sect(fs, clst);
+	if (*sect == 0) ABORT(fs, FR_INT_ERR);
+
+	*frags = 1;
+	ncl = (DWORD)((fp->obj.objsize - 1) / SS(fs) / fs->csize);	/* Number of clusters following the first one */
+	while (ncl--) {
+		nclst = get_fat(&fp->obj, clst);
+		if (nclst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
+		if (nclst < 2 || nclst >= fs->n_fatent) ABORT(fs, FR_INT_ERR);
+		if (nclst != clst + 1 && *frags < 0xFFFF) (*frags)++;	/* New fragment */
+		clst = nclst;
+	}
+
+	LEAVE_FF(fs, FR_OK);
+}
+
+
+
 #if FF_FS_MINIMIZE <= 1
 /*-----------------------------------------------------------------------*/
 /* Create a Directory Object                                             */
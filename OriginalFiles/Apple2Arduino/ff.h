@@ -306,6 +306,8 @@ FRESULT f_close (FIL* fp);											/* Close an open file object */
 FRESULT f_read (FIL* fp, void* buff, UINT btr, UINT* br);			/* Read data from the file */
 FRESULT f_write (FIL* fp, const void* buff, UINT btw, UINT* bw);	/* Write data to the file */
 FRESULT f_lseek (FIL* fp, FSIZE_t ofs);								/* Move file pointer of the file object */
+FRESULT f_getlba (FIL* fp, LBA_t* sect, UINT* count);				/* Get physical sectors at the file pointer (DAN][ extension) */
+FRESULT f_getextents (FIL* fp, LBA_t* sect, WORD* frags);			/* Get the start sector and number of fragments of a file (DAN][ extension) */
 FRESULT f_truncate (FIL* fp);										/* Truncate the file */
 FRESULT f_sync (FIL* fp);											/* Flush cached data of the writing file */
 FRESULT f_opendir (DIR* dp, const TCHAR* path);						/* Open a directory */
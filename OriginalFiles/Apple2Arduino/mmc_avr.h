@@ -18,7 +18,18 @@ extern "C" {
 DSTATUS mmc_disk_initialize (void);
 DSTATUS mmc_disk_status (void);
 DRESULT mmc_disk_read (BYTE* buff, LBA_t sector, UINT count);
+DRESULT mmc_disk_read_start (LBA_t sector, UINT count);
+DRESULT mmc_disk_read_next (BYTE* buff);
+DRESULT mmc_disk_read_idle (BYTE* buff);
+void mmc_disk_read_pause (void);
+void mmc_disk_read_resume (void);
+void mmc_disk_read_stop (void);
 DRESULT mmc_disk_write (const BYTE* buff, LBA_t sector, UINT count);
+DRESULT mmc_disk_write_start (LBA_t sector, UINT count, BYTE preerase);
+DRESULT mmc_disk_write_next (const BYTE* buff);
+void mmc_disk_write_pause (void);
+void mmc_disk_write_resume (void);
+DRESULT mmc_disk_write_stop (void);
 DRESULT mmc_disk_ioctl (BYTE cmd, void* buff);
 void mmc_disk_timerproc (void);
 void mmc_wait_busy_spi(void);
@@ -15,6 +15,7 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/crc16.h>
 #include "diskio_sdc.h"
 #include "mmc_avr.h"
 #include "pindefs.h"
@@ -239,10 +240,7 @@ void mmc_wait_busy_spi(void)
 /*-----------------------------------------------------------------------*/
 
 static
-int rcvr_datablock (
-	BYTE *buff,			/* Data buffer to store received data */
-	UINT btr			/* Byte count (must be multiple of 4) */
-)
+int rcvr_token (void)	/* 1:Data token received, 0:Error or timeout */
 {
 	BYTE token;
 
@@ -251,7 +249,16 @@ int rcvr_datablock (
 	do {							/* Wait for data packet in timeout of 200ms */
 		token = xchg_spi_FF();
 	} while ((token == 0xFF) && (((int16_t)(((uint16_t)millis())-intime)) < 200));
-	if (token != 0xFE) return 0;	/* If not valid data token, return with error */
+	return token == 0xFE;			/* Valid data token? */
+}
+
+static
+int rcvr_datablock (
+	BYTE *buff,			/* Data buffer to store received data */
+	UINT btr			/* Byte count (must be multiple of 4) */
+)
+{
+	if (!rcvr_token()) return 0;	/* If not valid data token, return with error */
 
 	rcvr_spi_multi(buff, btr);		/* Receive the data block into buffer */
 	xchg_spi_FF();					/* Discard CRC */
@@ -262,6 +269,79 @@ int rcvr_datablock (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Receive a data packet from MMC while the Apple II is idle (DAN][)     */
+/*-----------------------------------------------------------------------*/
+
+/* Used for speculative reads: the transfer is abandoned as soon as the
+   Apple II sends a command byte, the caller then stops the transfer. */
+
+static
+DRESULT rcvr_datablock_idle (
+	BYTE *buff,			/* Data buffer to store received data */
+	UINT btr			/* Byte count */
+)
+{
+	if (!rcvr_token()) return RES_ERROR;	/* If not valid data token, return with error */
+
+	do {
+		if (READ_OBFA() == 0) return RES_ABORTED;	/* Apple II command pending */
+		*buff++ = xchg_spi_FF();
+	} while (--btr);
+	xchg_spi_FF();					/* Discard CRC */
+	xchg_spi_FF();
+
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Stream a data packet from MMC straight to the Apple II (DAN][)        */
+/*-----------------------------------------------------------------------*/
+
+/* The block is not buffered: each byte is handed to the 82C55 as soon as
+   it leaves the SPI shift register, and the next SPI byte is clocked in
+   while the 6502 picks the previous one up. A zero status byte precedes
+   the data, so nothing is sent to the Apple II before the data token has
+   arrived. The CRC16 of the block is checked once it has been sent. */
+
+static
+DRESULT rcvr_datastream (
+	UINT btr			/* Byte count */
+)
+{
+	BYTE d;
+	WORD crc = 0;
+
+	if (!rcvr_token()) return RES_ERROR;	/* Nothing has been sent yet */
+
+	SPDR = 0xFF;					/* Start clocking in the first data byte */
+	DATAPORT_MODE_TRANS();
+	while (READ_IBFA() != 0) {};	/* Status byte: block follows */
+	WRITE_DATAPORT(0);
+	STB_LOW();
+	STB_HIGH();
+	do {
+		loop_until_bit_is_set(SPSR, SPIF);
+		d = SPDR;
+		SPDR = 0xFF;				/* Next data byte (or first CRC byte) */
+		crc = _crc_xmodem_update(crc, d);
+		while (READ_IBFA() != 0) {};
+		WRITE_DATAPORT(d);
+		STB_LOW();
+		STB_HIGH();
+	} while (--btr);
+	loop_until_bit_is_set(SPSR, SPIF);
+	crc ^= (WORD)SPDR << 8;			/* Received CRC, MSB first */
+	crc ^= xchg_spi_FF();
+	DATAPORT_MODE_RECEIVE();
+
+	return crc ? RES_STREAMERR : RES_OK;
+}
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Send a data packet to MMC                                             */
 /*-----------------------------------------------------------------------*/
@@ -291,6 +371,47 @@ int xmit_datablock (
 	/* Busy check is done at next transmission */
 }
 
+/*-----------------------------------------------------------------------*/
+/* Stream a data packet from the Apple II straight to MMC (DAN][)        */
+/*-----------------------------------------------------------------------*/
+
+/* The data token is sent first, then each byte received from the 82C55
+   goes directly into the SPI data register, while the Apple II prepares
+   the next one. The 512 bytes are always consumed from the Apple II: when
+   the card is not ready, or token is 0, the block is just discarded. */
+
+static
+int xmit_datastream (
+	BYTE token			/* Data token, 0: discard the data */
+)
+{
+	BYTE d, resp;
+	UINT cnt = 512;
+
+	if (token && !wait_ready(500)) token = 0;	/* Leading busy check */
+	if (token) xchg_spi(token);			/* Xmit data token */
+
+	do {
+		while (READ_OBFA() != 0) {};
+		ACK_LOW();
+		d = READ_DATAPORT();
+		if (token) SPDR = d;				/* Data */
+		ACK_HIGH();
+		if (token) loop_until_bit_is_set(SPSR, SPIF);
+	} while (--cnt);
+	if (!token) return 0;
+
+	xchg_spi_FF(); xchg_spi_FF();		/* Dummy CRC */
+
+	resp = xchg_spi_FF();				/* Receive data resp */
+
+	mmc_busy = (xchg_spi_FF() != 0xff);	/* after each write: remember MMC busy state */
+
+	return (resp & 0x1F) == 0x05 ? 1 : 0;	/* Data was accepted or not */
+}
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Send a command packet to MMC                                          */
 /*-----------------------------------------------------------------------*/
@@ -431,13 +552,15 @@ DSTATUS mmc_disk_status (void)
 /* Read Sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
 
-DRESULT mmc_disk_read (
-	BYTE *buff,			/* Pointer to the data buffer to store read data */
+static BYTE read_cmd; /* command of the current read transfer (CMD17/CMD18) */
+
+/* Start reading sectors: the data blocks are then fetched one by one with
+   mmc_disk_read_next. The card stays selected until mmc_disk_read_stop. */
+DRESULT mmc_disk_read_start (
 	LBA_t sector,		/* Start sector number (LBA) */
-	UINT count			/* Sector count (1..128) */
+	UINT count			/* Sector count */
 )
 {
-	BYTE cmd;
 	DWORD sect = (DWORD)sector;
 
 	if (!count) return RES_PARERR;
@@ -447,15 +570,70 @@ DRESULT mmc_disk_read (
 
 	if (!(CardType[slotno] & CT_BLOCK)) sect *= 512;	/* Convert to byte address if needed */
 
-	cmd = count > 1 ? CMD18 : CMD17;			/*  READ_MULTIPLE_BLOCK : READ_SINGLE_BLOCK */
-	if (send_cmd(cmd, sect) == 0) {
-		do {
-			if (!rcvr_datablock(buff, 512)) break;
-			buff += 512;
-		} while (--count);
-		if (cmd == CMD18) send_cmd(CMD12, 0);	/* STOP_TRANSMISSION */
+	read_cmd = count > 1 ? CMD18 : CMD17;		/*  READ_MULTIPLE_BLOCK : READ_SINGLE_BLOCK */
+	if (send_cmd(read_cmd, sect) != 0) {
+		deselect();
+		return RES_ERROR;
 	}
+	return RES_OK;
+}
+
+/* Receive the next data block of the current read transfer. A NULL buffer
+   streams the block to the Apple II instead (see rcvr_datastream). */
+DRESULT mmc_disk_read_next (
+	BYTE *buff			/* Pointer to the 512 byte data buffer or NULL */
+)
+{
+	if (!buff) return rcvr_datastream(512);
+	return rcvr_datablock(buff, 512) ? RES_OK : RES_ERROR;
+}
+
+/* Receive the next data block of the current read transfer, unless the
+   Apple II sends a command meanwhile (see rcvr_datablock_idle). Aborting
+   a single block read is only safe with CMD18 (stopped with CMD12). */
+DRESULT mmc_disk_read_idle (
+	BYTE *buff			/* Pointer to the 512 byte data buffer */
+)
+{
+	return rcvr_datablock_idle(buff, 512);
+}
+
+/* Release the SPI bus between two blocks of a CMD18 transfer, so other
+   SPI devices (W5500) can be accessed. The card keeps the transfer open. */
+void mmc_disk_read_pause (void)
+{
 	deselect();
+}
+
+/* Continue a paused read transfer. No select(): the card is not "ready"
+   (0xFF) but may already be sending the next data token. */
+void mmc_disk_read_resume (void)
+{
+	MMC_SPI_MODE(); // restore our preferred SPI setting
+	CS_LOW();
+}
+
+/* Terminate the current read transfer */
+void mmc_disk_read_stop (void)
+{
+	if (read_cmd == CMD18) send_cmd(CMD12, 0);	/* STOP_TRANSMISSION */
+	deselect();
+}
+
+DRESULT mmc_disk_read (
+	BYTE *buff,			/* Pointer to the data buffer to store read data */
+	LBA_t sector,		/* Start sector number (LBA) */
+	UINT count			/* Sector count (1..128) */
+)
+{
+	DRESULT res = mmc_disk_read_start(sector, count);
+
+	if (res != RES_OK) return res;
+	do {
+		if (mmc_disk_read_next(buff) != RES_OK) break;
+		buff += 512;
+	} while (--count);
+	mmc_disk_read_stop();
 
 	return count ? RES_ERROR : RES_OK;
 }
@@ -466,10 +644,16 @@ DRESULT mmc_disk_read (
 /* Write Sector(s)                                                       */
 /*-----------------------------------------------------------------------*/
 
-DRESULT mmc_disk_write (
-	const BYTE *buff,	/* Pointer to the data to be written */
+static BYTE write_cmd; /* command of the current write transfer (CMD24/CMD25) */
+
+/* Start writing sectors: the data blocks are then sent one by one with
+   mmc_disk_write_next. The card stays selected until mmc_disk_write_stop.
+   Pre-erasing leaves sectors, which are not written after all, undefined:
+   only request it when the transfer is never stopped early. */
+DRESULT mmc_disk_write_start (
 	LBA_t sector,		/* Start sector number (LBA) */
-	UINT count			/* Sector count (1..128) */
+	UINT count,			/* Sector count */
+	BYTE preerase		/* Pre-erase the sectors (SDC, multiple block write) */
 )
 {
 	DWORD sect = (DWORD)sector;
@@ -482,23 +666,77 @@ DRESULT mmc_disk_write (
 
 	if (!(CardType[slotno] & CT_BLOCK)) sect *= 512;	/* Convert to byte address if needed */
 
-	if (count == 1) {	/* Single block write */
-		if ((send_cmd(CMD24, sect) == 0)	/* WRITE_BLOCK */
-			&& xmit_datablock(buff, 0xFE)) {
-			count = 0;
-		}
+	write_cmd = CMD24;								/* WRITE_BLOCK */
+	if (count > 1) {								/* Multiple block write */
+		if (preerase && (CardType[slotno] & CT_SDC)) send_cmd(ACMD23, count);	/* Pre-erase the sectors */
+		write_cmd = CMD25;							/* WRITE_MULTIPLE_BLOCK */
 	}
-	else {				/* Multiple block write */
-		if (CardType[slotno] & CT_SDC) send_cmd(ACMD23, count);
-		if (send_cmd(CMD25, sect) == 0) {	/* WRITE_MULTIPLE_BLOCK */
-			do {
-				if (!xmit_datablock(buff, 0xFC)) break;
-				buff += 512;
-			} while (--count);
-			if (!xmit_datablock(0, 0xFD)) count = 1;	/* STOP_TRAN token */
-		}
+	if (send_cmd(write_cmd, sect) != 0) {
+		deselect();
+		write_cmd = 0;								/* No transfer in progress */
+		return RES_ERROR;
 	}
+	return RES_OK;
+}
+
+/* Send the next data block of the current write transfer. A NULL buffer
+   streams the block from the Apple II instead (see xmit_datastream); without
+   a write transfer in progress the received block is discarded. */
+DRESULT mmc_disk_write_next (
+	const BYTE *buff	/* Pointer to the 512 byte data block or NULL */
+)
+{
+	BYTE token = (write_cmd == CMD25) ? 0xFC : 0xFE;
+
+	if (!buff) return xmit_datastream(write_cmd ? token : 0) ? RES_OK : RES_ERROR;
+	return xmit_datablock(buff, token) ? RES_OK : RES_ERROR;
+}
+
+/* Release the SPI bus between two blocks of a CMD25 transfer. The card
+   continues programming the previous block (and keeps mmc_busy set). */
+void mmc_disk_write_pause (void)
+{
 	deselect();
+}
+
+/* Continue a paused write transfer: the busy check is done by the next
+   data block (see xmit_datablock). */
+void mmc_disk_write_resume (void)
+{
+	MMC_SPI_MODE(); // restore our preferred SPI setting
+	CS_LOW();
+}
+
+/* Terminate the current write transfer */
+DRESULT mmc_disk_write_stop (void)
+{
+	DRESULT res = RES_OK;
+
+	if (write_cmd == CMD25)
+	{
+		if (!xmit_datablock(0, 0xFD)) res = RES_ERROR;	/* STOP_TRAN token */
+		mmc_busy = (xchg_spi_FF() != 0xff);	/* the card programs the last block(s) after the token */
+	}
+	deselect();
+	write_cmd = 0;									/* No transfer in progress */
+
+	return res;
+}
+
+DRESULT mmc_disk_write (
+	const BYTE *buff,	/* Pointer to the data to be written */
+	LBA_t sector,		/* Start sector number (LBA) */
+	UINT count			/* Sector count (1..128) */
+)
+{
+	DRESULT res = mmc_disk_write_start(sector, count, 1);
+
+	if (res != RES_OK) return res;
+	do {
+		if (mmc_disk_write_next(buff) != RES_OK) break;
+		buff += 512;
+	} while (--count);
+	if (mmc_disk_write_stop() != RES_OK) count = 1;
 
 	return count ? RES_ERROR : RES_OK;
 }
@@ -20,7 +20,7 @@
 */
 #pragma once
 
-typedef enum {FTP_DISABLED=-1, FTP_NOT_INITIALIZED=0, FTP_INITIALIZED=1, FTP_CONNECTED=2} TFtpState;
+typedef enum {FTP_DISABLED=-1, FTP_NOT_INITIALIZED=0, FTP_INITIALIZED=1, FTP_CONNECTED=2, FTP_TRANSFER=3} TFtpState;
 
 extern byte   FtpMacIpPortData[]; // 6 bytes MAC address, 4 bytes IPv4 address
 extern int8_t FtpState;
@@ -23,10 +23,11 @@
 #include "config.h"
 #include "fwversion.h"
 #include "Apple2Arduino.h"
+#include "dan2trace.h"
 
 #ifdef USE_FTP
 
-#ifdef FEATURE_CUSTOM_ETHERNET_LIBRARY
+#if defined(FEATURE_CUSTOM_ETHERNET_LIBRARY) && !defined(DAN2_HOST)
 // We use a customized Ethernet library - forked from the original sources.
 // This saves a lot of memory, since we can remove a lot of unused stuff.
 // And we simply inline the entire Ethernet driver sources... :)
@@ -34,6 +35,7 @@
 #include "EthernetLib/Ethernet.cpp"
 #else
 // use stock Arduino library. Needs a lot more memory. May still be useful for future comparisons.
+// (The host build in ../hostsim provides an <Ethernet.h> based on sockets instead.)
 #include <Ethernet.h>
 #endif
 
@@ -54,6 +56,21 @@
 /* Timeout after which stale data connections are terminated. */
 #define FTP_TRANSMIT_TIMEOUT 5000
 
+/* Maximum number of blocks sent by one RETR step (as one multi-block SD card read) */
+#define FTP_RETR_BURST          8
+
+/* Maximum number of blocks received by one STOR step (as one multi-block SD card write) */
+#define FTP_STOR_BURST          8
+
+/* Sparse volume files (VOLxx.SPR): header, then records of (first block, block count) each followed
+ * by the blocks' data, terminated by a record with block count 0. All values are 16bit little-endian. */
+#define FTP_SPARSE_MAGIC     0x50533244UL // header: magic "D2SP", number of volume blocks, reserved
+#define FTP_SPARSE_HEADER_SIZE    8
+#define FTP_SPARSE_RECORD_SIZE    4
+
+/* W5500 socket status: the client has closed its side of the connection */
+#define FTP_SOCK_CLOSE_WAIT  0x1C
+
 /* Ethernet and MAC address ********************************************************************************/
 // MAC+IP+Port address all packed into one compact data structure, to simplify configuration
 byte FtpMacIpPortData[] = { FTP_MAC_ADDRESS, FTP_IP_ADDRESS, FTP_DATA_PORT>>8, FTP_DATA_PORT&0xff };
@@ -62,7 +79,16 @@ byte FtpMacIpPortData[] = { FTP_MAC_ADDRESS, FTP_IP_ADDRESS, FTP_DATA_PORT>>8, F
 
 /* Ethernet servers and clients ****************************************************************************/
 EthernetServer FtpCmdServer(FTP_CMD_PORT);
+#if defined(FEATURE_CUSTOM_ETHERNET_LIBRARY) || defined(DAN2_HOST)
+// data connections use the sockets with the large W5500 buffers - and do not wait for each packet to be sent
+EthernetServer FtpDataServer(FTP_DATA_PORT, true);
+#define FTP_DATA_WRITE(buf, size) FtpDataClient.writeQueued(buf, size)
+#define FTP_DATA_PENDING()        FtpDataClient.sendPending()
+#else
 EthernetServer FtpDataServer(FTP_DATA_PORT);
+#define FTP_DATA_WRITE(buf, size) FtpDataClient.write(buf, size)
+#define FTP_DATA_PENDING()        false
+#endif
 EthernetClient FtpCmdClient;
 EthernetClient FtpDataClient;
 
@@ -79,12 +105,9 @@ EthernetClient FtpDataClient;
 #define FTP_CMD_CDUP  8
 #define FTP_CMD_RETR  9
 #define FTP_CMD_STOR 10
-#define FTP_CMD_PORT 11
+#define FTP_CMD_ID_PORT 11 // not FTP_CMD_PORT: that is the command port setting (config.h)
 #define FTP_CMD_PWD  12
 
-// offset of the PRODOS volume header
-#define PRODOS_VOLUME_HEADER   0x400
-
 /* Matching FTP Command strings (4byte per command) */
 const char FtpCommandList[] PROGMEM = "USER" "PASS" "SYST" "CWD " "TYPE" "QUIT" "PASV" "LIST" "CDUP" "RETR" "STOR" "PORT" "PWD\x00";
                                        //"RNFR" "RNTO" "EPSV SIZE DELE MKD RMD"
@@ -92,6 +115,21 @@ const char FtpCommandList[] PROGMEM = "USER" "PASS" "SYST" "CWD " "TYPE" "QUIT"
 /* Data types *********************************************************************************************/
 typedef enum {DIR_SDCARD1=0, DIR_SDCARD2=1, DIR_ROOT=2} TFtpDirectory;
 
+// Data transfers are split into small steps (one directory entry or one block per loopTinyFtp() call),
+// so the Apple II commands are processed in between.
+typedef enum {FTP_XFER_ACCEPT=0, // waiting for the client to open the passive data connection
+              FTP_XFER_LIST=1,   // sending the directory listing
+              FTP_XFER_RETR=2,   // sending a volume
+              FTP_XFER_STOR=3,   // receiving a volume
+              FTP_XFER_CLOSE=4   // giving the client time to receive the data, before closing the connection
+} TFtpTransfer;
+
+// Sparse volume files only contain the blocks allocated in the ProDOS volume bitmap
+typedef enum {FTP_SPARSE_NONE=0,   // plain volume file (VOLxx.PO)
+              FTP_SPARSE_HEADER=1, // sparse volume file: header not transferred yet
+              FTP_SPARSE_RUNS=2    // sparse volume file: transferring records
+} TFtpSparse;
+
 //                                          "-rw------- 1 volume: 123456789abcdef 12345678 Jun 10 1977 VOL01.PO\r\n"
 const char FILE_TEMPLATE[]        PROGMEM = "-rw------- 1 volume: ---             12345678 Jun 10 1977 VOL01.PO\r\n";
 #define FILE_TEMPLATE_LENGTH      (sizeof(FILE_TEMPLATE)-1)
@@ -99,6 +137,11 @@ const char FILE_TEMPLATE[]        PROGMEM = "-rw------- 1 volume: ---
 const char DIR_TEMPLATE[]         PROGMEM = "drwx------ 1 DAN][ FAT 1 Jun 10 1977 SD1\r\n";
 #define DIR_TEMPLATE_LENGTH       (sizeof(DIR_TEMPLATE)-1)
 
+#ifdef USE_TRACE
+const char TRACE_TEMPLATE[]       PROGMEM = "-r-------- 1 DAN][ trace 12345 Jun 10 1977 TRACE.BIN\r\n";
+#define TRACE_TEMPLATE_LENGTH     (sizeof(TRACE_TEMPLATE)-1)
+#endif
+
 const char ROOT_DIR_TEMPLATE[]    PROGMEM = "257 \"/SD1\"";
 #define ROOT_DIR_TEMPLATE_LENGTH  (sizeof(ROOT_DIR_TEMPLATE)-1)
 
@@ -128,6 +171,15 @@ struct
   uint8_t CmdId;        // current FTP command
   uint8_t Directory;    // current working directory
   char    CmdData[8];   // must just be large enough to hold file names (just for the first 8 bytes of 8.3 filenames)
+  uint8_t Transfer;     // current step of the data transfer (FtpState == FTP_TRANSFER)
+  uint8_t FileNo;       // data transfer: volume file number
+  uint16_t ReplyCode;   // data transfer: reply sent once the data connection is closed
+  uint32_t BlkNum;      // data transfer: next block
+  uint32_t FileBlocks;  // data transfer: number of blocks
+  uint32_t RunEnd;      // data transfer: end of the current run of contiguous blocks
+  uint8_t  Sparse;      // data transfer: sparse volume file (TFtpSparse)
+  uint16_t BitmapBlk;   // data transfer: first block of the ProDOS volume bitmap (sparse RETR)
+  unsigned long Timeout;// data transfer: deadline of the current step
 } Ftp;
 
 int8_t  FtpState = FTP_NOT_INITIALIZED;
@@ -255,27 +307,24 @@ void ftpSendReply(char* buf, uint16_t code)
   ftpCmdReply(buf, sz);
 }
 
-// wait and accept for an incomming data connection
-bool ftpAcceptDataConnection(bool Cleanup=false)
+// accept an incomming data connection (does not wait)
+bool ftpAcceptDataConnection(void)
 {
-  uint16_t Timeout = (Cleanup) ? 10 : FTP_PASV_TIMEOUT;
-  for (uint16_t i=0;i<Timeout;i++)
+  FtpDataClient = FtpDataServer.accept();
+  if (FtpDataClient.connected())
   {
-    FtpDataClient = FtpDataServer.accept();
-    if (FtpDataClient.connected())
-    {
-      FTP_DEBUG_PRINTLN(F("new"));
-      if (Cleanup)
-        FtpDataClient.stop();
-      else
-        FtpDataClient.setConnectionTimeout(5000);
-      return true;
-    }
-    delay(1);
+    FTP_DEBUG_PRINTLN(F("new"));
+    return true;
   }
   return false;
 }
 
+// check if the deadline of the current transfer step has passed
+static bool ftpTimeout(void)
+{
+  return ((long) (millis()-Ftp.Timeout) >= 0);
+}
+
 bool ftpSelectFile(uint8_t fileno, uint32_t* pFileBlockCount)
 {
   if (Ftp.Directory == DIR_ROOT)
@@ -292,7 +341,7 @@ bool ftpSelectFile(uint8_t fileno, uint32_t* pFileBlockCount)
   if (slot_type[request.sdslot] == SLOT_TYPE_RAW)
     FileBlockCount = 65536; // fixed maximum volume size
   else
-    FileBlockCount = (f_size(&current_file) >> 9); // size of the DOS file
+    FileBlockCount = (f_size(current_file) >> 9); // size of the DOS file
   if (FileBlockCount > 65536)
     FileBlockCount = 65536;
   *pFileBlockCount = FileBlockCount;
@@ -305,48 +354,8 @@ static void file_seek(uint32_t blknum)
   request.blk = blknum;
 }
 
-// obtains volume name and block count
-uint32_t getProdosVolumeInfo(uint8_t* ProdosHeader, char* pVolName, uint32_t FileBlocks)
-{
-  // read PRODOS volume name from header
-  file_seek(PRODOS_VOLUME_HEADER>>9);
-
-  if (pVolName)
-    pVolName[0] = 0; // volume name (still) invalid
-
-  if (0==vol_read_block(ProdosHeader))
-  {
-    uint8_t len = ProdosHeader[4] ^ 0xf0; // top 4 bits must be set for PRODOS volume name lengths
-    uint16_t ProdosDirLenEntry = *((uint16_t*)&ProdosHeader[0x23]);
-
-    if ((ProdosDirLenEntry == 0x0D27)&& // check entry length/entries per block=$27/$0D
-        (len <= 0xf))                   // valid length field?
-    {
-      // write 15 ASCII characters with PRODOS volume name
-      if (pVolName)
-      {
-        for (uint8_t i=0;i<15;i++)
-        {
-          char ascii = ProdosHeader[5+i];
-          if ((i>=len)||(ascii<' ')||(ascii>'z'))
-            ascii=' ';
-          pVolName[i] = ascii;
-        }
-      }
-
-      // get PRODOS volume size
-      uint16_t ProdosBlocks = ProdosHeader[0x2A];
-      ProdosBlocks <<= 8;
-      ProdosBlocks |= ProdosHeader[0x29];
-      // report PRODOS volume size (unless physical block device file is smaller)
-      if (ProdosBlocks < FileBlocks)
-        FileBlocks = ProdosBlocks;
-    }
-  }
-  return FileBlocks;
-}
-
-void ftpHandleDirectory(char* buf)
+// send the root directory, or the next entry of a volume directory: returns FTP reply code when complete, 0 otherwise
+uint16_t ftpHandleDirectory(char* buf)
 {
   if (Ftp.Directory == DIR_ROOT)
   {
@@ -369,146 +378,368 @@ void ftpHandleDirectory(char* buf)
           buf[pos-2-1] = '2'; // patch '1'=>'2' for SD2
       }
     }
+#ifdef USE_TRACE
+    // virtual file with the trace of the Apple II commands
+    strReadProgMem(&buf[pos], TRACE_TEMPLATE);
+    strPrintInt(&buf[pos+25], trace_size(), 10000, ' ');
+    pos += TRACE_TEMPLATE_LENGTH;
+#endif
     FtpDataClient.write(buf, pos);
+    return 226; // Listed.
   }
-  else
-  {
-    // iterate over possible file names: VOLXX.PO
-    for (uint8_t fno=0;fno<FTP_MAX_VOL_FILES;fno++)
-    {
-      uint32_t FileBlocks;
-      if (ftpSelectFile(fno, &FileBlocks))
-      {
-        // read PRODOS volume name from header
-        char VolName[16];
-        for (uint8_t i=0;i<16;i++) VolName[i] = ' ';
-        FileBlocks = getProdosVolumeInfo((uint8_t*) buf, VolName, FileBlocks);
 
-        if (VolName[0])
-        {
-          strReadProgMem(buf, FILE_TEMPLATE);
+  // one possible file name per call: VOLXX.PO
+  uint8_t fno = Ftp.FileNo++;
+  uint32_t FileBlocks;
+  char VolName[16];
+  request.sdslot  = Ftp.Directory;
+  request.filenum = fno;
+  CHECK_MEM(1010);
+  vol_get_volume_name((uint8_t*) buf, VolName, &FileBlocks);
 
-          buf[FILE_TEMPLATE_LENGTH-7] = hex_digit(fno>>4);
-          buf[FILE_TEMPLATE_LENGTH-6] = hex_digit(fno);
+  if (VolName[0])
+  {
+    strReadProgMem(buf, FILE_TEMPLATE);
 
-          // update volume name
-          memcpy(&buf[21], VolName, 15);
+    buf[FILE_TEMPLATE_LENGTH-7] = hex_digit(fno>>4);
+    buf[FILE_TEMPLATE_LENGTH-6] = hex_digit(fno);
 
-          // update file size
-          strPrintInt(&buf[37], FileBlocks<<9, 10000000, ' ');
+    // update volume name
+    memcpy(&buf[21], VolName, 15);
 
-          // send directory entry
-          FtpDataClient.write(buf, FILE_TEMPLATE_LENGTH);
-        }
-      }
-    }
+    // update file size
+    strPrintInt(&buf[37], FileBlocks<<9, 10000000, ' ');
+
+    // send directory entry
+    if (FtpDataClient.write(buf, FILE_TEMPLATE_LENGTH) != FILE_TEMPLATE_LENGTH)
+      return 426; // failed, connection aborted...
   }
+  return (Ftp.FileNo >= FTP_MAX_VOL_FILES) ? 226 : 0;
 }
 
-// receive or send file data: return FTP reply code
-uint16_t ftpHandleFileData(uint8_t* buf, uint8_t fileno, bool Read)
+// prepare sending or receiving a volume file: return FTP reply code on errors, 0 otherwise
+uint16_t ftpStartFileData(uint8_t* buf, uint8_t fileno, bool Read, bool Sparse)
 {
-  uint32_t FileBlocks;
-  if (!ftpSelectFile(fileno, &FileBlocks))
+  if (!ftpSelectFile(fileno, &Ftp.FileBlocks))
   {
     FTP_DEBUG_PRINTLN(F("nofile"));
     return 550;
   }
 
-  uint32_t blknum = 0;
+  Ftp.FileNo = fileno;
+  Ftp.BlkNum = 0;
+  // plain volume files are a single run of blocks, sparse files start with their header
+  Ftp.RunEnd = (Sparse) ? 0 : Ftp.FileBlocks;
+  Ftp.Sparse = (Sparse) ? FTP_SPARSE_HEADER : FTP_SPARSE_NONE;
   if (Read)
   {
     // obtain ProDOS file size for reading
-    FileBlocks = getProdosVolumeInfo(buf, NULL, FileBlocks);
-    // read from disk and send to remote
     // we only send the data for the ProDOS drive - the physical VOLxx.PO file may be larger...
-    while (blknum < FileBlocks)
+    Ftp.FileBlocks = vol_get_prodos_info(buf, NULL, Ftp.FileBlocks, &Ftp.BitmapBlk);
+    if (!Sparse)
+      Ftp.RunEnd = Ftp.FileBlocks;
+    else
+    if ((Ftp.BitmapBlk == 0)||(Ftp.BitmapBlk + ((Ftp.FileBlocks+4095)>>12) > Ftp.FileBlocks))
+      return 550; // not a ProDOS volume: no bitmap
+    Ftp.Transfer = FTP_XFER_RETR;
+  }
+  else
+  {
+#ifdef USE_BLOCK_CACHE
+    vol_cache_invalidate();
+#endif
+    Ftp.Transfer = FTP_XFER_STOR;
+  }
+  return 0;
+}
+
+// check whether a block is free in the ProDOS volume bitmap block (buf)
+static bool ftpBlockIsFree(uint8_t* buf, uint32_t blk)
+{
+  return (buf[(blk >> 3) & 0x1FF] & (0x80 >> (blk & 7)));
+}
+
+// send the header or the next record of a sparse volume file: return FTP reply code when complete, 0 otherwise
+uint16_t ftpSendSparseRecord(uint8_t* buf)
+{
+  uint8_t  Record[FTP_SPARSE_HEADER_SIZE];
+  uint8_t  Size  = FTP_SPARSE_RECORD_SIZE;
+  uint16_t First = 0; // header: number of volume blocks
+  uint16_t Count = 0; // 0: end of the sparse file
+
+  if (Ftp.Sparse == FTP_SPARSE_HEADER)
+  {
+    *((uint32_t*) Record) = FTP_SPARSE_MAGIC;
+    First = Ftp.FileBlocks;
+    Size  = FTP_SPARSE_HEADER_SIZE;
+  }
+  else
+  if (Ftp.BlkNum < Ftp.FileBlocks)
+  {
+    // find the next run of allocated blocks within the bitmap block covering the next block
+    uint32_t FileBlocks;
+    if (!ftpSelectFile(Ftp.FileNo, &FileBlocks))
+      return 451; // I/O error
+    file_seek(Ftp.BitmapBlk + (Ftp.BlkNum >> 12));
+    if (vol_read_uncached(buf) != PRODOS_OK) // keeps the Apple II's blocks in the block cache
+      return 451; // I/O error
+
+    uint32_t End = (Ftp.BlkNum | 0xFFF) + 1;
+    if (End > Ftp.FileBlocks)
+      End = Ftp.FileBlocks;
+    uint32_t Blk = Ftp.BlkNum;
+    while ((Blk < End)&&(ftpBlockIsFree(buf, Blk)))
+      Blk++;
+    First = Blk;
+    while ((Blk < End)&&(!ftpBlockIsFree(buf, Blk)))
+      Blk++;
+    Count = Blk - First;
+
+    Ftp.Timeout = millis()+FTP_TRANSMIT_TIMEOUT;
+    Ftp.RunEnd  = Blk;
+    if (Count == 0)
     {
-      file_seek(blknum);
-      if (vol_read_block(buf) != PRODOS_OK)
-        return 451; // I/O error
-      blknum++;
-      CHECK_MEM(1020);
-      if (FtpDataClient.write(buf, 512) != 512)
-      {
-        return 426; // failed, connection aborted...
-      }
+      // nothing allocated in this part of the bitmap: continue with the next bitmap block
+      Ftp.BlkNum = Blk;
+      return 0;
     }
+    Ftp.BlkNum = First;
   }
-  else
+
+  Record[Size-4] = First & 0xFF;
+  Record[Size-3] = First >> 8;
+  Record[Size-2] = Count & 0xFF;
+  Record[Size-1] = Count >> 8;
+  if (FTP_DATA_WRITE(Record, Size) != Size)
+    return 426; // failed, connection aborted...
+  if (Ftp.Sparse == FTP_SPARSE_HEADER)
   {
-    // receive remote data and write to disk
-    uint16_t TcpBytes=0;
-    uint16_t BufOffset=0;
-    long Timeout = 0;
+    Ftp.Sparse = FTP_SPARSE_RUNS;
+    return 0;
+  }
+  return (Count) ? 0 : 226;
+}
+
+// read the next blocks from disk and send them to remote: return FTP reply code when complete, 0 otherwise
+uint16_t ftpSendBlock(uint8_t* buf)
+{
+  // issue the SEND for data queued by the previous step
+  FTP_DATA_PENDING();
+
+  if ((Ftp.BlkNum >= Ftp.RunEnd)&&(Ftp.Sparse == FTP_SPARSE_NONE))
+    return 226; // file transfer successful
+
+  // only read as many blocks as the Wiznet can take without waiting
+  uint16_t Free = FtpDataClient.availableForWrite();
+  if (Free < 512)
+  {
+    if ((!FtpDataClient.connected())||(ftpTimeout()))
+      return 426; // failed, connection aborted...
+    return 0;
+  }
+
+  // sparse volume files: header and records between the runs of blocks
+  if (Ftp.BlkNum >= Ftp.RunEnd)
+    return ftpSendSparseRecord(buf);
+
+  uint8_t Count = FTP_RETR_BURST;
+  if (Count > (Free >> 9))
+    Count = Free >> 9;
+  if (Count > Ftp.RunEnd - Ftp.BlkNum)
+    Count = Ftp.RunEnd - Ftp.BlkNum;
 
-    while ((Timeout == 0)||(((long) (millis()-Timeout))<0))
+  // Apple II commands may have selected another file since the last step
+  uint32_t FileBlocks;
+  if (!ftpSelectFile(Ftp.FileNo, &FileBlocks))
+    return 451; // I/O error
+  file_seek(Ftp.BlkNum);
+
+  // read the blocks with a single multi-block SD card command (as long as they are contiguous)
+  uint16_t ReplyCode = 0;
+  if (vol_read_start(Count) != PRODOS_OK)
+    return 451; // I/O error
+  do
+  {
+    if (vol_read_next(buf) != PRODOS_OK)
     {
-      if (TcpBytes == 0)
-      {
-        mmc_wait_busy_spi(); // check recent f_write is completed/SPI released
-        TcpBytes = FtpDataClient.available();
-        if (TcpBytes == 0)
-        {
-          if (!FtpDataClient.connected())
-          {
-            FTP_DEBUG_PRINTLN(F("discon"));
-            FTP_DEBUG_PRINTLN(FtpDataClient.status());
-            CHECK_MEM(1030);
-            break;
-          }
-        }
-      }
-      while (TcpBytes)
-      {
-        mmc_wait_busy_spi(); // check recent f_write is completed/SPI released
-        size_t sz = (BufOffset+TcpBytes > FTP_BUF_SIZE) ? FTP_BUF_SIZE-BufOffset : TcpBytes;
-        int rd = FtpDataClient.read((uint8_t*) &buf[BufOffset], sz);
-        CHECK_MEM(1040);
-        if (rd>0)
-        {
-          // reset timeout when data was received
-          Timeout = 0;
-
-          BufOffset += rd;
-          TcpBytes-=rd;
-          if (BufOffset >= FTP_BUF_SIZE)
-          {
-            if (blknum >= FileBlocks)
-              return 552; // file too large
-
-            // write block to disk
-            file_seek(blknum);
-            if (vol_write_block(buf) != PRODOS_OK)
-            {
-              FTP_DEBUG_PRINTLN(F("badwr"));
-              return 451; // I/O error
-            }
-            blknum++;
-            BufOffset = 0;
-          }
-        }
-      }
-      // calculate new timeout when necessary
-      if (!Timeout)
-      {
-        Timeout = millis()+FTP_TRANSMIT_TIMEOUT;
-      }
+      ReplyCode = 451; // I/O error
+      break;
     }
-    if (BufOffset>0)
+    Ftp.BlkNum++;
+    CHECK_MEM(1020);
+    // the SD card and the Wiznet share the SPI bus
+    vol_read_pause();
+    uint16_t sz = FTP_DATA_WRITE(buf, 512);
+    vol_read_resume();
+    if (sz != 512)
     {
-      if (blknum >= FileBlocks)
-        return 552; // file too large
-      file_seek(blknum);
-      if (vol_write_block(buf) != PRODOS_OK)
-      {
-        return 451; // I/O error
-      }
+      ReplyCode = 426; // failed, connection aborted...
+      break;
     }
+  } while ((--Count)&&(READ_OBFA() != 0)); // stop early when the Apple II sent a command
+  vol_read_stop();
+
+  Ftp.Timeout = millis()+FTP_TRANSMIT_TIMEOUT;
+  return ReplyCode;
+}
+
+// receive complete blocks from remote and write them to disk with a single multi-block SD card write
+uint16_t ftpReceiveBurst(uint8_t* buf, uint8_t Count)
+{
+  if (Ftp.BlkNum >= Ftp.RunEnd)
+    return 552; // file too large
+  if (Count > Ftp.RunEnd - Ftp.BlkNum)
+    Count = Ftp.RunEnd - Ftp.BlkNum;
+
+  uint32_t FileBlocks;
+  if (!ftpSelectFile(Ftp.FileNo, &FileBlocks))
+    return 451; // I/O error
+  file_seek(Ftp.BlkNum);
+
+  // The blocks are already in the Wiznet's buffer. The burst is stopped early when the Apple II sent a command,
+  // so the sectors are not pre-erased: blocks which are not written keep their previous content.
+  uint16_t ReplyCode = 0;
+  if (vol_write_start(Count, false) != PRODOS_OK)
+    return 451; // I/O error
+  do
+  {
+    // the SD card and the Wiznet share the SPI bus
+    vol_write_pause();
+    mmc_wait_busy_spi(); // wait until the SD card has programmed the previous block
+    int rd = FtpDataClient.read(buf, 512);
+    vol_write_resume();
+    CHECK_MEM(1040);
+    if (rd != 512)
+    {
+      ReplyCode = 426; // failed, connection aborted...
+      break;
+    }
+    if (vol_write_next(buf) != PRODOS_OK)
+    {
+      FTP_DEBUG_PRINTLN(F("badwr"));
+      ReplyCode = 451; // I/O error
+      break;
+    }
+    Ftp.BlkNum++;
+  } while ((--Count)&&(READ_OBFA() != 0)); // stop early when the Apple II sent a command
+  vol_write_stop();
+
+  Ftp.Timeout = millis()+FTP_TRANSMIT_TIMEOUT;
+  return ReplyCode;
+}
+
+// receive the header or the next record of a sparse volume file: return FTP reply code when complete, 0 otherwise
+uint16_t ftpReceiveSparseRecord(uint8_t* buf, int Avail, bool Closed)
+{
+  uint8_t Size = (Ftp.Sparse == FTP_SPARSE_HEADER) ? FTP_SPARSE_HEADER_SIZE : FTP_SPARSE_RECORD_SIZE;
+  if (Avail < Size)
+    return (Closed) ? 426 : 0; // incomplete sparse file
+  if (FtpDataClient.read(buf, Size) != Size)
+    return 426; // failed, connection aborted...
+  Ftp.Timeout = millis()+FTP_TRANSMIT_TIMEOUT;
+
+  uint16_t First = buf[Size-4] | (buf[Size-3] << 8); // header: number of volume blocks
+  uint16_t Count = buf[Size-2] | (buf[Size-1] << 8); // 0: end of the sparse file
+  if (Ftp.Sparse == FTP_SPARSE_HEADER)
+  {
+    if (*((uint32_t*) buf) != FTP_SPARSE_MAGIC)
+      return 554; // not a sparse volume file
+    if (First > Ftp.FileBlocks)
+      return 552; // file too large
+    Ftp.Sparse = FTP_SPARSE_RUNS;
+    return 0;
+  }
+  if (Count == 0)
+    return 226; // file transfer successful
+  if (((uint32_t) First) + Count > Ftp.FileBlocks)
+    return 552; // file too large
+
+  // blocks outside of the runs keep their previous content
+  Ftp.BlkNum = First;
+  Ftp.RunEnd = ((uint32_t) First) + Count;
+  return 0;
+}
+
+// receive the next blocks from remote and write them to disk: return FTP reply code when complete, 0 otherwise
+uint16_t ftpReceiveBlock(uint8_t* buf)
+{
+  // check for the end of the transfer first: no more data is received afterwards
+  bool Closed = (FtpDataClient.status() == FTP_SOCK_CLOSE_WAIT)||(!FtpDataClient.connected())||(ftpTimeout());
+
+  // blocks are only read once they were completely received by the Wiznet, so nothing needs to be buffered
+  int Avail = FtpDataClient.available();
+  if ((Ftp.Sparse != FTP_SPARSE_NONE)&&(Ftp.BlkNum >= Ftp.RunEnd))
+    return ftpReceiveSparseRecord(buf, Avail, Closed);
+  if (Avail >= 512)
+  {
+    uint8_t Count = FTP_STOR_BURST;
+    if (Count > (Avail >> 9))
+      Count = Avail >> 9;
+    return ftpReceiveBurst(buf, Count);
   }
+
+  // the final partial block is written once the remote closed the connection (or stopped sending)
+  if (!Closed)
+    return 0;
+  if (Ftp.Sparse != FTP_SPARSE_NONE)
+    return 426; // sparse files only contain complete blocks: incomplete transfer
+  uint16_t sz = Avail;
+  if (sz == 0)
+  {
+    FTP_DEBUG_PRINTLN(F("discon"));
+    return 226; // file transfer successful
+  }
+  memset(&buf[sz], 0, 512-sz);
+
+  int rd = FtpDataClient.read(buf, sz);
+  CHECK_MEM(1040);
+  if (rd != (int) sz)
+    return 426; // failed, connection aborted...
+
+  if (Ftp.BlkNum >= Ftp.FileBlocks)
+    return 552; // file too large
+
+  // write block to disk
+  uint32_t FileBlocks;
+  if (!ftpSelectFile(Ftp.FileNo, &FileBlocks))
+    return 451; // I/O error
+  file_seek(Ftp.BlkNum);
+  if (vol_write_block(buf) != PRODOS_OK)
+  {
+    FTP_DEBUG_PRINTLN(F("badwr"));
+    return 451; // I/O error
+  }
+  Ftp.BlkNum++;
   return 226; // file transfer successful
 }
 
+#ifdef USE_TRACE
+// check for the trace file in the root directory (only the first characters of the name are received)
+bool ftpIsTraceFile(char* Data)
+{
+  if (Data[0]=='/')
+    Data++;
+  else
+  if (Ftp.Directory != DIR_ROOT)
+    return false;
+  return (strMatch("TRACE.", Data) != 0);
+}
+
+// send the trace file: return FTP reply code
+uint16_t ftpSendTrace(uint8_t* buf)
+{
+  uint16_t offset = 0;
+  uint16_t sz;
+  while ((sz = trace_read(buf, offset, FTP_BUF_SIZE)) > 0)
+  {
+    if (FtpDataClient.write(buf, sz) != sz)
+      return 426; // failed, connection aborted...
+    offset += sz;
+  }
+  return 226; // file transfer successful
+}
+#endif
+
 // Check the requested file name - and get the volume file number.
 // Returns  0-0xff for valid file names. 0xffff returned for bad file names.
 uint16_t getVolFileNo(char* Data)
@@ -536,6 +767,12 @@ uint16_t getVolFileNo(char* Data)
   return fno;
 }
 
+// check for a sparse volume file name (VOLxx.SPR) - only the first 7 characters are received
+bool ftpIsSparseFile(char* Data)
+{
+  return ((Data[5] == '.')&&(Data[6] == 'S'));
+}
+
 // simple command processing
 void ftpCommand(char* buf, int8_t CmdId, char* Data)
 {
@@ -591,7 +828,8 @@ void ftpCommand(char* buf, int8_t CmdId, char* Data)
     case FTP_CMD_PASV:
     {
       // sometimes, after commands have failed, we need to clean-up pending connections...
-      while (ftpAcceptDataConnection(true));
+      while (ftpAcceptDataConnection())
+        FtpDataClient.stop();
       uint8_t sz = strReadProgMem(buf, PASSIVE_MODE_REPLY);
       char* s = &buf[sz];
       for (uint8_t i=0;i<6;i++)
@@ -604,39 +842,24 @@ void ftpCommand(char* buf, int8_t CmdId, char* Data)
       ftpCmdReply(buf, (s-buf));
       break;
     }
-    case FTP_CMD_PORT:
+    case FTP_CMD_ID_PORT:
       ReplyCode = 521; // bad "active connection" attempt: use passive FTP instead
       break;
     case FTP_CMD_LIST:
     case FTP_CMD_RETR:
     case FTP_CMD_STOR:
     {
+#ifdef USE_WRITE_BACK
+      // deferred Apple II writes must be on disk, before FTP accesses the volumes
+      vol_cache_flush();
+#endif
       ftpSendReply(buf, 150);
-      if (!ftpAcceptDataConnection())
-      {
-        ReplyCode = 425; // Can't open data connection.
-      }
-      else
-      {
-        if (CmdId == FTP_CMD_LIST)
-        {
-          ftpHandleDirectory(buf);
-          ReplyCode = 226; // Listed.
-        }
-        else
-        {
-          uint16_t fno = getVolFileNo(Data);
-          if (fno > 0xFF)
-            ReplyCode = 553; // file name not allowed
-          else
-          {
-            ReplyCode = ftpHandleFileData((uint8_t*)buf, fno, (CmdId == FTP_CMD_RETR));
-            mmc_wait_busy_spi(); // check f_write is completed/SPI released
-          }
-        }
-        delay(10);
-        FtpDataClient.stop();
-      }
+      // the file name is kept until the client opened the data connection
+      if (Data != Ftp.CmdData)
+        Ftp.CmdData[0] = 0;
+      FtpState     = FTP_TRANSFER;
+      Ftp.Transfer = FTP_XFER_ACCEPT;
+      Ftp.Timeout  = millis()+FTP_PASV_TIMEOUT;
       break;
     }
     case FTP_CMD_CDUP:
@@ -667,6 +890,63 @@ void ftpCommand(char* buf, int8_t CmdId, char* Data)
     ftpSendReply(buf, ReplyCode);
 }
 
+// start the data transfer, once the client opened the data connection: return FTP reply code when complete, 0 otherwise
+uint16_t ftpStartTransfer(char* buf)
+{
+  if (!ftpAcceptDataConnection())
+  {
+    return (ftpTimeout()) ? 425 : 0; // Can't open data connection.
+  }
+  FtpDataClient.setConnectionTimeout(5000);
+  Ftp.Timeout = millis()+FTP_TRANSMIT_TIMEOUT;
+
+  if (Ftp.CmdId == FTP_CMD_LIST)
+  {
+    Ftp.FileNo   = 0;
+    Ftp.Transfer = FTP_XFER_LIST;
+    return 0;
+  }
+#ifdef USE_TRACE
+  if ((Ftp.CmdId == FTP_CMD_RETR)&&(ftpIsTraceFile(Ftp.CmdData)))
+  {
+    return ftpSendTrace((uint8_t*)buf);
+  }
+#endif
+  uint16_t fno = getVolFileNo(Ftp.CmdData);
+  if (fno > 0xFF)
+    return 553; // file name not allowed
+  return ftpStartFileData((uint8_t*)buf, fno, (Ftp.CmdId == FTP_CMD_RETR), ftpIsSparseFile(Ftp.CmdData));
+}
+
+// process the next step of the data transfer
+void ftpTransfer(char* buf)
+{
+  uint16_t ReplyCode = 0;
+  switch(Ftp.Transfer)
+  {
+    case FTP_XFER_ACCEPT: ReplyCode = ftpStartTransfer(buf); break;
+    case FTP_XFER_LIST:   ReplyCode = ftpHandleDirectory(buf); break;
+    case FTP_XFER_RETR:   ReplyCode = ftpSendBlock((uint8_t*)buf); break;
+    case FTP_XFER_STOR:   ReplyCode = ftpReceiveBlock((uint8_t*)buf); break;
+    default:
+      // all data must be sent, before the connection is closed
+      if ((ftpTimeout())&&(!FTP_DATA_PENDING()))
+      {
+        FtpDataClient.stop();
+        ftpSendReply(buf, Ftp.ReplyCode);
+        FtpState = FTP_CONNECTED;
+      }
+      break;
+  }
+  if (ReplyCode)
+  {
+    // close the data connection, then send the reply
+    Ftp.ReplyCode = ReplyCode;
+    Ftp.Transfer  = FTP_XFER_CLOSE;
+    Ftp.Timeout   = millis()+10;
+  }
+}
+
 static void ftpInit()
 {
   // IP address "0" disables the FTP server and Eth initialization completely
@@ -737,91 +1017,94 @@ void loopTinyFtp(void)
     ftpInit();
   }
 
-  do
+  if (FtpState == FTP_INITIALIZED) // initialized but not connected
   {
-    if (FtpState == FTP_INITIALIZED) // initialized but not connected
+    // accept incomming command connection
+    FtpCmdClient = FtpCmdServer.accept();
+    if (FtpCmdClient.connected())
     {
-      // accept incomming command connection
-      FtpCmdClient = FtpCmdServer.accept();
-      if (FtpCmdClient.connected())
-      {
-        FTP_DEBUG_PRINTLN(F("FTP con"));
-        FtpState  = FTP_CONNECTED;
-        // FTP welcome
-        ftpSendReply(buf, 220);
-        // expect new command
-        Ftp.CmdBytes = 0;
-        // always start in root directory
-        Ftp.Directory = DIR_ROOT;
-      }
+      FTP_DEBUG_PRINTLN(F("FTP con"));
+      FtpState  = FTP_CONNECTED;
+      // FTP welcome
+      ftpSendReply(buf, 220);
+      // expect new command
+      Ftp.CmdBytes = 0;
+      // always start in root directory
+      Ftp.Directory = DIR_ROOT;
+    }
+  }
+  else
+  if (FtpState == FTP_TRANSFER)
+  {
+    ftpTransfer(buf);
+  }
+  else
+  if (FtpState == FTP_CONNECTED)
+  {
+    if (!FtpCmdClient.connected())
+    {
+      FTP_DEBUG_PRINTLN(F("FTP dis"));
+      // give the remote client time to receive the data
+      delay(10);
+      FtpCmdClient.stop();
+      FtpState = FTP_INITIALIZED;
     }
     else
-    if (FtpState == FTP_CONNECTED)
+    if (FtpCmdClient.available())
     {
-      if (!FtpCmdClient.connected())
+      // one command byte per call
+      char c = FtpCmdClient.read();
+      // Convert everything to upper case. So both, lower+upper case commands/filenames work.
+      if ((c>='a')&&(c<='z'))
+        c+='A'-'a';
+      if (c == '\r')
+      {
+        // ignored
+      }
+      else
+      if (Ftp.CmdBytes < 4) // FTP command length has a maximum of 4 bytes
       {
-        FTP_DEBUG_PRINTLN(F("FTP dis"));
-        // give the remote client time to receive the data
-        delay(10);
-        FtpCmdClient.stop();
-        FtpState = FTP_INITIALIZED;
+        Ftp.CmdData[Ftp.CmdBytes++] = (c=='\n') ? 0 : c;
+        Ftp.CmdData[Ftp.CmdBytes] = 0;
+        if ((c == '\n')||(Ftp.CmdBytes == 4))
+          Ftp.CmdId = ftpGetCmdId(buf, Ftp.CmdData);
+        if (c == '\n')
+        {
+          // execute command with no paramters
+          ftpCommand(buf, Ftp.CmdId, "");
+          Ftp.CmdBytes = 0;
+        }
+        Ftp.ParamBytes = 0;
       }
       else
-      if (FtpCmdClient.available())
       {
-        char c = FtpCmdClient.read();
-        // Convert everything to upper case. So both, lower+upper case commands/filenames work.
-        if ((c>='a')&&(c<='z'))
-          c+='A'-'a';
-        if (c == '\r')
+        // process FTP command parameter
+        if (c==' ')
         {
           // ignored
         }
         else
-        if (Ftp.CmdBytes < 4) // FTP command length has a maximum of 4 bytes
+        if (c == '\n')
         {
-          Ftp.CmdData[Ftp.CmdBytes++] = (c=='\n') ? 0 : c;
-          Ftp.CmdData[Ftp.CmdBytes] = 0;
-          if ((c == '\n')||(Ftp.CmdBytes == 4))
-            Ftp.CmdId = ftpGetCmdId(buf, Ftp.CmdData);
-          if (c == '\n')
-          {
-            // execute command with no paramters
-            ftpCommand(buf, Ftp.CmdId, "");
-            Ftp.CmdBytes = 0;
-          }
+          // command & parameter is complete
+          Ftp.CmdData[Ftp.ParamBytes] = 0;
+          ftpCommand(buf, Ftp.CmdId, Ftp.CmdData);
+          Ftp.CmdBytes = 0;
           Ftp.ParamBytes = 0;
         }
         else
+        if (Ftp.ParamBytes < sizeof(Ftp.CmdData)-1)
         {
-          // process FTP command parameter
-          if (c==' ')
-          {
-            // ignored
-          }
-          else
-          if (c == '\n')
-          {
-            // command & parameter is complete
-            Ftp.CmdData[Ftp.ParamBytes] = 0;
-            ftpCommand(buf, Ftp.CmdId, Ftp.CmdData);
-            Ftp.CmdBytes = 0;
-            Ftp.ParamBytes = 0;
-          }
-          else
-          if (Ftp.ParamBytes < sizeof(Ftp.CmdData)-1)
-          {
-              Ftp.CmdData[Ftp.ParamBytes++] = c;
-          }
+            Ftp.CmdData[Ftp.ParamBytes++] = c;
         }
       }
     }
-    CHECK_MEM(1001);
-
-  } while (FtpState == FTP_CONNECTED);
+  }
+  CHECK_MEM(1001);
 
-  // check every 100ms for incomming FTP connections
-  Throttle = millis()+100;
+  // Only a single step is processed per call, so Apple II commands are never delayed for long.
+  // Without a connection, check every 100ms for incomming FTP connections.
+  Throttle = (FtpState >= FTP_CONNECTED) ? 0 : millis()+100;
 }
 
 #endif // USE_FTP
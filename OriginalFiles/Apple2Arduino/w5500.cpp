@@ -43,45 +43,29 @@
 #include <SPI.h>
 #endif
 
-uint8_t Wiznet5500::wizchip_read(uint8_t block, uint16_t address)
+static inline uint16_t get_word(const uint8_t* p)
 {
-    uint8_t ret;
+    return ((uint16_t)p[0] << 8) | p[1];
+}
 
+void Wiznet5500::wizchip_burst_start(uint8_t block, uint16_t address)
+{
     wizchip_cs_select();
 
-    block |= AccessModeRead;
-
     wizchip_spi_write_byte((address & 0xFF00) >> 8);
     wizchip_spi_write_byte((address & 0x00FF) >> 0);
     wizchip_spi_write_byte(block);
-
-    ret = wizchip_spi_read_byte();
-
-    wizchip_cs_deselect();
-    return ret;
 }
 
-uint16_t Wiznet5500::wizchip_read_word(uint8_t block, uint16_t address)
-{
-    return ((uint16_t)wizchip_read(block, address) << 8) + wizchip_read(block, address + 1);
-}
-
-void Wiznet5500::wizchip_read_buf(uint8_t block, uint16_t address, uint8_t* pBuf, uint16_t len)
+void Wiznet5500::wizchip_read_data(uint8_t* pBuf, uint16_t len)
 {
     uint16_t i;
 
-    wizchip_cs_select();
-
-    block |= AccessModeRead;
-
-    wizchip_spi_write_byte((address & 0xFF00) >> 8);
-    wizchip_spi_write_byte((address & 0x00FF) >> 0);
-    wizchip_spi_write_byte(block);
 #ifdef PINDEFS
     if (pBuf == NULL)
     {
       DATAPORT_MODE_TRANS();
-      for (int i=0;i<len;i++)
+      for (i=0;i<len;i++)
       {
         uint8_t bt = wizchip_spi_read_byte();
         while (READ_IBFA() != 0);
@@ -96,41 +80,54 @@ void Wiznet5500::wizchip_read_buf(uint8_t block, uint16_t address, uint8_t* pBuf
       for(i = 0; i < len; i++)
           pBuf[i] = wizchip_spi_read_byte();
     }
+}
+
+uint8_t Wiznet5500::wizchip_read(uint8_t block, uint16_t address)
+{
+    uint8_t ret;
 
+    wizchip_burst_start(block | AccessModeRead, address);
+    ret = wizchip_spi_read_byte();
     wizchip_cs_deselect();
+
+    return ret;
 }
 
-void Wiznet5500::wizchip_write(uint8_t block, uint16_t address, uint8_t wb)
+uint16_t Wiznet5500::wizchip_read_word(uint8_t block, uint16_t address)
 {
-    wizchip_cs_select();
+    uint8_t buf[2];
 
-    block |= AccessModeWrite;
+    wizchip_read_buf(block, address, buf, 2);
+    return get_word(buf);
+}
 
-    wizchip_spi_write_byte((address & 0xFF00) >> 8);
-    wizchip_spi_write_byte((address & 0x00FF) >> 0);
-    wizchip_spi_write_byte(block);
-    wizchip_spi_write_byte(wb);
+void Wiznet5500::wizchip_read_buf(uint8_t block, uint16_t address, uint8_t* pBuf, uint16_t len)
+{
+    wizchip_burst_start(block | AccessModeRead, address);
+    wizchip_read_data(pBuf, len);
+    wizchip_cs_deselect();
+}
 
+void Wiznet5500::wizchip_write(uint8_t block, uint16_t address, uint8_t wb)
+{
+    wizchip_burst_start(block | AccessModeWrite, address);
+    wizchip_spi_write_byte(wb);
     wizchip_cs_deselect();
 }
 
 void Wiznet5500::wizchip_write_word(uint8_t block, uint16_t address, uint16_t word)
 {
-    wizchip_write(block, address,   (uint8_t)(word>>8));
-    wizchip_write(block, address+1, (uint8_t) word);
+    wizchip_burst_start(block | AccessModeWrite, address);
+    wizchip_spi_write_byte((uint8_t)(word>>8));
+    wizchip_spi_write_byte((uint8_t) word);
+    wizchip_cs_deselect();
 }
 
 void Wiznet5500::wizchip_write_buf(uint8_t block, uint16_t address, const uint8_t* pBuf, uint16_t len)
 {
     uint16_t i;
 
-    wizchip_cs_select();
-
-    block |= AccessModeWrite;
-
-    wizchip_spi_write_byte((address & 0xFF00) >> 8);
-    wizchip_spi_write_byte((address & 0x00FF) >> 0);
-    wizchip_spi_write_byte(block);
+    wizchip_burst_start(block | AccessModeWrite, address);
 #ifdef PINDEFS
     if (pBuf == NULL)
     {
@@ -154,48 +151,74 @@ void Wiznet5500::wizchip_write_buf(uint8_t block, uint16_t address, const uint8_
 
 void Wiznet5500::setSn_CR(uint8_t cr) {
     // Write the command to the Command Register
-    wizchip_write(BlockSelectSReg, Sn_CR, cr);
+    wizchip_write(sReg(), Sn_CR, cr);
 
     // Now wait for the command to complete
-    while( wizchip_read(BlockSelectSReg, Sn_CR) );
+    while( wizchip_read(sReg(), Sn_CR) );
 }
 
-uint16_t Wiznet5500::getSn_TX_FSR()
+// The W5500 may update the sizes and pointers while they are read, so the size is checked against
+// the pointers, which are read in the same burst. If they do not match, the burst is repeated until
+// two bursts return the same size.
+
+uint16_t Wiznet5500::getSn_TX_FSR(uint16_t *tx_wr)
 {
-    uint16_t val=0,val1=0;
-    do
+    uint8_t reg[6]; // Sn_TX_FSR, Sn_TX_RD, Sn_TX_WR
+    uint16_t val, val1;
+
+    wizchip_read_buf(sReg(), Sn_TX_FSR, reg, 6);
+    val = get_word(reg);
+    if (val != (uint16_t)(_bufsize - (get_word(&reg[4]) - get_word(&reg[2]))))
     {
-        val1 = wizchip_read_word(BlockSelectSReg, Sn_TX_FSR);
-        if (val1 != 0)
+        do
         {
-            val = wizchip_read_word(BlockSelectSReg, Sn_TX_FSR);
-        }
-    } while (val != val1);
+            val1 = val;
+            wizchip_read_buf(sReg(), Sn_TX_FSR, reg, 6);
+            val = get_word(reg);
+        } while (val != val1);
+    }
+    if (tx_wr)
+        *tx_wr = get_word(&reg[4]);
     return val;
 }
 
-
-uint16_t Wiznet5500::getSn_RX_RSR()
+uint16_t Wiznet5500::getSn_RX_RSR(uint16_t *rx_rd)
 {
-    uint16_t val=0,val1=0;
-    do
+    uint8_t reg[6]; // Sn_RX_RSR, Sn_RX_RD, Sn_RX_WR
+    uint16_t val, val1;
+
+    wizchip_read_buf(sReg(), Sn_RX_RSR, reg, 6);
+    val = get_word(reg);
+    if (val != (uint16_t)(get_word(&reg[4]) - get_word(&reg[2])))
     {
-        val1 = wizchip_read_word(BlockSelectSReg, Sn_RX_RSR);
-        if (val1 != 0)
+        do
         {
-            val = wizchip_read_word(BlockSelectSReg, Sn_RX_RSR);
-        }
-    } while (val != val1);
+            val1 = val;
+            wizchip_read_buf(sReg(), Sn_RX_RSR, reg, 6);
+            val = get_word(reg);
+        } while (val != val1);
+    }
+    if (rx_rd)
+        *rx_rd = get_word(&reg[2]);
     return val;
 }
 
+uint8_t Wiznet5500::getSn_IR_SR(uint8_t *sr)
+{
+    uint8_t reg[2]; // Sn_IR, Sn_SR
+
+    wizchip_read_buf(sReg(), Sn_IR, reg, 2);
+    *sr = reg[1];
+    return reg[0] & 0x1F;
+}
+
 void Wiznet5500::wizchip_send_data(const uint8_t *wizdata, uint16_t len)
 {
     uint16_t ptr = 0;
 
     if(len == 0) return;
     ptr = getSn_TX_WR();
-    wizchip_write_buf(BlockSelectTxBuf, ptr, wizdata, len);
+    wizchip_write_buf(txBuf(), ptr, wizdata, len);
 
     ptr += len;
 
@@ -208,7 +231,7 @@ void Wiznet5500::wizchip_recv_data(uint8_t *wizdata, uint16_t len)
 
     if(len == 0) return;
     ptr = getSn_RX_RD();
-    wizchip_read_buf(BlockSelectRxBuf, ptr, wizdata, len);
+    wizchip_read_buf(rxBuf(), ptr, wizdata, len);
     ptr += len;
 
     setSn_RX_RD(ptr);
@@ -289,9 +312,16 @@ int8_t Wiznet5500::wizphy_setphypmode(uint8_t pmode)
 Wiznet5500::Wiznet5500(int8_t cs)
 {
     _cs = cs;
+    _sn = 0;
+    _sending = 0;
+    _local_port = 49152;
+    _bufsize = 16*1024;
+#ifdef USE_ETHERNET_FILTER
+    filter.flags = 0;
+#endif
 }
 
-boolean Wiznet5500::begin(const uint8_t *mac_address)
+void Wiznet5500::wizchip_init(const uint8_t *mac_address)
 {
     memcpy(_mac_address, mac_address, 6);
 
@@ -314,10 +344,23 @@ boolean Wiznet5500::begin(const uint8_t *mac_address)
 #endif
 
     wizchip_sw_reset();
+    _sending = 0;
+}
+
+boolean Wiznet5500::begin(const uint8_t *mac_address)
+{
+    wizchip_init(mac_address);
+    _sn = 0;
+#ifdef USE_ETHERNET_FILTER
+    filter.flags = 0;
+    framesDelivered = 0;
+    framesDropped = 0;
+#endif
 
     // Use the full 16Kb of RAM for Socket 0
     setSn_RXBUF_SIZE(16);
     setSn_TXBUF_SIZE(16);
+    _bufsize = 16*1024;
 
     // Set our local MAC address
     setSHAR(_mac_address);
@@ -336,6 +379,7 @@ boolean Wiznet5500::begin(const uint8_t *mac_address)
 
 void Wiznet5500::end()
 {
+    _sn = 0;
     setSn_CR(Sn_CR_CLOSE);
 
     // clear all interrupt of the socket
@@ -359,88 +403,466 @@ static void write_length(uint16_t data_len)
   DATAPORT_MODE_RECEIVE();
 }
 
+#ifdef USE_ETHERNET_FILTER
+static void write_bytes(const uint8_t* data, uint8_t len)
+{
+  DATAPORT_MODE_TRANS();
+  for (uint8_t i=0;i<len;i++)
+  {
+    while (READ_IBFA() != 0);
+    WRITE_DATAPORT(data[i]);
+    STB_LOW();
+    STB_HIGH();
+  }
+  DATAPORT_MODE_RECEIVE();
+}
+
+boolean Wiznet5500::frameFilter(uint16_t ptr, const uint8_t *head, uint8_t size)
+{
+    uint8_t flags = filter.flags;
+    boolean pass = true;
+
+    if (flags)
+    {
+        // Ethernet header (14 bytes), followed by ARP (28 bytes) or IPv4 header (20 bytes) and TCP/UDP ports
+        if (size < 14)
+            pass = false;
+        else
+        if (head[0] & 0x01)
+        {
+            // multicast, but let broadcasts pass
+            if (flags & FILTER_MULTICAST)
+                pass = ((head[0] & head[1] & head[2] & head[3] & head[4] & head[5]) == 0xFF);
+        }
+        else
+        if (flags & FILTER_MAC)
+            pass = (memcmp(head, _mac_address, 6) == 0);
+
+        if (pass)
+        {
+            uint16_t type = ((uint16_t)head[12] << 8) | head[13];
+            if (type == 0x0806)
+            {
+                // ARP: target protocol address
+                if (flags & FILTER_ARP)
+                    pass = (size == 42) && (memcmp(&head[38], filter.ip, 4) == 0);
+            }
+            else
+            if (type == 0x0800)
+            {
+                // TCP/UDP, unless it is a later fragment (without ports)
+                if ((flags & FILTER_PORT) && (size >= 38) && ((head[23] == 6) || (head[23] == 17)) &&
+                    (((head[20] & 0x1F) | head[21]) == 0))
+                {
+                    uint8_t ihl = (head[14] & 0x0F) << 2;
+                    const uint8_t* port = &head[14+ihl+2];
+                    uint8_t options[2];
+                    if (14+ihl+4 > size)
+                    {
+                        // IP options: fetch the destination port, then continue the frame's burst
+                        wizchip_cs_deselect();
+                        wizchip_read_buf(rxBuf(), ptr+14+ihl+2, options, 2);
+                        wizchip_burst_start(rxBuf() | AccessModeRead, ptr+size);
+                        port = options;
+                    }
+                    uint16_t dport = ((uint16_t)port[0] << 8) | port[1];
+                    pass = false;
+                    for (uint8_t i = 0; i < 4; i++)
+                    {
+                        if ((filter.ports[i] != 0) && (filter.ports[i] == dport))
+                            pass = true;
+                    }
+                }
+            }
+            else
+            if (flags & FILTER_ETHERTYPE)
+                pass = (type == filter.ethertypes[0]) || (type == filter.ethertypes[1]);
+        }
+    }
+
+    if (!pass)
+        framesDropped++;
+    return pass;
+}
+#endif
+
 uint16_t Wiznet5500::readFrame(uint8_t *buffer, uint16_t bufsize)
 {
-    uint16_t len = getSn_RX_RSR();
+    uint16_t start;
+    uint16_t len = getSn_RX_RSR(&start);
+    uint16_t ptr = start;
 
-    if (len > 0)
+    while (len >= 2)
     {
+#ifdef USE_ETHERNET_FILTER
+        uint8_t head[FilterHeaderSize];
+#else
         uint8_t head[2];
+#endif
+        uint8_t size = 0;
         uint16_t data_len=0;
 
-        wizchip_recv_data(head, 2);
-        setSn_CR(Sn_CR_RECV);
+        // the length header and the frame are read in one burst
+        wizchip_burst_start(rxBuf() | AccessModeRead, ptr);
+        wizchip_read_data(head, 2);
 
         data_len = head[0];
         data_len = (data_len<<8) + head[1];
+        if ((data_len < 2) || (data_len > len))
+        {
+            wizchip_cs_deselect();
+            break;
+        }
+        ptr += data_len;
+        len -= data_len;
         data_len -= 2;
 
         if (data_len > bufsize)
         {
             // Packet is bigger than buffer - drop the packet
+            wizchip_cs_deselect();
             write_length(0);
-            wizchip_recv_ignore(data_len);
+            setSn_RX_RD(ptr);
             setSn_CR(Sn_CR_RECV);
             return 0;
         }
 
+#ifdef USE_ETHERNET_FILTER
+        if (filter.flags)
+        {
+            size = (data_len < sizeof(head)) ? data_len : sizeof(head);
+            wizchip_read_data(head, size);
+            if (!frameFilter(ptr - data_len, head, size))
+            {
+                // Packet is filtered - drop the packet, try the next one
+                wizchip_cs_deselect();
+                continue;
+            }
+        }
+        framesDelivered++;
+#endif
+
 #ifdef PINDEFS
         if (buffer == NULL)
-          write_length(data_len);
+        {
+            write_length(data_len);
+#ifdef USE_ETHERNET_FILTER
+            write_bytes(head, size);
 #endif
-        wizchip_recv_data(buffer, data_len);
+        }
+        else
+#endif
+        {
+            memcpy(buffer, head, size);
+            buffer += size;
+        }
+        wizchip_read_data(buffer, data_len - size);
+        wizchip_cs_deselect();
+
+        // Had problems with W5500 MAC address filtering (the Sn_MR_MFEN option):
+        // frames are filtered in software instead, before they are read (see frameFilter)
+        setSn_RX_RD(ptr);
         setSn_CR(Sn_CR_RECV);
-#if 1
         return data_len;
+    }
+    if (ptr != start)
+    {
+        setSn_RX_RD(ptr);
+        setSn_CR(Sn_CR_RECV);
+    }
+#ifdef PINDEFS
+    write_length(0);
+#endif
+    return 0;
+}
+
+#ifdef PINDEFS
+uint16_t Wiznet5500::readFrames(uint16_t budget)
+{
+    uint16_t frames = 0;
+    uint16_t start;
+    uint16_t len;
+
+    // a budget without room for a minimum size frame (and the final 0 length) leaves the frames queued
+    if (budget < 2 + 2 + MinFrameSize)
+    {
+        write_length(0);
+        return 0;
+    }
+
+    len = getSn_RX_RSR(&start);
+    if (len > 0)
+    {
+        // all frames are read with one RX read pointer update and one RECV command
+        uint16_t ptr = start;
+        uint16_t total = budget - 2; // the final 0 length always fits
+        budget = total;
+
+        while (len >= 2)
+        {
+#ifdef USE_ETHERNET_FILTER
+            uint8_t head[FilterHeaderSize];
 #else
-        // Had problems with W5500 MAC address filtering (the Sn_MR_MFEN option)
-        // Do it in software instead:
-        if ((buffer[0] & 0x01) || memcmp(&buffer[0], _mac_address, 6) == 0)
+            uint8_t head[2];
+#endif
+            uint8_t size = 0;
+
+            // the length header and the frame are read in one burst
+            wizchip_burst_start(rxBuf() | AccessModeRead, ptr);
+            wizchip_read_data(head, 2);
+
+            // frame_len includes the 2 byte header, which is replaced by the length for the 6502
+            uint16_t frame_len = head[0];
+            frame_len = (frame_len<<8) + head[1];
+            if ((frame_len < 2) || (frame_len > len))
+            {
+                wizchip_cs_deselect();
+                break;
+            }
+
+            // Packet is bigger than the whole budget - drop the packet
+            boolean pass = (frame_len <= total);
+#ifdef USE_ETHERNET_FILTER
+            if (!pass)
+                framesDropped++;
+            else
+            if (filter.flags)
+            {
+                // Packet is filtered - drop the packet
+                size = (frame_len < sizeof(head) + 2) ? frame_len - 2 : sizeof(head);
+                wizchip_read_data(head, size);
+                pass = frameFilter(ptr + 2, head, size);
+            }
+#endif
+            if (pass)
+            {
+                if (frame_len > budget)
+                {
+                    wizchip_cs_deselect();
+                    break;
+                }
+                write_length(frame_len - 2);
+#ifdef USE_ETHERNET_FILTER
+                write_bytes(head, size);
+#endif
+                wizchip_read_data(NULL, frame_len - 2 - size);
+                budget -= frame_len;
+                frames++;
+#ifdef USE_ETHERNET_FILTER
+                framesDelivered++;
+#endif
+            }
+            wizchip_cs_deselect();
+            ptr += frame_len;
+            len -= frame_len;
+        }
+
+        if (ptr != start)
         {
-            // Addressed to an Ethernet multicast address or our unicast address
-            return data_len;
-        } else {
-            return 0;
+            setSn_RX_RD(ptr);
+            setSn_CR(Sn_CR_RECV);
         }
-#endif
     }
-#ifdef PINDEFS
     write_length(0);
+    return frames;
+}
 #endif
-    return 0;
+
+void Wiznet5500::wizchip_send_commit(uint16_t tx_wr)
+{
+    if (_sending & (1 << _sn))
+    {
+        // the previous SEND must complete before the write pointer moves
+        uint8_t sr;
+        while ((getSn_IR_SR(&sr) & (Sn_IR_SENDOK | Sn_IR_TIMEOUT)) == 0)
+        {
+            if (sr == SOCK_CLOSED)
+                break;
+        }
+        setSn_IR(Sn_IR_SENDOK | Sn_IR_TIMEOUT);
+    }
+
+    setSn_TX_WR(tx_wr);
+    setSn_CR(Sn_CR_SEND);
+    _sending |= (1 << _sn);
 }
 
 uint16_t Wiznet5500::sendFrame(const uint8_t *buf, uint16_t len)
 {
+    uint16_t ptr;
+
+    if ((len == 0) || (len > _bufsize))
+        return 0;
+
     // Wait for space in the transmit buffer
-    while(1)
+    while (getSn_TX_FSR(&ptr) < len)
     {
-        uint16_t freesize = getSn_TX_FSR();
         if(getSn_SR() == SOCK_CLOSED) {
-            return -1;
+            return 0;
         }
-        if (len <= freesize) break;
-    };
+    }
 
-    wizchip_send_data(buf, len);
-    setSn_CR(Sn_CR_SEND);
+    // In MACRAW mode each SEND transmits one frame (the data up to the write pointer), so the frame
+    // is copied behind the write pointer, while the previous frame may still be sent
+    wizchip_write_buf(txBuf(), ptr, buf, len);
+    wizchip_send_commit(ptr + len);
+
+    return len;
+}
 
-    while(1)
+boolean Wiznet5500::beginSockets(const uint8_t *config)
+{
+    wizchip_init(config);
+
+    // IP configuration
+    wizchip_write_buf(BlockSelectCReg, SIPR, &config[6], 4);
+    wizchip_write_buf(BlockSelectCReg, SUBR, &config[10], 4);
+    wizchip_write_buf(BlockSelectCReg, GAR, &config[14], 4);
+
+    // Share the 16Kb of RX and TX memory among the first sockets
+    for (_sn = 0; _sn < 8; _sn++)
     {
-        uint8_t tmp = getSn_IR();
-        if (tmp & Sn_IR_SENDOK)
-        {
-            setSn_IR(Sn_IR_SENDOK);
-            // Packet sent ok
-            break;
-        }
-        else if (tmp & Sn_IR_TIMEOUT)
+        uint8_t size = (_sn < SocketCount) ? 16/SocketCount : 0;
+        setSn_RXBUF_SIZE(size);
+        setSn_TXBUF_SIZE(size);
+    }
+    _bufsize = (16/SocketCount)*1024;
+
+    return (getVERSIONR() == 0x04);
+}
+
+uint8_t Wiznet5500::socketOpen(uint8_t protocol, uint16_t port)
+{
+    if ((protocol != Sn_MR_TCP) && (protocol != Sn_MR_UDP))
+        return 0xFF;
+
+    for (_sn = 0; _sn < SocketCount; _sn++)
+    {
+        if (getSn_SR() == SOCK_CLOSED)
         {
-            setSn_IR(Sn_IR_TIMEOUT);
-            // There was a timeout
-            return -1;
+            if (port == 0)
+            {
+                port = _local_port++;
+                if (_local_port == 0)
+                    _local_port = 49152;
+            }
+            _sending &= ~(1 << _sn);
+            setSn_IR(0xFF);
+            setSn_MR(protocol);
+            wizchip_write_word(sReg(), Sn_PORT, port);
+            setSn_CR(Sn_CR_OPEN);
+            if (getSn_SR() == SOCK_CLOSED)
+                return 0xFF;
+            return _sn;
         }
     }
+    return 0xFF;
+}
+
+boolean Wiznet5500::socketConnect(uint8_t s, const uint8_t *ip, uint16_t port)
+{
+    _sn = s;
+    uint8_t sr = getSn_SR();
+    if ((sr != SOCK_INIT) && (sr != SOCK_UDP))
+        return false;
+
+    wizchip_write_buf(sReg(), Sn_DIPR, ip, 4);
+    wizchip_write_word(sReg(), Sn_DPORT, port);
+    if (sr == SOCK_INIT)
+        setSn_CR(Sn_CR_CONNECT);
+    return true;
+}
 
+boolean Wiznet5500::socketListen(uint8_t s)
+{
+    _sn = s;
+    if (getSn_SR() != SOCK_INIT)
+        return false;
+    setSn_CR(Sn_CR_LISTEN);
+    return true;
+}
+
+uint16_t Wiznet5500::socketSend(uint8_t s, const uint8_t *buf, uint16_t len)
+{
+    _sn = s;
+    uint8_t sr = getSn_SR();
+    uint16_t freesize = 0;
+    uint16_t ptr;
+
+    if ((sr == SOCK_ESTABLISHED) || (sr == SOCK_CLOSE_WAIT) || (sr == SOCK_UDP))
+        freesize = getSn_TX_FSR(&ptr);
+    if (len > freesize)
+    {
+        // UDP datagrams are not split
+        len = (sr == SOCK_UDP) ? 0 : freesize;
+    }
+
+#ifdef PINDEFS
+    if (buf == NULL)
+        write_length(len);
+#endif
+    if (len == 0)
+        return 0;
+
+    // copy the data behind the write pointer, while a previous SEND may still be busy
+    wizchip_write_buf(txBuf(), ptr, buf, len);
+    wizchip_send_commit(ptr + len);
+    return len;
+}
+
+uint16_t Wiznet5500::socketRecv(uint8_t s, uint8_t *buf, uint16_t bufsize)
+{
+    _sn = s;
+    uint16_t ptr;
+    uint16_t len = getSn_RX_RSR(&ptr);
+    uint16_t skip = 0;
+
+    if ((len > 0) && (getSn_SR() == SOCK_UDP))
+    {
+        // one datagram: header (IP address, port, data length) and data
+        uint8_t head[8];
+        wizchip_read_buf(rxBuf(), ptr, head, 8);
+        len = 8 + ((uint16_t)head[6] << 8) + head[7];
+        if (len > bufsize)
+            skip = len - bufsize;
+    }
+    if (len > bufsize)
+        len = bufsize;
+
+#ifdef PINDEFS
+    if (buf == NULL)
+        write_length(len);
+#endif
+    if ((len > 0) || (skip > 0))
+    {
+        wizchip_read_buf(rxBuf(), ptr, buf, len);
+        setSn_RX_RD(ptr + len + skip);
+        setSn_CR(Sn_CR_RECV);
+    }
     return len;
 }
+
+uint8_t Wiznet5500::socketStatus(uint8_t s, uint16_t *received, uint16_t *txfree)
+{
+    _sn = s;
+    *received = getSn_RX_RSR(NULL);
+    *txfree = getSn_TX_FSR(NULL);
+    return getSn_SR();
+}
+
+void Wiznet5500::socketClose(uint8_t s, boolean force)
+{
+    _sn = s;
+    _sending &= ~(1 << s);
+    uint8_t sr = getSn_SR();
+    if ((!force) && ((sr == SOCK_ESTABLISHED) || (sr == SOCK_CLOSE_WAIT)))
+    {
+        // the socket closes when the peer has acknowledged
+        setSn_CR(Sn_CR_DISCON);
+    }
+    else
+    {
+        setSn_CR(Sn_CR_CLOSE);
+        setSn_IR(0xFF);
+    }
+}
@@ -39,9 +39,15 @@
 
 #include <stdint.h>
 #include <Arduino.h>
+#include "config.h"
 
 #define PINDEFS
 
+// the receive filter needs more flash than the ATmega328P has
+#if !defined(__AVR_ATmega644P__)
+  #undef USE_ETHERNET_FILTER
+#endif
+
 #ifndef PINDEFS
 #include <SPI.h>
 #endif
@@ -72,10 +78,11 @@ public:
     void end();
 
     /**
-     * Send an Ethernet frame
-     * @param data a pointer to the data to send
+     * Send an Ethernet frame. The frame is copied to the TX memory behind the previous frame, which may
+     * still be sent: the SEND_OK of the previous frame is only awaited before the next SEND command.
+     * @param data a pointer to the data to send, NULL: read the data from the 82C55
      * @param datalen the length of the data in the packet
-     * @return the number of bytes transmitted
+     * @return the number of bytes transmitted, 0 if the frame was not sent (and not read from the 82C55)
      */
     uint16_t sendFrame(const uint8_t *data, uint16_t datalen);
 
@@ -88,6 +95,110 @@ public:
      */
     uint16_t readFrame(uint8_t *buffer, uint16_t bufsize);
 
+#ifdef PINDEFS
+    /**
+     * Send all received frames to the 82C55, which fit into the budget
+     * Each frame is preceded by its length (16bit, little endian), a length of 0 ends the list.
+     * Frames larger than the whole budget are dropped. A budget too small for a minimum size
+     * frame returns no frames and drops none.
+     * @param budget the number of bytes the caller accepts, including all length bytes
+     * @return the number of frames sent
+     */
+    uint16_t readFrames(uint16_t budget);
+
+    /** Minimum Ethernet frame size (without FCS), as received by the W5500 */
+    static const uint16_t MinFrameSize = 60;
+#endif
+
+#ifdef USE_ETHERNET_FILTER
+    /** Receive filter flags: frames to drop */
+    enum {
+        FILTER_MAC       = 0x01, ///< unicast frames for other MAC addresses
+        FILTER_MULTICAST = 0x02, ///< multicast frames (broadcasts pass)
+        FILTER_ARP       = 0x04, ///< ARP frames for other IP addresses
+        FILTER_ETHERTYPE = 0x08, ///< EtherTypes other than IPv4, ARP and the listed ones
+        FILTER_PORT      = 0x10, ///< IPv4 TCP/UDP frames for other than the listed destination ports
+    };
+
+    /** Receive filter of readFrame/readFrames: dropped frames are skipped in the W5500 buffer */
+    struct {
+        uint8_t  flags;          ///< FILTER_* flags, 0 disables the filter
+        uint8_t  ip[4];          ///< own IP address (FILTER_ARP)
+        uint16_t ethertypes[2];  ///< further accepted EtherTypes (FILTER_ETHERTYPE, 0=unused)
+        uint16_t ports[4];       ///< accepted TCP/UDP destination ports (FILTER_PORT, 0=unused)
+    } filter;
+
+    /** Received frames passed to the 6502 and dropped (by the filter or larger than the readFrames budget) */
+    uint16_t framesDelivered;
+    uint16_t framesDropped;
+
+    /** Bytes of a frame read for the filter: Ethernet header, ARP or IPv4 header and TCP/UDP ports */
+    static const uint8_t FilterHeaderSize = 42;
+#endif
+
+    /** Number of TCP/UDP sockets in socket mode (4KB RX/TX buffers each) */
+    static const uint8_t SocketCount = 4;
+
+    /**
+     * Initialise the Ethernet controller for its TCP/UDP sockets (instead of MACRAW mode)
+     * @param config MAC address (6 bytes), IP address, subnet mask and gateway (4 bytes each)
+     * @return Returns true if the W5500 responded
+     */
+    boolean beginSockets(const uint8_t *config);
+
+    /**
+     * Open a free socket
+     * @param protocol 1=TCP, 2=UDP
+     * @param port the local port, 0 selects a port
+     * @return the socket number or 0xFF if no socket is free
+     */
+    uint8_t socketOpen(uint8_t protocol, uint16_t port);
+
+    /**
+     * Connect a TCP socket (the connection is established in the background, see socketStatus)
+     * or set the destination of a UDP socket
+     * @return Returns false if the socket is in the wrong state
+     */
+    boolean socketConnect(uint8_t s, const uint8_t *ip, uint16_t port);
+
+    /**
+     * Wait for a connection on a TCP socket
+     * @return Returns false if the socket is in the wrong state
+     */
+    boolean socketListen(uint8_t s);
+
+    /**
+     * Queue data for sending. TCP data is accepted as far as the TX buffer has room, UDP datagrams
+     * are accepted completely or not at all. The SEND_OK of the previous send is only awaited before
+     * the next SEND command, so the data transfer overlaps with the transmission.
+     * @param buf the data, NULL: send the accepted length (16bit) to the 82C55 and read the data from it
+     * @return the number of bytes accepted
+     */
+    uint16_t socketSend(uint8_t s, const uint8_t *buf, uint16_t len);
+
+    /**
+     * Read received data: TCP data up to bufsize bytes, or one UDP datagram with its 8 byte header
+     * (IP address, port and length as stored by the W5500, big endian). Datagrams exceeding bufsize
+     * are truncated.
+     * @param buf the buffer, NULL: send the length (16bit) and the data to the 82C55
+     * @return the number of bytes read
+     */
+    uint16_t socketRecv(uint8_t s, uint8_t *buf, uint16_t bufsize);
+
+    /**
+     * Get the socket state
+     * @param received number of bytes in the RX buffer
+     * @param txfree free space in the TX buffer
+     * @return the value of @ref Sn_SR
+     */
+    uint8_t socketStatus(uint8_t s, uint16_t *received, uint16_t *txfree);
+
+    /**
+     * Close a socket
+     * @param force false: disconnect TCP connections gracefully, true: close immediately
+     */
+    void socketClose(uint8_t s, boolean force);
+
 
 private:
 
@@ -114,6 +225,22 @@ private:
     int8_t _cs;
     uint8_t _mac_address[6];
 
+    //< selected socket: the socket registers and buffers below access this socket's blocks
+    uint8_t _sn;
+
+    //< sockets with a SEND command, which may not have completed yet
+    uint8_t _sending;
+
+    //< next local port assigned by socketOpen()
+    uint16_t _local_port;
+
+    //< RX/TX buffer size of each socket in bytes
+    uint16_t _bufsize;
+
+    inline uint8_t sReg()  { return BlockSelectSReg  + (_sn << 5); }
+    inline uint8_t txBuf() { return BlockSelectTxBuf + (_sn << 5); }
+    inline uint8_t rxBuf() { return BlockSelectRxBuf + (_sn << 5); }
+
     /**
      * Default function to select chip.
      * @note This function help not to access wrong address. If you do not describe this function or register any functions,
@@ -166,6 +293,22 @@ private:
     }
 
 
+    /**
+     * Start a burst access: select the chip, send the address and the control phase.
+     * The data phase follows with wizchip_read_data() or single byte transfers,
+     * wizchip_cs_deselect() ends the burst.
+     * @param block block select and access mode
+     * @param address Register address
+     */
+    void wizchip_burst_start(uint8_t block, uint16_t address);
+
+    /**
+     * Data phase of a read burst.
+     * @param pBuf Pointer buffer to read data, NULL: send the data to the 82C55
+     * @param len Data length
+     */
+    void wizchip_read_data(uint8_t* pBuf, uint16_t len);
+
     /**
      * Read a 1 byte value from a register.
      * @param address Register address
@@ -174,7 +317,7 @@ private:
     uint8_t wizchip_read(uint8_t block, uint16_t address);
 
     /**
-     * Reads a 2 byte value from a register.
+     * Reads a 2 byte value from a register (in one burst).
      * @param address Register address
      * @return The value of register
      */
@@ -197,7 +340,7 @@ private:
     void wizchip_write(uint8_t block, uint16_t address, uint8_t wb);
 
     /**
-     * Write a 2 byte value to a register.
+     * Write a 2 byte value to a register (in one burst).
      * @param address Register address
      * @param wb Write data
      * @return void
@@ -213,23 +356,45 @@ private:
     void wizchip_write_buf(uint8_t block, uint16_t address, const uint8_t* pBuf, uint16_t len);
 
     /**
-     * Get @ref Sn_TX_FSR register
+     * Get @ref Sn_TX_FSR register, read in one burst with @ref Sn_TX_RD and @ref Sn_TX_WR.
+     * The burst is repeated if the free size does not match the pointers.
+     * @param tx_wr returns the value of @ref Sn_TX_WR (unless NULL)
      * @return uint16_t. Value of @ref Sn_TX_FSR.
      */
-    uint16_t getSn_TX_FSR();
+    uint16_t getSn_TX_FSR(uint16_t *tx_wr);
 
     /**
-     * Get @ref Sn_RX_RSR register
+     * Get @ref Sn_RX_RSR register, read in one burst with @ref Sn_RX_RD and @ref Sn_RX_WR.
+     * The burst is repeated if the received size does not match the pointers.
+     * @param rx_rd returns the value of @ref Sn_RX_RD (unless NULL)
      * @return uint16_t. Value of @ref Sn_RX_RSR.
      */
-    uint16_t getSn_RX_RSR();
+    uint16_t getSn_RX_RSR(uint16_t *rx_rd);
+
+    /**
+     * Get @ref Sn_IR and @ref Sn_SR registers in one burst
+     * @param sr returns the value of @ref Sn_SR
+     * @return uint8_t. Value of @ref Sn_IR.
+     */
+    uint8_t getSn_IR_SR(uint8_t *sr);
 
 
+    /**
+     * Send the data up to a new TX write pointer, after the previous SEND command of the socket completed
+     * @param tx_wr new value of @ref Sn_TX_WR
+     */
+    void wizchip_send_commit(uint16_t tx_wr);
+
     /**
      * Reset WIZCHIP by softly.
      */
     void wizchip_sw_reset();
 
+    /**
+     * Set up the SPI interface, then reset the WIZCHIP
+     */
+    void wizchip_init(const uint8_t *mac_address);
+
     /**
      * Get the link status of phy in WIZCHIP
      */
@@ -286,12 +451,27 @@ private:
      */
     void wizchip_recv_ignore(uint16_t len);
 
+#ifdef USE_ETHERNET_FILTER
+    /**
+     * Apply the receive filter to a frame, count it if it is dropped.
+     * Called within the read burst of the frame, which continues behind the header.
+     * @param ptr RX memory address of the frame (after its 2 byte length)
+     * @param head the first bytes of the frame
+     * @param size number of bytes in head (FilterHeaderSize, unless the frame is shorter)
+     * @return true if the frame is passed to the 6502
+     */
+    boolean frameFilter(uint16_t ptr, const uint8_t *head, uint8_t size);
+#endif
+
 
 
     /** Common registers */
     enum {
         MR = 0x0000,        ///< Mode Register address (R/W)
+        GAR = 0x0001,       ///< Gateway IP Register address (R/W)
+        SUBR = 0x0005,      ///< Subnet mask Register address (R/W)
         SHAR = 0x0009,      ///< Source MAC Register address (R/W)
+        SIPR = 0x000F,      ///< Source IP Register address (R/W)
         INTLEVEL = 0x0013,  ///< Set Interrupt low level timer register address (R/W)
         IR = 0x0015,        ///< Interrupt Register (R/W)
         _IMR_ = 0x0016,     ///< Interrupt mask register (R/W)
@@ -547,7 +727,7 @@ private:
      * @sa getSn_MR()
      */
     inline void setSn_MR(uint8_t mr) {
-        wizchip_write(BlockSelectSReg, Sn_MR, mr);
+        wizchip_write(sReg(), Sn_MR, mr);
     }
 
     /**
@@ -556,7 +736,7 @@ private:
      * @sa setSn_MR()
      */
     inline uint8_t getSn_MR() {
-        return wizchip_read(BlockSelectSReg, Sn_MR);
+        return wizchip_read(sReg(), Sn_MR);
     }
 
     /**
@@ -572,7 +752,7 @@ private:
      * @sa setSn_CR()
      */
     inline uint8_t getSn_CR() {
-        return wizchip_read(BlockSelectSReg, Sn_CR);
+        return wizchip_read(sReg(), Sn_CR);
     }
 
     /**
@@ -581,7 +761,7 @@ private:
      * @sa getSn_IR()
      */
     inline void setSn_IR(uint8_t ir) {
-        wizchip_write(BlockSelectSReg, Sn_IR, (ir & 0x1F));
+        wizchip_write(sReg(), Sn_IR, (ir & 0x1F));
     }
 
     /**
@@ -590,7 +770,7 @@ private:
      * @sa setSn_IR()
      */
     inline uint8_t getSn_IR() {
-        return (wizchip_read(BlockSelectSReg, Sn_IR) & 0x1F);
+        return (wizchip_read(sReg(), Sn_IR) & 0x1F);
     }
 
     /**
@@ -599,7 +779,7 @@ private:
      * @sa getSn_IMR()
      */
     inline void setSn_IMR(uint8_t imr) {
-        wizchip_write(BlockSelectSReg, Sn_IMR, (imr & 0x1F));
+        wizchip_write(sReg(), Sn_IMR, (imr & 0x1F));
     }
 
     /**
@@ -608,7 +788,7 @@ private:
      * @sa setSn_IMR()
      */
     inline uint8_t getSn_IMR() {
-        return (wizchip_read(BlockSelectSReg, Sn_IMR) & 0x1F);
+        return (wizchip_read(sReg(), Sn_IMR) & 0x1F);
     }
 
     /**
@@ -616,7 +796,7 @@ private:
      * @return uint8_t. Value of @ref Sn_SR.
      */
     inline uint8_t getSn_SR() {
-        return wizchip_read(BlockSelectSReg, Sn_SR);
+        return wizchip_read(sReg(), Sn_SR);
     }
 
     /**
@@ -625,7 +805,7 @@ private:
      * @sa getSn_RXBUF_SIZE()
      */
     inline void setSn_RXBUF_SIZE(uint8_t rxbufsize) {
-        wizchip_write(BlockSelectSReg, Sn_RXBUF_SIZE, rxbufsize);
+        wizchip_write(sReg(), Sn_RXBUF_SIZE, rxbufsize);
     }
 
     /**
@@ -634,7 +814,7 @@ private:
      * @sa setSn_RXBUF_SIZE()
      */
     inline uint8_t getSn_RXBUF_SIZE() {
-        return wizchip_read(BlockSelectSReg, Sn_RXBUF_SIZE);
+        return wizchip_read(sReg(), Sn_RXBUF_SIZE);
     }
 
     /**
@@ -643,7 +823,7 @@ private:
      * @sa getSn_TXBUF_SIZE()
      */
     inline void setSn_TXBUF_SIZE(uint8_t txbufsize) {
-        wizchip_write(BlockSelectSReg, Sn_TXBUF_SIZE, txbufsize);
+        wizchip_write(sReg(), Sn_TXBUF_SIZE, txbufsize);
     }
 
     /**
@@ -652,7 +832,7 @@ private:
      * @sa setSn_TXBUF_SIZE()
      */
     inline uint8_t getSn_TXBUF_SIZE() {
-        return wizchip_read(BlockSelectSReg, Sn_TXBUF_SIZE);
+        return wizchip_read(sReg(), Sn_TXBUF_SIZE);
     }
 
     /**
@@ -660,7 +840,7 @@ private:
      * @return uint16_t. Value of @ref Sn_TX_RD.
      */
     inline uint16_t getSn_TX_RD() {
-        return wizchip_read_word(BlockSelectSReg, Sn_TX_RD);
+        return wizchip_read_word(sReg(), Sn_TX_RD);
     }
 
     /**
@@ -669,7 +849,7 @@ private:
      * @sa GetSn_TX_WR()
      */
     inline void setSn_TX_WR(uint16_t txwr) {
-        wizchip_write_word(BlockSelectSReg, Sn_TX_WR, txwr);
+        wizchip_write_word(sReg(), Sn_TX_WR, txwr);
     }
 
     /**
@@ -678,7 +858,7 @@ private:
      * @sa setSn_TX_WR()
      */
     inline uint16_t getSn_TX_WR() {
-        return wizchip_read_word(BlockSelectSReg, Sn_TX_WR);
+        return wizchip_read_word(sReg(), Sn_TX_WR);
     }
 
     /**
@@ -687,7 +867,7 @@ private:
      * @sa getSn_RX_RD()
      */
     inline void setSn_RX_RD(uint16_t rxrd) {
-        wizchip_write_word(BlockSelectSReg, Sn_RX_RD, rxrd);
+        wizchip_write_word(sReg(), Sn_RX_RD, rxrd);
     }
 
     /**
@@ -696,7 +876,7 @@ private:
      * @sa setSn_RX_RD()
      */
     inline uint16_t getSn_RX_RD() {
-        return wizchip_read_word(BlockSelectSReg, Sn_RX_RD);
+        return wizchip_read_word(sReg(), Sn_RX_RD);
     }
 
     /**
@@ -704,7 +884,7 @@ private:
      * @return uint16_t. Value of @ref Sn_RX_WR.
      */
     inline uint16_t getSn_RX_WR() {
-        return wizchip_read_word(BlockSelectSReg, Sn_RX_WR);
+        return wizchip_read_word(sReg(), Sn_RX_WR);
     }
 };
 
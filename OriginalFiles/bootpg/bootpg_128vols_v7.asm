@@ -162,14 +162,18 @@ LOADOK:
 
 UPDATEVOLNAMES:
          JSR DISPCUR          ; show current volume numbers
-         JSR SHOWVOLNAMES
-         LDA GVOLDRIVE0
+                              ; fall through: the volume catalog leaves the current volume selection unchanged
+SHOWVOLNAMES:
+         LDA VOLPAGE     ; catalog of the current page on SD1
          STA BLKLO
-         LDA GVOLDRIVE1
-         STA BLKHI
-         JMP DAN_SETVOL       ; restore current volume selection (user aborts or presses RESET)
+         LDA #>BLKBUF
+         JSR DAN_CATALOG
+         LDA VOLPAGE     ; catalog of the current page on SD2
+         ORA #$80
+         STA BLKLO
+         LDA #>(BLKBUF+$200)
+         JSR DAN_CATALOG
 
-SHOWVOLNAMES:
          LDA #0
          STA VOL         ; set drive number
          LDA #MENU_ROW
@@ -177,21 +181,11 @@ SHOWVOLNAMES:
 UNITLOOP:
          JSR VTAB
 
-         LDA VOL         ; set both drives to location
-         ORA VOLPAGE     ; include current volume page
-         STA BLKLO       ; select volume #VOL on SD1
-         ORA #$80        ; select volume #VOL on SD2
-         STA BLKHI
-         JSR DAN_SETVOL
-
          LDA #0          ; start at column 0
          JSR DISPVOLUME  ; show item number and volume name
          LDA #$FF
          STA INVFLG
 
-         LDA UNIT
-         ORA #$80        ; check SD-card 2 (drive 1)
-         STA UNIT        ; set high bit to get drive 1
          LDA VOL
          ORA #$80        ; indicate SD2
          STA VOL
@@ -199,9 +193,6 @@ UNITLOOP:
          JSR DISPVOLUME  ; show item number for volume
          LDA #$FF
          STA INVFLG
-         LSR A
-         AND UNIT        ; clear high bit
-         STA UNIT
 
          INC CV          ; go to next row
          INC VOL         ; go to next volume
@@ -461,23 +452,33 @@ SETINV:
          LDA #$3F
          STA INVFLG        ; enable inverse printing of selected volume name
 NOINVFLG:
-         JSR DAN_READBLOCK ; read a block from drive 0
-DISPNAME:
-         BCS NOHEADER      ; didn't read a sector
-         LDA BLKBUF+5      ; if greater than $80 not a valid ASCII
-         BMI NOHEADER
-         LDA BLKBUF+4      ; look at volume directory header byte
-         TAX
-         AND #$F0
-         CMP #$F0
-         BNE NOHEADER
-         TXA
+         LDA VOL           ; catalog entry: BLKBUF+VOL*32 (SD1), BLKBUF+$200+VOL*32 (SD2)
+         LDX #>BLKBUF
+         ASL A             ; SD2 bit
+         BCC :+
+         INX
+         INX
+:        ASL A
+         ASL A
+         ASL A
+         ASL A
+         BCC :+
+         INX
+:        STA BUFLO
+         STX BUFHI
+         LDY #1
+         LDA (BUFLO),Y     ; entry flags
+         LSR A             ; $01: ProDOS volume
+         BCC NOHEADER
+         LDY #4
+         LDA (BUFLO),Y     ; volume directory header byte
          AND #$0F
          BEQ NOHEADER
          STA SCRATCH       ; length
          LDX #0
 DISPL:
-         LDA BLKBUF+5,X
+         INY
+         LDA (BUFLO),Y
          ORA #NORMAL
          JSR COUT
          INX
@@ -624,14 +625,14 @@ DISPMSG: LDA MSGS,X
          BNE DISPMSG
 RTSL:    RTS
 
-DAN_READBLOCK:
-         LDY #$00
-         STY BLKHI
-         INY               ; Y=1: read block
-         STY COMMAND       ; store at $42
-         INY               ; Y=2: which block (in this example $0002)
-         STY BLKLO
-         JMP DAN_COMM
+DAN_CATALOG:
+         STA BUFHI         ; buffer at A*$100
+         LDA #$00
+         STA BUFLO
+         STA BLKHI         ; one block: 16 volumes, starting at BLKLO
+         LDA #$31          ; volume catalog
+         STA COMMAND
+         JMP INSTRUC
 
 DAN_SETVOLW:
          LDA #$07          ; set volume but write to EEPROM
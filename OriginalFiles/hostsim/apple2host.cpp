@@ -0,0 +1,422 @@
+/* apple2host.cpp - DAN][ host build: Apple II commands executed by the native volume layer.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// The command handlers of Apple2Arduino.ino talk to the 82C55, so they cannot be compiled for the host.
+// The functions below issue the same sequence of volume layer calls instead. The Apple II side of
+// streamed blocks is the mmc_host_dataport buffer. Keep them in sync with the firmware!
+
+#include <string.h>
+#include "config.h"
+#include "dan2volumes.h"
+#include "mmc_host.h"
+#include "dan2host.h"
+#include "w5500.h"
+#include "w5500_host.h"
+
+void host_setup(uint8_t drive1, uint8_t drive2, uint8_t slot, bool write_back)
+{
+  drive_fileno[0] = drive1;
+  drive_fileno[1] = drive2;
+  a2slot = slot & 0x7;
+#ifdef USE_WRITE_BACK
+  vol_write_back = write_back;
+#else
+  (void) write_back;
+#endif
+  request.sdslot = SDSLOT1;
+  vol_check_sdslot_type();
+  request.sdslot = SDSLOT2;
+  vol_check_sdslot_type();
+}
+
+// get_unit_buf_blk() + calculate_sd_filenum()
+static void host_request(uint8_t u, uint16_t blk)
+{
+  unit = u;
+  request.blk = blk;
+  calculate_sd_filenum();
+}
+
+// do_status()
+uint8_t host_status(uint8_t u, uint16_t blk)
+{
+  host_request(u, blk);
+  return (vol_open_drive_file() ? PRODOS_OK : PRODOS_IO_ERR);
+}
+
+// do_read(RD_NORMAL) - without the boot block fallback
+uint8_t host_read(uint8_t u, uint16_t blk, uint8_t* buf)
+{
+  host_request(u, blk);
+#ifdef USE_BLOCK_CACHE
+  uint8_t* data;
+  uint8_t returncode = vol_read_cached(&data);
+  if (returncode == 0)
+    memcpy(buf, data, 512);
+#else
+  uint8_t returncode = vol_read_start(1);
+  if (returncode == 0)
+    returncode = vol_read_next(NULL);
+  vol_read_stop();
+  if ((returncode == 0)||(returncode == VOL_CRC_ERR))
+    memcpy(buf, mmc_host_dataport, 512);
+#endif
+  return returncode;
+}
+
+// do_write()
+uint8_t host_write(uint8_t u, uint16_t blk, const uint8_t* buf)
+{
+  uint8_t returncode = host_status(u, blk);
+  if (returncode != 0)
+    return returncode;
+
+#ifdef USE_WRITE_BACK
+  if (vol_write_back)
+  {
+    uint8_t* data = vol_write_deferred();
+    if (data)
+      memcpy(data, buf, 512);
+    return returncode;
+  }
+#endif
+
+#ifdef USE_BLOCK_CACHE
+  uint8_t* data = vol_cache_block();
+  if (data)
+  {
+    memcpy(data, buf, 512);
+    return vol_write_block(data);
+  }
+#endif
+
+  // the firmware cannot report errors of streamed writes, but the host can
+  memcpy(mmc_host_dataport, buf, 512);
+  vol_write_start(1, true);
+  returncode = vol_write_next(NULL);
+  vol_write_stop();
+  return returncode;
+}
+
+// do_read_multi()
+uint8_t host_read_multi(uint8_t u, uint16_t blk, uint8_t count, uint8_t* buf)
+{
+  host_request(u, blk);
+  uint8_t returncode = vol_read_start(count);
+  do
+  {
+    if (returncode == 0)
+      returncode = vol_read_next(NULL);
+    if (returncode == VOL_CRC_ERR)
+      returncode = PRODOS_IO_ERR;
+    if (returncode != 0)
+      break;
+    memcpy(buf, mmc_host_dataport, 512);
+    buf += 512;
+  } while (--count);
+  vol_read_stop();
+  return returncode;
+}
+
+// do_write_multi()
+uint8_t host_write_multi(uint8_t u, uint16_t blk, uint8_t count, const uint8_t* buf)
+{
+  host_request(u, blk);
+  uint8_t returncode = vol_write_start(count, true);
+  if (returncode == 0)
+  {
+    do
+    {
+      memcpy(mmc_host_dataport, buf, 512);
+      buf += 512;
+      returncode = vol_write_next(NULL);
+    } while ((returncode == 0)&&(--count));
+  }
+  vol_write_stop();
+  return returncode;
+}
+
+// do_flush()
+uint8_t host_flush(void)
+{
+  uint8_t returncode = 0;
+#ifdef USE_WRITE_BACK
+  returncode = vol_cache_flush();
+  vol_cache_error = 0;
+#endif
+  return returncode;
+}
+
+// do_set_volume() - without updating the EEPROM
+void host_set_volume(uint8_t cmd, uint8_t u, uint16_t blk)
+{
+  a2slot = (u >> 4) & 0x7;
+  drive_fileno[0] = blk & 0xFF;
+  if (cmd != HOST_CMD_SET_VOLUME1)
+    drive_fileno[1] = (blk >> 8);
+  if ((drive_fileno[0] == 255)||(drive_fileno[1] == 255))
+  {
+    drive_fileno[0] = 0x00;
+    drive_fileno[1] = 0x88;
+  }
+#ifdef USE_BLOCK_CACHE
+  vol_cache_invalidate();
+#endif
+}
+
+// do_volume_catalog(): 32 byte entries of 16 volumes per block
+void host_volume_catalog(uint8_t volume, uint8_t count, uint8_t* buf)
+{
+  if (count > 8)
+    count = 8;
+  uint8_t entries = (count) ? count*16 : 16;
+  memset(buf, 0, entries*32);
+  if (entries > 128 - (volume & 0x7f))
+    entries = 128 - (volume & 0x7f);
+
+  request.sdslot = volume >> 7;
+  uint8_t* blkbuf = vol_header_buffer();
+  do
+  {
+    char     VolName[16];
+    uint32_t blocks;
+    request.filenum = volume & 0x7f;
+    vol_get_volume_name(blkbuf, VolName, &blocks);
+
+    buf[0] = volume++;
+    if (VolName[0])
+    {
+      uint8_t len = 15;
+      while ((len > 0)&&(VolName[len-1] == ' '))
+        len--;
+      buf[1] = 0x01;
+      buf[2] = blocks & 0xff;
+      buf[3] = (blocks >> 8) & 0xff;
+      buf[4] = 0xf0 | len;
+      memcpy(&buf[5], VolName, 15);
+    }
+    buf += 32;
+  } while (--entries);
+}
+
+// do_set_write_back()
+uint8_t host_set_write_back(bool enable)
+{
+  uint8_t returncode = 0;
+#ifdef USE_WRITE_BACK
+  returncode = vol_cache_flush();
+  vol_cache_error = 0;
+  vol_write_back = enable;
+#else
+  (void) enable;
+#endif
+  return returncode;
+}
+
+// loop(), after all pending Apple II commands were processed
+void host_idle(void)
+{
+#ifdef USE_WRITE_BACK
+  vol_cache_flush_idle();
+#endif
+#ifdef USE_READ_AHEAD
+  vol_read_ahead();
+#endif
+}
+
+#ifdef USE_ETHERNET
+static Wiznet5500 eth(8);
+static uint8_t    ethernet_initialized;
+
+// do_initialize_ethernet()
+uint8_t host_eth_init(const uint8_t* mac)
+{
+  if (ethernet_initialized)
+    eth.end();
+  ethernet_initialized = eth.begin(mac);
+  return (ethernet_initialized) ? 0 : 1;
+}
+
+// do_poll_ethernet(): returns the length of the frame copied to buf (0: none)
+uint16_t host_eth_poll(uint16_t len, uint8_t* buf)
+{
+  uint8_t  head[2];
+  uint16_t frame_len;
+  w5500_host_stats.pio_in += 3; // command, length
+  eth.readFrame(NULL, len);
+  w5500_host_pio_read(head, 2);
+  frame_len = head[0] | (head[1] << 8);
+  return w5500_host_pio_read(buf, frame_len);
+}
+
+// do_poll_ethernet_batch(): copies the length prefixed frames to buf, returns the number of frames
+uint16_t host_eth_poll_batch(uint16_t budget, uint8_t* buf)
+{
+  uint16_t frames = 0;
+  w5500_host_stats.pio_in += 3; // command, budget
+  eth.readFrames(budget);
+  for (;;)
+  {
+    w5500_host_pio_read(buf, 2);
+    uint16_t frame_len = buf[0] | (buf[1] << 8);
+    buf += 2;
+    if (frame_len == 0)
+      break;
+    buf += w5500_host_pio_read(buf, frame_len);
+    frames++;
+  }
+  return frames;
+}
+
+// do_send_ethernet()
+void host_eth_send(const uint8_t* frame, uint16_t len)
+{
+  w5500_host_stats.pio_in += 3; // command, length
+  w5500_host_pio_write(frame, len);
+  eth.sendFrame(NULL, len);
+  w5500_host_stats.pio_out++;   // status
+}
+
+// do_send_ethernet_batch(): frames is a list of length prefixed frames, ending with a length of 0
+uint8_t host_eth_send_batch(const uint8_t* frames)
+{
+  uint8_t status = 0;
+  w5500_host_stats.pio_in++;    // command
+  for (;;)
+  {
+    uint16_t len = frames[0] | (frames[1] << 8);
+    w5500_host_stats.pio_in += 2;
+    frames += 2;
+    if (len == 0)
+      break;
+    w5500_host_pio_write(frames, len);
+    if ((!ethernet_initialized)||(eth.sendFrame(NULL, len) != len))
+    {
+      // the firmware reads and drops the frame
+      w5500_host_pio_discard();
+      w5500_host_stats.pio_in += len;
+      status = 1;
+    }
+    frames += len;
+  }
+  w5500_host_stats.pio_out++;   // status
+  return status;
+}
+
+#ifdef USE_ETHERNET_FILTER
+// do_filter_ethernet()
+uint8_t host_eth_filter(uint8_t flags, const uint8_t* ip, const uint16_t* ethertypes, const uint16_t* ports)
+{
+  w5500_host_stats.pio_in += 1+17; // command, parameters
+  w5500_host_stats.pio_out++;      // status
+  eth.filter.flags = flags;
+  memcpy(eth.filter.ip, ip, 4);
+  memcpy(eth.filter.ethertypes, ethertypes, sizeof(eth.filter.ethertypes));
+  memcpy(eth.filter.ports, ports, sizeof(eth.filter.ports));
+  if (ethernet_initialized)
+    return 0;
+  eth.filter.flags = 0;
+  return 1;
+}
+
+// do_version(): Ethernet frame counters
+void host_eth_counters(uint16_t* delivered, uint16_t* dropped)
+{
+  *delivered = eth.framesDelivered;
+  *dropped   = eth.framesDropped;
+}
+#endif
+#endif
+
+#ifdef USE_ETHERNET_SOCKETS
+// do_socket(), command 0x40
+uint8_t host_sock_init(const uint8_t* config)
+{
+  w5500_host_stats.pio_in += 1+18; // command, configuration
+  if (ethernet_initialized)
+    eth.end();
+  ethernet_initialized = 0;
+  w5500_host_stats.pio_out++;      // status
+  return (eth.beginSockets(config)) ? 0 : 1;
+}
+
+// do_socket(), command 0x41: returns the socket number
+uint8_t host_sock_open(uint8_t protocol, uint16_t port)
+{
+  w5500_host_stats.pio_in += 4;  // command, protocol, port
+  w5500_host_stats.pio_out++;    // socket number
+  return eth.socketOpen(protocol, port);
+}
+
+// do_socket(), command 0x42
+uint8_t host_sock_connect(uint8_t s, const uint8_t* ip, uint16_t port)
+{
+  w5500_host_stats.pio_in += 4+4; // command, socket, port, IP address
+  w5500_host_stats.pio_out++;     // status
+  return (eth.socketConnect(s, ip, port)) ? 0 : 1;
+}
+
+// do_socket(), command 0x43
+uint8_t host_sock_listen(uint8_t s)
+{
+  w5500_host_stats.pio_in += 4;  // command, socket, unused
+  w5500_host_stats.pio_out++;    // status
+  return (eth.socketListen(s)) ? 0 : 1;
+}
+
+// do_socket(), command 0x44: returns the number of bytes accepted (and sent)
+uint16_t host_sock_send(uint8_t s, const uint8_t* data, uint16_t len)
+{
+  uint8_t head[2];
+  w5500_host_stats.pio_in += 4;  // command, socket, length
+  w5500_host_pio_write(data, len);
+  eth.socketSend(s, NULL, len);
+  w5500_host_pio_discard();      // the Apple II only sends the accepted bytes
+  w5500_host_pio_read(head, 2);
+  return head[0] | (head[1] << 8);
+}
+
+// do_socket(), command 0x45: returns the length of the data copied to buf
+uint16_t host_sock_recv(uint8_t s, uint8_t* buf, uint16_t size)
+{
+  uint8_t head[2];
+  w5500_host_stats.pio_in += 4;  // command, socket, buffer size
+  eth.socketRecv(s, NULL, size);
+  w5500_host_pio_read(head, 2);
+  return w5500_host_pio_read(buf, head[0] | (head[1] << 8));
+}
+
+// do_socket(), command 0x46: returns the socket state
+uint8_t host_sock_status(uint8_t s, uint16_t* received, uint16_t* txfree)
+{
+  w5500_host_stats.pio_in += 4;  // command, socket, unused
+  w5500_host_stats.pio_out += 5; // state, received bytes, TX free space
+  return eth.socketStatus(s, received, txfree);
+}
+
+// do_socket(), command 0x47
+void host_sock_close(uint8_t s, bool force)
+{
+  w5500_host_stats.pio_in += 4;  // command, socket, mode
+  w5500_host_stats.pio_out++;    // status
+  eth.socketClose(s, force);
+}
+#endif
@@ -0,0 +1,82 @@
+/* arduino_host.cpp - minimal Arduino environment for the DAN][ host build.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <stdio.h>
+#include <time.h>
+#include <Arduino.h>
+#include <EEPROM.h>
+
+HardwareSerial Serial;
+EEPROMClass    EEPROM;
+
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec)*1000000 + ts.tv_nsec/1000;
+}
+
+static uint64_t start_us = now_us();
+
+extern "C" unsigned long millis(void)
+{
+  // 32bit counter, like on the AVR
+  return (uint32_t) ((now_us()-start_us)/1000);
+}
+
+extern "C" unsigned long micros(void)
+{
+  return (uint32_t) (now_us()-start_us);
+}
+
+extern "C" void delay(unsigned long ms)
+{
+  struct timespec ts;
+  ts.tv_sec  = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000;
+  nanosleep(&ts, NULL);
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t size)
+{
+  return fwrite(buf, 1, size, stderr);
+}
+
+size_t HardwareSerial::print(const char* str)
+{
+  fputs(str, stderr);
+  return strlen(str);
+}
+
+size_t HardwareSerial::print(long value, int base)
+{
+  return fprintf(stderr, (base == HEX) ? "%lX" : "%ld", value);
+}
+
+size_t HardwareSerial::println(const char* str)
+{
+  return fprintf(stderr, "%s\n", str);
+}
+
+size_t HardwareSerial::println(long value, int base)
+{
+  return print(value, base) + print("\n");
+}
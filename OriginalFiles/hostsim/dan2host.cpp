@@ -0,0 +1,1058 @@
+/* dan2host.cpp - DAN][ host build: drives the firmware's volume, FatFs and FTP layers with image files.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <Ethernet.h>
+#include "config.h"
+#include "fwversion.h"
+#include "dan2volumes.h"
+#include "ttftp.h"
+#include "mmc_host.h"
+#include "fatfs_host.h"
+#include "dan2host.h"
+#include "w5500_host.h"
+
+static const char* SlotTypeNames[] = {"no disk", "unknown", "FAT", "RAW"};
+
+static void usage(void)
+{
+  fprintf(stderr,
+    "DAN][ host build, firmware v" FW_VERSION
+#ifdef __AVR_ATmega644P__
+    " (ATmega644P)\n"
+#else
+    " (ATmega328P)\n"
+#endif
+    "usage: dan2host [-1 IMAGE] [-2 IMAGE] [-m D1,D2] [-s SLOT] [-w] [-v] COMMAND [ARGS]\n"
+    "  -1 IMAGE   image file of SD card 1\n"
+    "  -2 IMAGE   image file of SD card 2\n"
+    "  -m D1,D2   volume mapping of drive 1 and 2, hex, EEPROM format (default: 00,88)\n"
+    "  -s SLOT    Apple II slot of the DAN][ card (default: 7)\n"
+    "  -w         enable the write-back mode (ATmega644P only)\n"
+    "  -v         verbose\n"
+    "commands:\n"
+    "  mkfat IMAGE MB VOLUMES [BLOCKS]  create a FAT image with empty ProDOS volume files VOLxx.PO\n"
+    "  mkraw IMAGE VOLUMES              create a RAW image with empty ProDOS volumes\n"
+    "  info                             show the SD card formats and the mapped volumes\n"
+    "  read  UNIT BLK [COUNT]           read blocks (ProDOS unit in hex, i.e. 70 or F0) to stdout\n"
+    "  write UNIT BLK [COUNT]           write blocks from stdin\n"
+    "  bench UNIT [COUNT [MULTI]]       read COUNT blocks sequentially (MULTI blocks per command)\n"
+    "  catalog [PAGES]                  read the volume names of the boot menu pages (default: 8) with\n"
+    "                                   the catalog command and by selecting each volume (-v: list)\n"
+    "  ethbench TAP [FRAMES [BUDGET]]   receive frames from a tap interface with the poll commands 0x11 and\n"
+    "                                   0x13 (BUDGET bytes per command, default: 4096), report frames/s\n"
+    "  ethsend TAP [FRAMES [SIZE [BATCH]]] send frames of SIZE bytes (default: 64) to a tap interface with the\n"
+    "                                   commands 0x12 and 0x15 (BATCH frames per command, default: 8)\n"
+#ifdef USE_ETHERNET_FILTER
+    "  ethfilter TAP [FRAMES]           receive a mix of frames (ethgen.py --mix) with the poll command 0x13,\n"
+    "                                   without and with the receive filter (0x14), until FRAMES are for us\n"
+#endif
+#ifdef USE_ETHERNET_SOCKETS
+    "  sockbench IP PORT [KB]           send KB kilobytes (default: 16) through TCP and UDP sockets to an\n"
+    "                                   echo server, compare the returned data, report KB/s\n"
+#endif
+    "  replay TRACE                     execute the block commands of a trace (TRACE.BIN or text),\n"
+    "                                   report SD card and FatFs operations (-v: of each command)\n"
+    "  ftp   [IP]                       run the FTP server (command port %u) on IP (default: 127.0.0.1)\n",
+    FTP_CMD_PORT+ETHERNET_HOST_PORT_OFFSET);
+  exit(1);
+}
+
+static uint32_t number(const char* str, int base)
+{
+  char* end;
+  unsigned long value = strtoul(str, &end, base);
+  if ((*str == 0)||(*end != 0))
+  {
+    fprintf(stderr, "Invalid number: %s\n", str);
+    exit(1);
+  }
+  return value;
+}
+
+/* SD card images ******************************************************************************************/
+
+// contents of block 'blk' of an empty ProDOS volume (key block, volume directory and bitmap)
+static void prodos_block(uint8_t* buf, uint16_t blk, uint32_t total, const char* name)
+{
+  uint16_t bitmap_blocks = (total+4095)/4096;
+  memset(buf, 0, 512);
+  if ((blk >= 2)&&(blk <= 5))
+  {
+    // volume directory: linked list of blocks 2-5
+    buf[0] = (blk > 2) ? blk-1 : 0;
+    buf[2] = (blk < 5) ? blk+1 : 0;
+    if (blk == 2)
+    {
+      uint8_t len = strlen(name);
+      buf[0x04] = 0xf0 | len;
+      memcpy(&buf[0x05], name, len);
+      buf[0x22] = 0xc3;   // access: destroy/rename/write/read
+      buf[0x23] = 0x27;   // entry length
+      buf[0x24] = 0x0d;   // entries per block
+      buf[0x27] = 6;      // bitmap pointer
+      buf[0x29] = total & 0xff;
+      buf[0x2a] = total >> 8;
+    }
+  }
+  else
+  if ((blk >= 6)&&(blk < 6+bitmap_blocks))
+  {
+    // bitmap: bit set=free, blocks 0-5 and the bitmap itself are used
+    uint32_t first = (blk-6)*4096;
+    for (uint16_t i=0;i<4096;i++)
+    {
+      uint32_t b = first+i;
+      if ((b >= 6u+bitmap_blocks)&&(b < total))
+        buf[i>>3] |= 0x80 >> (i&7);
+    }
+  }
+}
+
+static int create_image(const char* path, uint64_t size)
+{
+  int fd = open(path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+  if ((fd < 0)||(ftruncate(fd, size) != 0))
+  {
+    perror(path);
+    exit(1);
+  }
+  return fd;
+}
+
+static void mkraw(const char* path, uint32_t volumes)
+{
+  uint8_t buf[512];
+  int fd = create_image(path, ((uint64_t) volumes) << 25);
+  for (uint32_t vol=0;vol<volumes;vol++)
+  {
+    char name[8];
+    snprintf(name, sizeof(name), "RAW%02X", (uint8_t) vol);
+    for (uint16_t blk=2;blk<6+16;blk++)
+    {
+      prodos_block(buf, blk, 65535, name);
+      if (pwrite(fd, buf, 512, ((((off_t) vol) << 16) + blk) * 512) != 512)
+      {
+        perror(path);
+        exit(1);
+      }
+    }
+  }
+  close(fd);
+}
+
+static void mkfat(const char* path, uint32_t megabytes, uint32_t volumes, uint32_t blocks)
+{
+  FATFS   fs;
+  FIL     fil;
+  UINT    bw;
+  uint8_t buf[512];
+  uint8_t work[FF_MAX_SS];
+
+  close(create_image(path, ((uint64_t) megabytes) << 20));
+  if ((blocks == 0)||(blocks > 65535)||(!mmc_host_open(SDSLOT1, path)))
+    usage();
+
+  MKFS_PARM opt = {FM_ANY, 0, 0, 0, 0};
+  if ((f_mkfs("0:", &opt, work, sizeof(work)) != FR_OK)||(f_mount(&fs, "0:", 1) != FR_OK))
+  {
+    fprintf(stderr, "Cannot format %s\n", path);
+    exit(1);
+  }
+
+  for (uint32_t vol=0;vol<volumes;vol++)
+  {
+    char name[16];
+    snprintf(name, sizeof(name), "0:VOL%02X.PO", (uint8_t) vol);
+    if ((f_open(&fil, name, FA_CREATE_ALWAYS|FA_WRITE) != FR_OK)||
+        (f_lseek(&fil, blocks*512) != FR_OK)||(f_tell(&fil) != blocks*512))
+    {
+      fprintf(stderr, "Cannot create %s: disk full?\n", &name[2]);
+      exit(1);
+    }
+    for (uint16_t blk=2;blk<6+16;blk++)
+    {
+      name[7] = 0; // ProDOS volume name: VOLxx
+      prodos_block(buf, blk, blocks, &name[2]);
+      f_lseek(&fil, blk*512);
+      f_write(&fil, buf, 512, &bw);
+    }
+    f_close(&fil);
+  }
+  f_unmount("0:");
+  mmc_host_close();
+}
+
+/* Commands ************************************************************************************************/
+
+static void info(void)
+{
+  uint8_t buf[512];
+  for (uint8_t slot=0;slot<2;slot++)
+    fprintf(stderr, "SD%u: %s\n", slot+1, SlotTypeNames[slot_type[slot]+1]);
+
+  for (uint8_t drive=0;drive<2;drive++)
+  {
+    uint8_t u = (drive << 7) | (a2slot << 4);
+    fprintf(stderr, "Drive %u (unit $%02X): ", drive+1, u);
+    if (host_read(u, 2, buf) != PRODOS_OK)
+    {
+      fprintf(stderr, "no volume\n");
+      continue;
+    }
+    uint32_t blocks=0, sector=0;
+    uint16_t frags=0;
+    vol_get_extents(&blocks, &sector, &frags);
+    uint8_t len = ((buf[4] & 0xf0) == 0xf0) ? buf[4] & 0xf : 0;
+    fprintf(stderr, "SD%u volume $%02X, /%.*s, %u blocks, start sector %u, %u fragment(s)\n",
+            request.sdslot+1, request.filenum, len, &buf[5], blocks, sector, frags);
+  }
+}
+
+static void transfer(uint8_t u, uint16_t blk, uint32_t count, bool write)
+{
+  uint8_t buf[512];
+  while (count--)
+  {
+    uint8_t returncode;
+    if (write)
+    {
+      if (fread(buf, 1, 512, stdin) != 512)
+        break;
+      returncode = host_write(u, blk, buf);
+    }
+    else
+    {
+      returncode = host_read(u, blk, buf);
+      if (returncode == PRODOS_OK)
+        fwrite(buf, 1, 512, stdout);
+    }
+    if (returncode != PRODOS_OK)
+    {
+      fprintf(stderr, "Block %u: error $%02X\n", blk, returncode);
+      exit(1);
+    }
+    host_idle();
+    blk++;
+  }
+  if (host_flush() != PRODOS_OK)
+  {
+    fprintf(stderr, "Flush failed\n");
+    exit(1);
+  }
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static void bench(uint8_t u, uint32_t count, uint8_t multi)
+{
+  static uint8_t buf[255*512];
+  uint32_t blocks = 0;
+  double start = now();
+  memset(&mmc_host_stats, 0, sizeof(mmc_host_stats));
+
+  while (blocks < count)
+  {
+    uint8_t n = (count-blocks > multi) ? multi : count-blocks;
+    uint8_t returncode = (multi > 1) ? host_read_multi(u, blocks, n, buf) : host_read(u, blocks, buf);
+    if (returncode != PRODOS_OK)
+    {
+      fprintf(stderr, "Block %u: error $%02X\n", blocks, returncode);
+      break;
+    }
+    host_idle();
+    blocks += (multi > 1) ? n : 1;
+  }
+
+  double elapsed = now()-start;
+  fprintf(stderr, "%u blocks in %.3f ms: %.2f us/block\n", blocks, elapsed*1e3, (blocks) ? elapsed*1e6/blocks : 0.0);
+  fprintf(stderr, "SD commands: CMD17=%u CMD18=%u CMD24=%u CMD25=%u stop=%u\n",
+          mmc_host_stats.cmd_read, mmc_host_stats.cmd_read_multi,
+          mmc_host_stats.cmd_write, mmc_host_stats.cmd_write_multi, mmc_host_stats.cmd_stop);
+  fprintf(stderr, "SD sectors: read=%u written=%u streamed=%u\n",
+          mmc_host_stats.sectors_read, mmc_host_stats.sectors_written, mmc_host_stats.sectors_streamed);
+  fprintf(stderr, "FAT mounts: %u\n", vol_mounts);
+#ifdef USE_BLOCK_CACHE
+  fprintf(stderr, "Block cache: hits=%u misses=%u\n", vol_cache_hits, vol_cache_misses);
+#endif
+#ifdef USE_READ_AHEAD
+  fprintf(stderr, "Read-ahead: reads=%u hits=%u aborts=%u\n", vol_ahead_reads, vol_ahead_hits, vol_ahead_aborts);
+#endif
+}
+
+// boot menu: volume names of both SD cards, 16 volumes per page and card. Compares the volume catalog
+// command with the previous method (select each volume, read its block 2).
+static void catalog(uint32_t pages, bool verbose)
+{
+  static uint8_t buf[8*512];
+  uint8_t u = a2slot << 4;
+  if (pages > 8)
+    pages = 8;
+
+  for (uint8_t method=0;method<2;method++)
+  {
+    uint32_t commands = 0, names = 0;
+    memset(&mmc_host_stats, 0, sizeof(mmc_host_stats));
+    double start = now();
+    for (uint8_t page=0;page<pages;page++)
+    {
+      for (uint8_t sd=0;sd<2;sd++)
+      {
+        uint8_t first = (sd << 7) | (page << 4);
+        if (method == 0)
+        {
+          host_volume_catalog(first, 1, buf);
+          commands++;
+        }
+        else
+        for (uint8_t i=0;i<16;i++)
+        {
+          uint8_t* entry = &buf[i*32];
+          memset(entry, 0, 32);
+          entry[0] = first+i;
+          host_set_volume(HOST_CMD_SET_VOLUME1, u, first+i);
+          if ((host_read(u, 2, buf+512) == PRODOS_OK)&&((buf[512+4] & 0xf0) == 0xf0))
+          {
+            entry[1] = 0x01;
+            entry[4] = buf[512+4];
+            memcpy(&entry[5], &buf[512+5], 15);
+          }
+          commands += 2;
+        }
+        for (uint8_t i=0;i<16;i++)
+        {
+          uint8_t* entry = &buf[i*32];
+          if (entry[1] & 0x01)
+          {
+            names++;
+            if ((verbose)&&(method == 0))
+              fprintf(stderr, "SD%u VOL%02X /%.*s, %u blocks\n", sd+1, entry[0] & 0x7f, entry[4] & 0xf, &entry[5],
+                      entry[2] | (entry[3] << 8));
+          }
+        }
+      }
+    }
+    double elapsed = now()-start;
+    // each command: 6 bytes to the card, status + 512 bytes from the card
+    fprintf(stderr, "%s: %u names, %u commands, %u bytes via the 82C55, %u SD sectors, %.3f ms\n",
+            (method == 0) ? "catalog command" : "select+read    ", names, commands, commands*(6+513),
+            mmc_host_stats.sectors_read, elapsed*1e3);
+  }
+}
+
+/* Ethernet ************************************************************************************************/
+
+// Rough timing of the card, to convert the counted operations to frames per second. The Apple II waits
+// for the card, so the times of both sides add up.
+#define ETH_US_COMMAND     40.0 // Apple II driver call and command handshake
+#define ETH_US_PIO_BYTE    12.0 // 6502 transfer loop, per byte through the 82C55
+#define ETH_US_SPI_SELECT   8.0 // two digitalWrite() calls for the W5500 chip select
+#define ETH_US_SPI_BYTE     1.5 // SPI at 8MHz, plus the AVR loop
+
+// Receive throughput while frames are queued: before each poll command, the W5500's RX buffer is
+// topped up with frames from the tap interface (sent by a packet generator, see ethgen.py).
+static void ethbench(const char* tap, uint32_t count, uint32_t budget)
+{
+  static const uint8_t mac[6] = {0x00, 0x08, 0xDC, 0x00, 0x00, 0x01};
+  static uint8_t buf[65536];
+  if ((budget < 2+1514)||(budget > sizeof(buf)))
+    usage();
+  if (!w5500_host_open(tap))
+    exit(1);
+  if (host_eth_init(mac) != 0)
+  {
+    fprintf(stderr, "W5500 initialization failed\n");
+    exit(1);
+  }
+
+  for (uint8_t batch=0;batch<2;batch++)
+  {
+    uint32_t commands = 0, frames = 0, bytes = 0;
+    memset(&w5500_host_stats, 0, sizeof(w5500_host_stats));
+    while (frames < count)
+    {
+      double timeout = now()+1.0;
+      while (w5500_host_receive() < 16384-1600)
+      {
+        if (now() > timeout)
+          break;
+        usleep(100);
+      }
+      if (now() > timeout)
+      {
+        fprintf(stderr, "No frames from %s\n", tap);
+        break;
+      }
+      if (batch)
+      {
+        uint16_t n = host_eth_poll_batch(budget, buf);
+        for (uint16_t i=0, pos=0;i<n;i++)
+        {
+          uint16_t len = buf[pos] | (buf[pos+1] << 8);
+          bytes += len;
+          pos += 2+len;
+        }
+        frames += n;
+      }
+      else
+      {
+        uint16_t len = host_eth_poll(1514, buf);
+        bytes += len;
+        frames += (len > 0);
+      }
+      commands++;
+    }
+    if (!frames)
+      return;
+
+    const W5500_HOST_STATS* st = &w5500_host_stats;
+    double us = commands*ETH_US_COMMAND + (st->pio_out + st->pio_in)*ETH_US_PIO_BYTE +
+                st->spi_selects*ETH_US_SPI_SELECT + st->spi_bytes*ETH_US_SPI_BYTE;
+    fprintf(stderr, "%s: %u frames (%u bytes avg), %u commands\n",
+            (batch) ? "batched poll (0x13)" : "poll (0x11)        ", frames, bytes/frames, commands);
+    fprintf(stderr, "  per frame: %.2f commands, %.1f SPI selects, %.1f SPI bytes, %.1f 82C55 bytes\n",
+            (double) commands/frames, (double) st->spi_selects/frames, (double) st->spi_bytes/frames,
+            (double) (st->pio_out + st->pio_in)/frames);
+    fprintf(stderr, "  estimated %.0f us/frame, %.0f frames/s (%u frames dropped by the W5500)\n",
+            us/frames, frames*1e6/us, st->frames_dropped);
+  }
+}
+
+// transmit frames (i.e. a TCP burst of IP65) with one command per frame (0x12) and with lists of frames (0x15)
+static void ethsend(const char* tap, uint32_t count, uint32_t size, uint32_t batch)
+{
+  static const uint8_t mac[6] = {0x00, 0x08, 0xDC, 0x00, 0x00, 0x01};
+  static uint8_t frame[1514];
+  static uint8_t list[65536];
+  if ((size < 60)||(size > sizeof(frame))||(batch < 1)||(batch*(2+size)+2 > sizeof(list)))
+    usage();
+  if (!w5500_host_open(tap))
+    exit(1);
+  if (host_eth_init(mac) != 0)
+  {
+    fprintf(stderr, "W5500 initialization failed\n");
+    exit(1);
+  }
+
+  // broadcast frames with a local experimental EtherType
+  memset(frame, 0xff, 6);
+  memcpy(&frame[6], mac, 6);
+  frame[12] = 0x88;
+  frame[13] = 0xB5;
+  for (uint16_t i=14;i<size;i++)
+    frame[i] = i;
+
+  for (uint8_t batched=0;batched<2;batched++)
+  {
+    uint32_t commands = 0, frames = 0, failed = 0;
+    memset(&w5500_host_stats, 0, sizeof(w5500_host_stats));
+    while (frames < count)
+    {
+      if (batched)
+      {
+        uint32_t n = (count - frames < batch) ? count - frames : batch;
+        uint32_t pos = 0;
+        for (uint32_t i=0;i<n;i++)
+        {
+          list[pos++] = size & 0xff;
+          list[pos++] = size >> 8;
+          memcpy(&list[pos], frame, size);
+          pos += size;
+        }
+        list[pos++] = 0;
+        list[pos++] = 0;
+        failed += host_eth_send_batch(list);
+        frames += n;
+      }
+      else
+      {
+        host_eth_send(frame, size);
+        frames++;
+      }
+      commands++;
+    }
+
+    const W5500_HOST_STATS* st = &w5500_host_stats;
+    double us = commands*ETH_US_COMMAND + (st->pio_out + st->pio_in)*ETH_US_PIO_BYTE +
+                st->spi_selects*ETH_US_SPI_SELECT + st->spi_bytes*ETH_US_SPI_BYTE;
+    fprintf(stderr, "%s: %u frames (%u bytes), %u commands, %u frames sent by the W5500%s\n",
+            (batched) ? "batched send (0x15)" : "send (0x12)        ", frames, size, commands, st->frames_sent,
+            (failed) ? ", FAILED" : "");
+    fprintf(stderr, "  per frame: %.2f commands, %.1f SPI selects, %.1f SPI bytes, %.1f 82C55 bytes\n",
+            (double) commands/frames, (double) st->spi_selects/frames, (double) st->spi_bytes/frames,
+            (double) (st->pio_out + st->pio_in)/frames);
+    fprintf(stderr, "  estimated %.0f us/frame, %.0f frames/s\n", us/frames, frames*1e6/us);
+  }
+}
+
+#ifdef USE_ETHERNET_FILTER
+// frames meant for us in the mix of ethgen.py: UDP to our MAC address and port 6502, ARP for our IP address
+static bool eth_wanted(const uint8_t* frame, uint16_t len, const uint8_t* mac, const uint8_t* ip)
+{
+  if ((len >= 42)&&(frame[12] == 0x08)&&(frame[13] == 0x06))
+    return (memcmp(&frame[38], ip, 4) == 0);
+  return (len >= 38)&&(memcmp(frame, mac, 6) == 0)&&(frame[12] == 0x08)&&(frame[13] == 0x00)&&
+         (frame[23] == 17)&&(frame[36] == (6502 >> 8))&&(frame[37] == (6502 & 0xff));
+}
+
+// Receive a mix of frames (ethgen.py --mix) with the batched poll command, without and with the receive filter
+static void ethfilter(const char* tap, uint32_t count)
+{
+  static const uint8_t  mac[6] = {0x00, 0x08, 0xDC, 0x00, 0x00, 0x01};
+  static const uint8_t  ip[4]  = {192, 168, 99, 2};
+  static const uint16_t ethertypes[2] = {0, 0};
+  static const uint16_t ports[4] = {6502, 0, 0, 0};
+  static uint8_t buf[4096];
+  if (!w5500_host_open(tap))
+    exit(1);
+
+  for (uint8_t filter=0;filter<2;filter++)
+  {
+    uint32_t commands = 0, frames = 0, wanted = 0;
+    uint16_t delivered, dropped;
+    if (host_eth_init(mac) != 0)
+    {
+      fprintf(stderr, "W5500 initialization failed\n");
+      exit(1);
+    }
+    if (filter)
+      host_eth_filter(0x1f, ip, ethertypes, ports);
+    memset(&w5500_host_stats, 0, sizeof(w5500_host_stats));
+    while (wanted < count)
+    {
+      double timeout = now()+1.0;
+      while (w5500_host_receive() < 16384-1600)
+      {
+        if (now() > timeout)
+          break;
+        usleep(100);
+      }
+      if (now() > timeout)
+      {
+        fprintf(stderr, "No frames from %s\n", tap);
+        break;
+      }
+      uint16_t n = host_eth_poll_batch(sizeof(buf), buf);
+      for (uint16_t i=0, pos=0;i<n;i++)
+      {
+        uint16_t len = buf[pos] | (buf[pos+1] << 8);
+        wanted += eth_wanted(&buf[pos+2], len, mac, ip);
+        pos += 2+len;
+      }
+      frames += n;
+      commands++;
+    }
+    if (!wanted)
+      return;
+    host_eth_counters(&delivered, &dropped);
+
+    const W5500_HOST_STATS* st = &w5500_host_stats;
+    double us = commands*ETH_US_COMMAND + (st->pio_out + st->pio_in)*ETH_US_PIO_BYTE +
+                st->spi_selects*ETH_US_SPI_SELECT + st->spi_bytes*ETH_US_SPI_BYTE;
+    fprintf(stderr, "%s: %u frames delivered, %u of them for us, %u dropped by the filter\n",
+            (filter) ? "with filter   " : "without filter", frames, wanted, dropped);
+    fprintf(stderr, "  per frame for us: %.2f frames delivered, %.3f commands, %.1f SPI bytes, %.1f 82C55 bytes\n",
+            (double) frames/wanted, (double) commands/wanted, (double) st->spi_bytes/wanted,
+            (double) (st->pio_out + st->pio_in)/wanted);
+    fprintf(stderr, "  estimated %.0f us/frame for us (%u frames dropped by the W5500)\n",
+            us/wanted, st->frames_dropped);
+    if ((filter)&&(frames != wanted))
+    {
+      fprintf(stderr, "Filter passed %u frames not meant for us\n", frames-wanted);
+      exit(1);
+    }
+    if (delivered != (uint16_t) frames)
+    {
+      fprintf(stderr, "Frame counter mismatch: %u delivered, %u counted\n", delivered, frames);
+      exit(1);
+    }
+  }
+}
+#endif
+
+#ifdef USE_ETHERNET_SOCKETS
+static void sock_report(const char* name, uint32_t commands, uint32_t bytes)
+{
+  const W5500_HOST_STATS* st = &w5500_host_stats;
+  double us = commands*ETH_US_COMMAND + (st->pio_out + st->pio_in)*ETH_US_PIO_BYTE +
+              st->spi_selects*ETH_US_SPI_SELECT + st->spi_bytes*ETH_US_SPI_BYTE;
+  fprintf(stderr, "%s: %u payload bytes (sent and received), %u commands\n", name, bytes, commands);
+  fprintf(stderr, "  per KB: %.1f commands, %.1f SPI selects, %.0f SPI bytes, %.0f 82C55 bytes\n",
+          commands*1024.0/bytes, st->spi_selects*1024.0/bytes, st->spi_bytes*1024.0/bytes,
+          (st->pio_out + st->pio_in)*1024.0/bytes);
+  fprintf(stderr, "  estimated %.1f KB/s\n", bytes*1e6/1024/us);
+}
+
+// Echo test of the socket commands: TCP data and UDP datagrams are sent to an echo server (see
+// echoserver.py) and compared with the returned data.
+static void sockbench(const char* ip_str, uint16_t port, uint32_t kbytes)
+{
+  static const uint8_t config[18] = {0x00, 0x08, 0xDC, 0x00, 0x00, 0x01, // MAC
+                                     127, 0, 0, 2,                       // IP (unused by the model)
+                                     255, 0, 0, 0,                       // subnet
+                                     127, 0, 0, 1};                      // gateway
+  static uint8_t tx[65536], rx[65536], buf[2048];
+  uint8_t  ip[4];
+  uint16_t received, txfree;
+  uint32_t total = kbytes*1024;
+  if ((sscanf(ip_str, "%hhu.%hhu.%hhu.%hhu", &ip[0], &ip[1], &ip[2], &ip[3]) != 4)||(total > sizeof(tx)))
+    usage();
+  for (uint32_t i=0;i<total;i++)
+    tx[i] = (i*7) + (i>>8);
+
+  w5500_host_open(NULL);
+  if (host_sock_init(config) != 0)
+  {
+    fprintf(stderr, "W5500 initialization failed\n");
+    exit(1);
+  }
+
+  // TCP: send 1KB per command, read what was echoed so far
+  memset(&w5500_host_stats, 0, sizeof(w5500_host_stats));
+  uint8_t  s = host_sock_open(1, 0);
+  uint32_t commands = 1, sent = 0, recvd = 0;
+  if ((s == 0xff)||(host_sock_connect(s, ip, port) != 0)||(host_sock_status(s, &received, &txfree) != 0x17))
+  {
+    fprintf(stderr, "TCP connection to %s:%u failed\n", ip_str, port);
+    exit(1);
+  }
+  commands += 2;
+  double timeout = now()+5.0;
+  while ((recvd < total)&&(now() < timeout))
+  {
+    if (sent < total)
+    {
+      sent += host_sock_send(s, &tx[sent], (total-sent > 1024) ? 1024 : total-sent);
+      commands++;
+    }
+    w5500_host_receive();
+    uint16_t len = host_sock_recv(s, &rx[recvd], (total-recvd > 1024) ? 1024 : total-recvd);
+    recvd += len;
+    commands++;
+    if (len == 0)
+      usleep(100);
+  }
+  host_sock_close(s, false);
+  commands++;
+  if ((recvd != total)||(memcmp(tx, rx, total)))
+  {
+    fprintf(stderr, "TCP: echo mismatch (%u of %u bytes)\n", recvd, total);
+    exit(1);
+  }
+  sock_report("TCP 1KB send/recv", commands, sent+recvd);
+
+  // UDP: one 512 byte datagram per send, received with its 8 byte header
+  memset(&w5500_host_stats, 0, sizeof(w5500_host_stats));
+  s = host_sock_open(2, 0);
+  commands = 2;
+  if ((s == 0xff)||(host_sock_connect(s, ip, port) != 0))
+  {
+    fprintf(stderr, "UDP socket failed\n");
+    exit(1);
+  }
+  sent = recvd = 0;
+  timeout = now()+5.0;
+  while ((recvd < total)&&(now() < timeout))
+  {
+    if ((sent < total)&&(sent < recvd+4096))
+    {
+      sent += host_sock_send(s, &tx[sent], 512);
+      commands++;
+    }
+    w5500_host_receive();
+    uint16_t len = host_sock_recv(s, buf, sizeof(buf));
+    commands++;
+    if (len > 8)
+    {
+      if ((len != 8+512)||(memcmp(&tx[recvd], &buf[8], 512)))
+      {
+        fprintf(stderr, "UDP: echo mismatch at %u\n", recvd);
+        exit(1);
+      }
+      recvd += 512;
+    }
+    else
+      usleep(100);
+  }
+  host_sock_close(s, true);
+  commands++;
+  if (recvd != total)
+  {
+    fprintf(stderr, "UDP: %u of %u bytes echoed\n", recvd, total);
+    exit(1);
+  }
+  sock_report("UDP 512 byte datagrams", commands, sent+recvd);
+}
+#endif
+
+/* Trace replay ********************************************************************************************/
+
+typedef struct
+{
+  uint8_t  cmd;
+  uint8_t  unit;
+  uint16_t blk;
+  uint8_t  count;
+} trace_cmd_t;
+
+// counters reported per command
+enum { C_CMD17, C_CMD18, C_CMD24, C_CMD25, C_CMD12, C_SECT_RD, C_SECT_WR,
+       C_WIN_RD, C_WIN_WR, C_OPEN, C_MOUNT, C_COUNT };
+static const char* ReplayColumns[C_COUNT] = {"CMD17", "CMD18", "CMD24", "CMD25", "CMD12", "sectRd", "sectWr",
+                                             "winRd", "winWr", "fopen", "mount"};
+
+static void replay_counters(uint32_t* c)
+{
+  c[C_CMD17]   = mmc_host_stats.cmd_read;
+  c[C_CMD18]   = mmc_host_stats.cmd_read_multi;
+  c[C_CMD24]   = mmc_host_stats.cmd_write;
+  c[C_CMD25]   = mmc_host_stats.cmd_write_multi;
+  c[C_CMD12]   = mmc_host_stats.cmd_stop;
+  c[C_SECT_RD] = mmc_host_stats.sectors_read;
+  c[C_SECT_WR] = mmc_host_stats.sectors_written;
+  c[C_WIN_RD]  = fatfs_host_stats.window_reads;
+  c[C_WIN_WR]  = fatfs_host_stats.window_writes;
+  c[C_OPEN]    = fatfs_host_stats.file_opens;
+  c[C_MOUNT]   = fatfs_host_stats.mounts;
+}
+
+static const char* command_name(uint16_t cmd)
+{
+  switch (cmd)
+  {
+    case HOST_CMD_STATUS:             return "status";
+    case HOST_CMD_READ:               return "read";
+    case HOST_CMD_WRITE:              return "write";
+    case HOST_CMD_FORMAT:             return "format";
+    case HOST_CMD_SET_VOLUME:
+    case HOST_CMD_SET_VOLUME_PREVIEW:
+    case HOST_CMD_SET_VOLUME_BLOCK:
+    case HOST_CMD_SET_VOLUME1:        return "set_volume";
+    case HOST_CMD_READ_FAILSAFE:      return "read_failsafe";
+    case HOST_CMD_READ_MULTI:         return "read_multi";
+    case HOST_CMD_WRITE_MULTI:        return "write_multi";
+    case HOST_CMD_FLUSH:              return "flush";
+    case HOST_CMD_SET_WRITE_BACK:     return "set_write_back";
+    case 0x100:                       return "(idle)";
+  }
+  return "(not replayed)";
+}
+
+// load a binary trace (TRACE.BIN) or a text trace ("time duration cmd unit blk count ...", see dan2trace.py)
+static uint32_t load_trace(const char* path, trace_cmd_t** trace)
+{
+  FILE* f = fopen(path, "rb");
+  if (!f)
+  {
+    perror(path);
+    exit(1);
+  }
+
+  uint32_t count = 0, size = 0;
+  *trace = NULL;
+
+  uint8_t header[16];
+  if ((fread(header, 1, sizeof(header), f) == sizeof(header))&&(memcmp(header, "DTRC", 4) == 0))
+  {
+    // binary trace file, as recorded by the firmware
+    uint8_t  entry_size = header[5];
+    uint16_t entries    = header[8] | (header[9] << 8);
+    uint8_t  entry[256];
+    *trace = (trace_cmd_t*) calloc(entries+1, sizeof(trace_cmd_t));
+    while ((count < entries)&&(entry_size >= 10)&&(fread(entry, 1, entry_size, f) == entry_size))
+    {
+      trace_cmd_t* t = &(*trace)[count++];
+      t->cmd   = entry[4];
+      t->unit  = entry[5];
+      t->blk   = entry[6] | (entry[7] << 8);
+      t->count = entry[8];
+    }
+  }
+  else
+  {
+    // text trace
+    char line[256];
+    rewind(f);
+    while (fgets(line, sizeof(line), f))
+    {
+      unsigned int time, duration, cmd, u, blk, blocks;
+      if ((line[0] == '#')||(sscanf(line, "%u %u %x %x %u %u", &time, &duration, &cmd, &u, &blk, &blocks) != 6))
+        continue;
+      if (count >= size)
+      {
+        size = (size) ? size*2 : 1024;
+        *trace = (trace_cmd_t*) realloc(*trace, size*sizeof(trace_cmd_t));
+      }
+      trace_cmd_t* t = &(*trace)[count++];
+      t->cmd   = cmd;
+      t->unit  = u;
+      t->blk   = blk;
+      t->count = blocks;
+    }
+  }
+  fclose(f);
+  return count;
+}
+
+// execute a command like do_command(), returns 0xFF for commands which are not replayed
+static uint8_t replay_command(const trace_cmd_t* t, uint8_t* buf)
+{
+  switch (t->cmd)
+  {
+    case HOST_CMD_STATUS:
+    case HOST_CMD_FORMAT:         return host_status(t->unit, t->blk);
+    case HOST_CMD_READ:
+    case HOST_CMD_READ_FAILSAFE:  return host_read(t->unit, t->blk, buf);
+    case HOST_CMD_WRITE:          return host_write(t->unit, t->blk, buf);
+    case HOST_CMD_READ_MULTI:     return host_read_multi(t->unit, t->blk, t->count, buf);
+    case HOST_CMD_WRITE_MULTI:    return host_write_multi(t->unit, t->blk, t->count, buf);
+    case HOST_CMD_FLUSH:          return host_flush();
+    case HOST_CMD_SET_WRITE_BACK: return host_set_write_back(t->blk == 1);
+    case HOST_CMD_SET_VOLUME:
+    case HOST_CMD_SET_VOLUME_PREVIEW:
+    case HOST_CMD_SET_VOLUME_BLOCK:
+    case HOST_CMD_SET_VOLUME1:
+      host_set_volume(t->cmd, t->unit, t->blk);
+      return PRODOS_OK;
+  }
+  return 0xFF;
+}
+
+static void replay(const char* path, bool verbose)
+{
+  static uint8_t buf[255*512];
+  static uint32_t totals[0x101][C_COUNT];   // per command code, 0x100: idle processing
+  static uint32_t commands[0x101], errors[0x101];
+  uint32_t before[C_COUNT], after[C_COUNT];
+  trace_cmd_t* trace;
+
+  uint32_t count = load_trace(path, &trace);
+  memset(&mmc_host_stats, 0, sizeof(mmc_host_stats));
+  memset(&fatfs_host_stats, 0, sizeof(fatfs_host_stats));
+  memset(buf, 0xA5, sizeof(buf));
+
+  if (verbose)
+  {
+    printf("#   no cmd unit   blk cnt res");
+    for (int c=0;c<C_COUNT;c++)
+      printf(" %6s", ReplayColumns[c]);
+    printf("\n");
+  }
+
+  for (uint32_t i=0;i<count;i++)
+  {
+    const trace_cmd_t* t = &trace[i];
+    for (int pass=0;pass<2;pass++)
+    {
+      // pass 0: the command, pass 1: the firmware's idle processing until the next command
+      uint16_t id = (pass == 0) ? t->cmd : 0x100;
+      uint8_t  returncode = 0;
+      replay_counters(before);
+      if (pass == 0)
+        returncode = replay_command(t, buf);
+      else
+        host_idle();
+      replay_counters(after);
+
+      commands[id]++;
+      if ((returncode != PRODOS_OK)&&(returncode != 0xFF))
+        errors[id]++;
+      for (int c=0;c<C_COUNT;c++)
+        totals[id][c] += after[c]-before[c];
+
+      if (verbose && (pass == 0))
+      {
+        printf("%6u  %02X   %02X %5u %3u  %02X", i, t->cmd, t->unit, t->blk, t->count, returncode);
+        for (int c=0;c<C_COUNT;c++)
+          printf(" %6u", after[c]-before[c]);
+        printf(" %s\n", command_name(t->cmd));
+      }
+    }
+  }
+  free(trace);
+
+  fprintf(stderr, "%-16s %7s %6s", "command", "count", "errors");
+  for (int c=0;c<C_COUNT;c++)
+    fprintf(stderr, " %7s", ReplayColumns[c]);
+  fprintf(stderr, " %9s\n", "SDcmd/cmd");
+  for (uint16_t id=0;id<=0x100;id++)
+  {
+    if (!commands[id])
+      continue;
+    uint32_t sd = totals[id][C_CMD17]+totals[id][C_CMD18]+totals[id][C_CMD24]+totals[id][C_CMD25];
+    if (id < 0x100)
+      fprintf(stderr, "%02X %-13s", id, command_name(id));
+    else
+      fprintf(stderr, "%-16s", command_name(id));
+    fprintf(stderr, " %7u %6u", commands[id], errors[id]);
+    for (int c=0;c<C_COUNT;c++)
+      fprintf(stderr, " %7u", totals[id][c]);
+    fprintf(stderr, " %9.2f\n", (double) sd/commands[id]);
+  }
+  fprintf(stderr, "%u commands replayed.\n", count);
+}
+
+static void ftp(const char* ip)
+{
+  unsigned int a, b, c, d;
+  if (sscanf(ip, "%u.%u.%u.%u", &a, &b, &c, &d) != 4)
+    usage();
+  FtpMacIpPortData[6] = a; FtpMacIpPortData[7] = b;
+  FtpMacIpPortData[8] = c; FtpMacIpPortData[9] = d;
+  fprintf(stderr, "FTP server: %s, port %u\n", ip, FTP_CMD_PORT+ETHERNET_HOST_PORT_OFFSET);
+  // Like loop() of the firmware: each call of loopTinyFtp() processes a single step. Its duration is the
+  // maximum delay of an Apple II command, which is reported for each data transfer.
+  unsigned int  steps = 0, max_sectors = 0, total_sectors = 0;
+  unsigned long max_us = 0, total_us = 0;
+  while (FtpState != FTP_DISABLED)
+  {
+    bool          transfer = (FtpState == FTP_TRANSFER);
+    unsigned long us       = micros();
+    uint32_t      sectors  = mmc_host_stats.sectors_read+mmc_host_stats.sectors_written;
+    loopTinyFtp();
+    us      = micros()-us;
+    sectors = mmc_host_stats.sectors_read+mmc_host_stats.sectors_written-sectors;
+    if (transfer)
+    {
+      steps++;
+      total_sectors += sectors;
+      if (sectors)
+        total_us += us;
+      if (us > max_us)
+        max_us = us;
+      if (sectors > max_sectors)
+        max_sectors = sectors;
+      if (FtpState != FTP_TRANSFER)
+      {
+        fprintf(stderr, "FTP transfer: %u steps, longest step %lu us, at most %u SD sectors per step, "
+                "%u SD sectors in %lu us total\n", steps, max_us, max_sectors, total_sectors, total_us);
+        steps = max_sectors = total_sectors = 0;
+        max_us = total_us = 0;
+      }
+    }
+    host_idle();
+    if (FtpState != FTP_TRANSFER)
+      delay((FtpState == FTP_CONNECTED) ? 1 : 10);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  uint8_t drive1 = 0x00, drive2 = 0x88;
+  uint8_t slot = 7;
+  bool    write_back = false;
+  bool    verbose = false;
+  int     opt;
+
+  while ((opt = getopt(argc, argv, "1:2:m:s:wv")) != -1)
+  {
+    switch (opt)
+    {
+      case '1':
+      case '2':
+        if (!mmc_host_open(opt-'1', optarg))
+        {
+          perror(optarg);
+          return 1;
+        }
+        break;
+      case 'm':
+        if (sscanf(optarg, "%hhx,%hhx", &drive1, &drive2) != 2)
+          usage();
+        break;
+      case 's': slot = number(optarg, 10); break;
+      case 'w': write_back = true; break;
+      case 'v': verbose = true; break;
+      default: usage();
+    }
+  }
+  argc -= optind;
+  argv += optind;
+  if (argc < 1)
+    usage();
+
+  const char* cmd = argv[0];
+  if ((!strcmp(cmd, "mkfat"))&&((argc == 4)||(argc == 5)))
+  {
+    mkfat(argv[1], number(argv[2], 10), number(argv[3], 10), (argc == 5) ? number(argv[4], 10) : 65535);
+    return 0;
+  }
+  if ((!strcmp(cmd, "mkraw"))&&(argc == 3))
+  {
+    mkraw(argv[1], number(argv[2], 10));
+    return 0;
+  }
+
+  host_setup(drive1, drive2, slot, write_back);
+
+  if ((!strcmp(cmd, "info"))&&(argc == 1))
+    info();
+  else
+  if ((!strcmp(cmd, "read")||!strcmp(cmd, "write"))&&(argc >= 3)&&(argc <= 4))
+    transfer(number(argv[1], 16), number(argv[2], 10), (argc == 4) ? number(argv[3], 10) : 1, (cmd[0] == 'w'));
+  else
+  if ((!strcmp(cmd, "bench"))&&(argc >= 2)&&(argc <= 4))
+  {
+    uint32_t multi = (argc == 4) ? number(argv[3], 10) : 1;
+    if ((multi < 1)||(multi > 255))
+      usage();
+    bench(number(argv[1], 16), (argc >= 3) ? number(argv[2], 10) : 1024, multi);
+  }
+  else
+  if ((!strcmp(cmd, "catalog"))&&(argc <= 2))
+    catalog((argc == 2) ? number(argv[1], 10) : 8, verbose);
+  else
+  if ((!strcmp(cmd, "ethbench"))&&(argc >= 2)&&(argc <= 4))
+    ethbench(argv[1], (argc >= 3) ? number(argv[2], 10) : 10000, (argc == 4) ? number(argv[3], 10) : 4096);
+  else
+  if ((!strcmp(cmd, "ethsend"))&&(argc >= 2)&&(argc <= 5))
+    ethsend(argv[1], (argc >= 3) ? number(argv[2], 10) : 10000, (argc >= 4) ? number(argv[3], 10) : 64,
+            (argc == 5) ? number(argv[4], 10) : 8);
+  else
+#ifdef USE_ETHERNET_FILTER
+  if ((!strcmp(cmd, "ethfilter"))&&(argc >= 2)&&(argc <= 3))
+    ethfilter(argv[1], (argc == 3) ? number(argv[2], 10) : 2000);
+  else
+#endif
+#ifdef USE_ETHERNET_SOCKETS
+  if ((!strcmp(cmd, "sockbench"))&&(argc >= 3)&&(argc <= 4))
+    sockbench(argv[1], number(argv[2], 10), (argc == 4) ? number(argv[3], 10) : 16);
+  else
+#endif
+  if ((!strcmp(cmd, "replay"))&&(argc == 2))
+    replay(argv[1], verbose);
+  else
+  if ((!strcmp(cmd, "ftp"))&&(argc <= 2))
+    ftp((argc == 2) ? argv[1] : "127.0.0.1");
+  else
+    usage();
+
+  mmc_host_close();
+  return 0;
+}
@@ -0,0 +1,88 @@
+/* dan2host.h - DAN][ host build: Apple II commands executed by the native volume layer.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+
+#include <stdint.h>
+#include "config.h"
+
+// the socket commands and the receive filter need more flash than the ATmega328P has (see Apple2Arduino.ino)
+#if !defined(USE_ETHERNET) || !defined(__AVR_ATmega644P__)
+  #undef USE_ETHERNET_SOCKETS
+  #undef USE_ETHERNET_FILTER
+#endif
+
+// same command codes as Apple2Arduino.ino
+#define HOST_CMD_STATUS             0x00
+#define HOST_CMD_READ               0x01
+#define HOST_CMD_WRITE              0x02
+#define HOST_CMD_FORMAT             0x03
+#define HOST_CMD_SET_VOLUME         0x04
+#define HOST_CMD_SET_VOLUME_PREVIEW 0x06
+#define HOST_CMD_SET_VOLUME_BLOCK   0x07
+#define HOST_CMD_SET_VOLUME1        0x08
+#define HOST_CMD_READ_FAILSAFE      0x0A
+#define HOST_CMD_READ_MULTI         0x0C
+#define HOST_CMD_WRITE_MULTI        0x0D
+#define HOST_CMD_FLUSH              0x0E
+#define HOST_CMD_SET_WRITE_BACK     0x0F
+
+// detect the SD card formats, like setup() of the firmware
+void    host_setup  (uint8_t drive1, uint8_t drive2, uint8_t slot, bool write_back);
+
+// Apple II block commands: the unit has the ProDOS format (bit 7: drive, bits 4-6: slot).
+// Each command issues the same volume layer calls as the firmware's command handler.
+uint8_t host_status (uint8_t unit, uint16_t blk);
+uint8_t host_read   (uint8_t unit, uint16_t blk, uint8_t* buf);
+uint8_t host_write  (uint8_t unit, uint16_t blk, const uint8_t* buf);
+uint8_t host_read_multi (uint8_t unit, uint16_t blk, uint8_t count, uint8_t* buf);
+uint8_t host_write_multi(uint8_t unit, uint16_t blk, uint8_t count, const uint8_t* buf);
+uint8_t host_flush  (void);
+
+// volume selection (commands 0x04/0x06/0x07/0x08: drive 1 in the low byte of blk, drive 2 in the high byte)
+void    host_set_volume(uint8_t cmd, uint8_t unit, uint16_t blk);
+uint8_t host_set_write_back(bool enable);
+
+// volume catalog (command 0x31): first volume (bit 7: SD2), number of blocks (16 volumes each, max. 8)
+void    host_volume_catalog(uint8_t volume, uint8_t count, uint8_t* buf);
+
+// Ethernet commands 0x10-0x13 and 0x15, on the W5500 model (see w5500_host.h)
+uint8_t  host_eth_init(const uint8_t* mac);
+uint16_t host_eth_poll(uint16_t len, uint8_t* buf);
+uint16_t host_eth_poll_batch(uint16_t budget, uint8_t* buf);
+void     host_eth_send(const uint8_t* frame, uint16_t len);
+uint8_t  host_eth_send_batch(const uint8_t* frames);
+
+// receive filter (command 0x14, ATmega644P): flags, IP address, EtherTypes, ports (like the command's parameters)
+uint8_t  host_eth_filter(uint8_t flags, const uint8_t* ip, const uint16_t* ethertypes, const uint16_t* ports);
+void     host_eth_counters(uint16_t* delivered, uint16_t* dropped);
+
+// socket commands 0x40-0x47, on the W5500 model
+uint8_t  host_sock_init(const uint8_t* config);
+uint8_t  host_sock_open(uint8_t protocol, uint16_t port);
+uint8_t  host_sock_connect(uint8_t s, const uint8_t* ip, uint16_t port);
+uint8_t  host_sock_listen(uint8_t s);
+uint16_t host_sock_send(uint8_t s, const uint8_t* data, uint16_t len);
+uint16_t host_sock_recv(uint8_t s, uint8_t* buf, uint16_t size);
+uint8_t  host_sock_status(uint8_t s, uint16_t* received, uint16_t* txfree);
+void     host_sock_close(uint8_t s, bool force);
+
+// background work of the firmware's main loop while the Apple II is idle (write-back, read-ahead)
+void    host_idle   (void);
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+# dan2sparse.py - convert ProDOS volume images from/to the sparse volume files of the DAN][ FTP server.
+#
+#  Copyright (c) 2023 Thorsten C. Brehm
+#
+#  This software is provided 'as-is', without any express or implied
+#  warranty. In no event will the authors be held liable for any damages
+#  arising from the use of this software.
+#
+#  Permission is granted to anyone to use this software for any purpose,
+#  including commercial applications, and to alter it and redistribute it
+#  freely, subject to the following restrictions:
+#
+#  1. The origin of this software must not be misrepresented; you must not
+#     claim that you wrote the original software. If you use this software
+#     in a product, an acknowledgment in the product documentation would be
+#     appreciated but is not required.
+#  2. Altered source versions must be plainly marked as such, and must not be
+#     misrepresented as being the original software.
+#  3. This notice may not be removed or altered from any source distribution.
+#
+# The FTP server offers each volume VOLxx.PO also as sparse file VOLxx.SPR, which only contains
+# the blocks allocated in the ProDOS volume bitmap (see ttftp.ino). All values are 16bit little-endian:
+#   header:  "D2SP", number of volume blocks, 0
+#   records: first block, block count - followed by the data of the blocks
+#   end:     0, 0
+# Free blocks are zero in downloaded images. Uploads leave free blocks of the volume unchanged.
+#
+# Examples:
+#   ./dan2sparse.py get 192.168.1.65 SD1/VOL01 games.po     # download a volume
+#   ./dan2sparse.py put 192.168.1.65 games.po SD1/VOL01     # upload a volume
+#   ./dan2sparse.py pack games.po games.spr                 # convert local files
+#   ./dan2sparse.py unpack games.spr games.po
+
+import io
+import sys
+import struct
+import ftplib
+import argparse
+
+MAGIC = b"D2SP"
+
+def prodos_bitmap(image):
+	"""return the number of blocks and the list of allocated blocks of a ProDOS volume image"""
+	header = image[0x400:0x600]
+	if (len(header) < 0x2B) or (header[0x23:0x25] != b"\x27\x0D"):
+		raise ValueError("not a ProDOS volume")
+	bitmap, blocks = struct.unpack_from("<HH", header, 0x27)
+	blocks = min(blocks, len(image) // 512)
+	used = []
+	for blk in range(blocks):
+		byte = image[(bitmap << 9) + (blk >> 3)]
+		if not (byte & (0x80 >> (blk & 7))):
+			used.append(blk)
+	return blocks, used
+
+def pack(image):
+	"""convert a ProDOS volume image to a sparse volume file"""
+	blocks, used = prodos_bitmap(image)
+	out = bytearray(MAGIC + struct.pack("<HH", blocks, 0))
+	i = 0
+	while i < len(used):
+		j = i
+		while (j + 1 < len(used)) and (used[j + 1] == used[j] + 1):
+			j += 1
+		first, count = used[i], j - i + 1
+		out += struct.pack("<HH", first, count)
+		out += image[first * 512:(first + count) * 512]
+		i = j + 1
+	out += struct.pack("<HH", 0, 0)
+	return bytes(out)
+
+def unpack(sparse):
+	"""convert a sparse volume file to a ProDOS volume image"""
+	if sparse[0:4] != MAGIC:
+		raise ValueError("not a sparse volume file")
+	blocks = struct.unpack_from("<H", sparse, 4)[0]
+	image = bytearray(blocks * 512)
+	pos = 8
+	while True:
+		if pos + 4 > len(sparse):
+			raise ValueError("sparse volume file is incomplete")
+		first, count = struct.unpack_from("<HH", sparse, pos)
+		pos += 4
+		if count == 0:
+			break
+		data = sparse[pos:pos + count * 512]
+		if (len(data) != count * 512) or (first + count > blocks):
+			raise ValueError("bad record: block %d, count %d" % (first, count))
+		image[first * 512:(first + count) * 512] = data
+		pos += count * 512
+	return bytes(image)
+
+def ftp_path(volume):
+	"""split "SD1/VOL01" into directory and sparse file name"""
+	directory, _, name = volume.rpartition("/")
+	return "/" + (directory or "SD1"), name.split(".")[0] + ".SPR"
+
+def ftp_connect(args):
+	ftp = ftplib.FTP()
+	ftp.connect(args.host, args.port)
+	ftp.login()
+	return ftp
+
+def main():
+	parser = argparse.ArgumentParser(description="Convert ProDOS volumes from/to DAN][ sparse volume files.")
+	parser.add_argument("-p", "--port", type=int, default=21, help="FTP port (default: 21, dan2host: 2121)")
+	sub = parser.add_subparsers(dest="command", required=True)
+	p = sub.add_parser("pack", help="convert a ProDOS image to a sparse file")
+	p.add_argument("image")
+	p.add_argument("sparse")
+	p = sub.add_parser("unpack", help="convert a sparse file to a ProDOS image")
+	p.add_argument("sparse")
+	p.add_argument("image")
+	p = sub.add_parser("get", help="download a volume (i.e. SD1/VOL01) as ProDOS image")
+	p.add_argument("host")
+	p.add_argument("volume")
+	p.add_argument("image")
+	p = sub.add_parser("put", help="upload a ProDOS image to a volume (i.e. SD1/VOL01)")
+	p.add_argument("host")
+	p.add_argument("image")
+	p.add_argument("volume")
+	args = parser.parse_args()
+
+	try:
+		if args.command == "pack":
+			with open(args.image, "rb") as f:
+				sparse = pack(f.read())
+			with open(args.sparse, "wb") as f:
+				f.write(sparse)
+		elif args.command == "unpack":
+			with open(args.sparse, "rb") as f:
+				image = unpack(f.read())
+			with open(args.image, "wb") as f:
+				f.write(image)
+		elif args.command == "get":
+			directory, name = ftp_path(args.volume)
+			ftp = ftp_connect(args)
+			ftp.cwd(directory)
+			buf = io.BytesIO()
+			ftp.retrbinary("RETR " + name, buf.write)
+			ftp.quit()
+			sparse = buf.getvalue()
+			with open(args.image, "wb") as f:
+				f.write(unpack(sparse))
+			print("%s: %d bytes transferred" % (args.volume, len(sparse)))
+		elif args.command == "put":
+			with open(args.image, "rb") as f:
+				sparse = pack(f.read())
+			directory, name = ftp_path(args.volume)
+			ftp = ftp_connect(args)
+			ftp.cwd(directory)
+			ftp.storbinary("STOR " + name, io.BytesIO(sparse))
+			ftp.quit()
+			print("%s: %d bytes transferred" % (args.volume, len(sparse)))
+	except (ValueError, OSError, ftplib.Error) as e:
+		print("Error: %s" % e, file=sys.stderr)
+		return 1
+	return 0
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+# dan2trace.py - decode the DAN][ command trace (TRACE.BIN, downloaded from the FTP server).
+#
+#  Copyright (c) 2023 Thorsten C. Brehm
+#
+#  This software is provided 'as-is', without any express or implied
+#  warranty. In no event will the authors be held liable for any damages
+#  arising from the use of this software.
+#
+#  Permission is granted to anyone to use this software for any purpose,
+#  including commercial applications, and to alter it and redistribute it
+#  freely, subject to the following restrictions:
+#
+#  1. The origin of this software must not be misrepresented; you must not
+#     claim that you wrote the original software. If you use this software
+#     in a product, an acknowledgment in the product documentation would be
+#     appreciated but is not required.
+#  2. Altered source versions must be plainly marked as such, and must not be
+#     misrepresented as being the original software.
+#  3. This notice may not be removed or altered from any source distribution.
+#
+# Usage: dan2trace.py TRACE.BIN
+#
+# Prints one line per Apple II command, the oldest first:
+#   time(ms) duration(us) cmd unit blk count result name
+# Numbers are decimal, except cmd, unit and result (hex). The time is relative to the first entry.
+
+import sys
+import struct
+
+HEADER_SIZE = 16
+ENTRY_FORMAT = "<HHBBHBB"
+
+COMMANDS = {
+	0x00: "status",
+	0x01: "read",
+	0x02: "write",
+	0x03: "format",
+	0x04: "set_volume",
+	0x05: "get_volume",
+	0x06: "set_volume_tmp",
+	0x07: "set_volume_blk",
+	0x08: "set_volume_drv1",
+	0x09: "get_volume_tmp",
+	0x0A: "read_failsafe",
+	0x0B: "version",
+	0x0C: "read_multi",
+	0x0D: "write_multi",
+	0x0E: "flush",
+	0x0F: "set_write_back",
+	0x10: "eth_init",
+	0x11: "eth_poll",
+	0x12: "eth_send",
+	0x20: "set_ip",
+	0x21: "get_ip",
+	0x30: "volume_info",
+	0x8D: "read_bootblock",
+	0xA0: "read_bootblock",
+	0xA3: "read_a3_bootblock",
+	0xFF: "sync",
+}
+
+def readfile(name):
+	with open(name, "rb") as f:
+		return f.read()
+
+def decode(data):
+	if (len(data) < HEADER_SIZE) or (data[0:4] != b"DTRC"):
+		raise ValueError("not a DAN][ trace file")
+	version, entry_size, tick_us, _, entries, count, now = struct.unpack("<BBBBHHI", data[4:HEADER_SIZE])
+	if (version != 1) or (entry_size != struct.calcsize(ENTRY_FORMAT)):
+		raise ValueError("unsupported trace format version %d" % version)
+	if len(data) < HEADER_SIZE + entries*entry_size:
+		raise ValueError("trace file is truncated")
+
+	result = []
+	start = None
+	elapsed = 0
+	last = 0
+	for i in range(entries):
+		ofs = HEADER_SIZE + i*entry_size
+		time, duration, cmd, unit, blk, blkcount, status = struct.unpack(ENTRY_FORMAT, data[ofs:ofs+entry_size])
+		# 16bit millisecond time stamps: assume less than 65s between two commands
+		if start is None:
+			start = time
+		else:
+			elapsed += (time - last) & 0xffff
+		last = time
+		result.append((elapsed, duration*tick_us, cmd, unit, blk, blkcount, status))
+	return (count, now, result)
+
+def main(args):
+	if len(args) != 1:
+		print("Usage: dan2trace.py TRACE.BIN", file=sys.stderr)
+		return 1
+	try:
+		count, now, entries = decode(readfile(args[0]))
+	except (OSError, ValueError) as e:
+		print("Error: %s" % e, file=sys.stderr)
+		return 1
+
+	print("# %d commands traced since power-up, %d in this file, read at %d ms" % (count, len(entries), now))
+	print("# time(ms) duration(us) cmd unit blk count result name")
+	for (time, duration, cmd, unit, blk, blkcount, status) in entries:
+		print("%8d %8d %02X %02X %5d %3d %02X %s" % (time, duration, cmd, unit, blk, blkcount, status, COMMANDS.get(cmd, "unknown")))
+	return 0
+
+if __name__ == "__main__":
+	sys.exit(main(sys.argv[1:]))
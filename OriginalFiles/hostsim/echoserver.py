@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+# echoserver.py - TCP and UDP echo server, i.e. for "dan2host sockbench".
+#
+#  Copyright (c) 2023 Thorsten C. Brehm
+#
+#  This software is provided 'as-is', without any express or implied
+#  warranty. In no event will the authors be held liable for any damages
+#  arising from the use of this software.
+#
+#  Permission is granted to anyone to use this software for any purpose,
+#  including commercial applications, and to alter it and redistribute it
+#  freely, subject to the following restrictions:
+#
+#  1. The origin of this software must not be misrepresented; you must not
+#     claim that you wrote the original software. If you use this software
+#     in a product, an acknowledgment in the product documentation would be
+#     appreciated but is not required.
+#  2. Altered source versions must be plainly marked as such, and must not be
+#     misrepresented as being the original software.
+#  3. This notice may not be removed or altered from any source distribution.
+#
+#
+# Returns all TCP data and UDP datagrams to their sender. Usage:
+#   ./echoserver.py 7007 &
+#   bin-644p/dan2host sockbench 127.0.0.1 7007
+
+import sys
+import socket
+import threading
+import argparse
+
+def tcp_client(conn):
+	with conn:
+		while True:
+			data = conn.recv(4096)
+			if not data:
+				break
+			conn.sendall(data)
+
+def tcp_server(address, port):
+	srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+	srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+	srv.bind((address, port))
+	srv.listen(4)
+	while True:
+		conn, _ = srv.accept()
+		threading.Thread(target=tcp_client, args=(conn,), daemon=True).start()
+
+def udp_server(address, port):
+	srv = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+	srv.bind((address, port))
+	while True:
+		data, peer = srv.recvfrom(65536)
+		srv.sendto(data, peer)
+
+def main():
+	parser = argparse.ArgumentParser(description="TCP and UDP echo server")
+	parser.add_argument("port", type=int, help="TCP and UDP port")
+	parser.add_argument("-a", "--address", default="127.0.0.1", help="address to listen on (default: 127.0.0.1)")
+	args = parser.parse_args()
+	threading.Thread(target=udp_server, args=(args.address, args.port), daemon=True).start()
+	try:
+		tcp_server(args.address, args.port)
+	except KeyboardInterrupt:
+		pass
+	return 0
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,189 @@
+/* ethernet_host.cpp - Arduino Ethernet API on top of POSIX sockets, for the DAN][ host build.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <Ethernet.h>
+
+EthernetClass Ethernet;
+
+// Like the W5500, each connection has its own receive buffer, which is filled from the socket in
+// large chunks. Linux shrinks the TCP window while a partially read packet is queued, so reading
+// only a few bytes at a time directly from the socket could stall the sender.
+#define RX_BUFFER_SIZE 8192
+#define RX_BUFFERS     64
+
+typedef struct
+{
+  uint16_t pos, len;
+  uint8_t  data[RX_BUFFER_SIZE];
+} rx_buffer_t;
+
+static rx_buffer_t RxBuffer[RX_BUFFERS];
+
+static rx_buffer_t* rx_fill(int fd)
+{
+  if ((fd < 0)||(fd >= RX_BUFFERS))
+    return NULL;
+  rx_buffer_t* rx = &RxBuffer[fd];
+  if (rx->pos > 0)
+  {
+    memmove(rx->data, &rx->data[rx->pos], rx->len - rx->pos);
+    rx->len -= rx->pos;
+    rx->pos = 0;
+  }
+  ssize_t r = recv(fd, &rx->data[rx->len], RX_BUFFER_SIZE - rx->len, MSG_DONTWAIT);
+  if (r > 0)
+    rx->len += r;
+  return rx;
+}
+
+uint8_t EthernetClient::connected(void)
+{
+  if (fd < 0)
+    return 0;
+  // still connected - or remote closed, but unread data is pending
+  if (available())
+    return 1;
+  uint8_t c;
+  ssize_t r = recv(fd, &c, 1, MSG_PEEK|MSG_DONTWAIT);
+  if (r == 0)
+    return 0; // remote closed the connection
+  if ((r < 0)&&(errno != EAGAIN)&&(errno != EWOULDBLOCK))
+    return 0;
+  return 1;
+}
+
+int EthernetClient::available(void)
+{
+  rx_buffer_t* rx = rx_fill(fd);
+  return (rx) ? rx->len - rx->pos : 0;
+}
+
+int EthernetClient::read(void)
+{
+  uint8_t c;
+  return (read(&c, 1) == 1) ? c : -1;
+}
+
+int EthernetClient::read(uint8_t* buf, size_t size)
+{
+  rx_buffer_t* rx = rx_fill(fd);
+  if (!rx)
+    return -1;
+  if (rx->len == rx->pos)
+  {
+    // nothing buffered: report the state of the connection
+    ssize_t r = recv(fd, buf, size, MSG_DONTWAIT);
+    return (r < 0) ? -1 : (int) r;
+  }
+  if (size > (size_t) (rx->len - rx->pos))
+    size = rx->len - rx->pos;
+  memcpy(buf, &rx->data[rx->pos], size);
+  rx->pos += size;
+  return size;
+}
+
+size_t EthernetClient::write(const uint8_t* buf, size_t size)
+{
+  size_t sent = 0;
+  while ((fd >= 0)&&(sent < size))
+  {
+    ssize_t r = send(fd, &buf[sent], size-sent, MSG_NOSIGNAL);
+    if (r <= 0)
+      break;
+    sent += r;
+  }
+  return sent;
+}
+
+// a W5500 socket has 2KB of transmit buffer: report it free, once the socket is writable
+int EthernetClient::availableForWrite(void)
+{
+  struct pollfd p = {fd, POLLOUT, 0};
+  if ((fd < 0)||(poll(&p, 1, 0) != 1)||(!(p.revents & POLLOUT)))
+    return 0;
+  return 2048;
+}
+
+uint8_t EthernetClient::status(void)
+{
+  if (fd < 0)
+    return 0x00; // SnSR::CLOSED
+  // the remote closed its side of the connection (there may still be unread data)
+  struct pollfd p = {fd, POLLRDHUP, 0};
+  if ((poll(&p, 1, 0) == 1)&&(p.revents & (POLLRDHUP|POLLHUP)))
+    return 0x1C; // SnSR::CLOSE_WAIT
+  return 0x17; // SnSR::ESTABLISHED
+}
+
+void EthernetClient::stop(void)
+{
+  if (fd >= 0)
+    close(fd);
+  fd = -1;
+}
+
+void EthernetServer::begin(void)
+{
+  struct sockaddr_in addr;
+  IPAddress Ip = Ethernet.localIP();
+  uint16_t port = (Port < 1024) ? Port+ETHERNET_HOST_PORT_OFFSET : Port;
+  int on = 1;
+
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port   = htons(port);
+  memcpy(&addr.sin_addr.s_addr, &Ip[0], 4);
+  if ((bind(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0)||(listen(fd, 1) < 0))
+  {
+    fprintf(stderr, "Cannot listen on port %u: %s\n", port, strerror(errno));
+    close(fd);
+    fd = -1;
+    return;
+  }
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+}
+
+EthernetClient EthernetServer::accept(void)
+{
+  if (fd < 0)
+    return EthernetClient();
+  int client = ::accept(fd, NULL, NULL);
+  if ((client >= 0)&&(client < RX_BUFFERS))
+    RxBuffer[client].pos = RxBuffer[client].len = 0;
+  else
+  if (client >= 0)
+  {
+    close(client); // no receive buffer
+    client = -1;
+  }
+  return EthernetClient(client);
+}
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+# ethgen.py - send Ethernet frames to a tap interface, i.e. for "dan2host ethbench".
+#
+#  Copyright (c) 2023 Thorsten C. Brehm
+#
+#  This software is provided 'as-is', without any express or implied
+#  warranty. In no event will the authors be held liable for any damages
+#  arising from the use of this software.
+#
+#  Permission is granted to anyone to use this software for any purpose,
+#  including commercial applications, and to alter it and redistribute it
+#  freely, subject to the following restrictions:
+#
+#  1. The origin of this software must not be misrepresented; you must not
+#     claim that you wrote the original software. If you use this software
+#     in a product, an acknowledgment in the product documentation would be
+#     appreciated but is not required.
+#  2. Altered source versions must be plainly marked as such, and must not be
+#     misrepresented as being the original software.
+#  3. This notice may not be removed or altered from any source distribution.
+#
+#
+# Sends UDP broadcast frames through a raw socket (needs root or CAP_NET_RAW). Frames sent on a tap
+# interface are received by the program attached to it. Setup:
+#   sudo ip tuntap add dev dan0 mode tap user $USER
+#   sudo ip link set dan0 up
+#   sudo ./ethgen.py dan0 -s 64 &
+#   bin-644p/dan2host ethbench dan0
+# With --mix, only some of the frames are meant for dan2host (see "dan2host ethfilter").
+
+import sys
+import time
+import socket
+import struct
+import argparse
+
+BROADCAST = b"\xff" * 6
+SENDER_MAC = bytes([0x02, 0, 0, 0, 0x99, 0x01])
+SENDER_IP = bytes([192, 168, 99, 1])
+
+def udp_frame(size, seq, dst_mac=BROADCAST, dst_ip=bytes([255, 255, 255, 255]), port=9):
+	"""UDP frame (default: broadcast, port 9, discard) of the given size (without FCS)"""
+	payload = struct.pack(">I", seq) + bytes(max(0, size - 14 - 20 - 8 - 4))
+	udp = struct.pack(">HHHH", port, port, 8 + len(payload), 0) + payload
+	ip = struct.pack(">BBHHHBBH4s4s", 0x45, 0, 20 + len(udp), seq & 0xffff, 0, 64, 17, 0,
+			SENDER_IP, dst_ip)
+	checksum = sum(struct.unpack(">10H", ip))
+	checksum = (checksum & 0xffff) + (checksum >> 16)
+	ip = ip[:10] + struct.pack(">H", ~checksum & 0xffff) + ip[12:]
+	eth = dst_mac + SENDER_MAC + struct.pack(">H", 0x0800)
+	return eth + ip + udp
+
+def frame(size, seq):
+	return udp_frame(size, seq)
+
+def arp_request(target_ip):
+	"""ARP request (who has target_ip?), padded to the minimum frame size"""
+	arp = struct.pack(">HHBBH6s4s6s4s", 1, 0x0800, 6, 4, 1, SENDER_MAC, SENDER_IP, bytes(6), target_ip)
+	return BROADCAST + SENDER_MAC + struct.pack(">H", 0x0806) + arp + bytes(18)
+
+def mixed_frames(size, mac, ip):
+	"""Typical traffic of a busy LAN: for each frame for us (UDP to port 6502, ARP for our IP address)
+	   there are ARP requests for other hosts, IPv6 multicasts, mDNS, NetBIOS broadcasts and unicasts
+	   for other hosts, which a switch floods to all ports until it learns the address."""
+	other_ip = bytes(ip[:3]) + bytes([(ip[3] + 1) & 0xff])
+	return [
+		lambda seq: udp_frame(size, seq, mac, ip, 6502),
+		lambda seq: arp_request(other_ip),
+		lambda seq: bytes([0x33, 0x33, 0, 0, 0, 1]) + SENDER_MAC + struct.pack(">H", 0x86DD) + bytes(72),
+		lambda seq: udp_frame(120, seq, bytes([0x01, 0x00, 0x5e, 0x00, 0x00, 0xfb]), bytes([224, 0, 0, 251]), 5353),
+		lambda seq: udp_frame(size, seq, bytes([0x02, 0, 0, 0, 0x99, 0x02]), other_ip, 6502),
+		lambda seq: arp_request(ip),
+		lambda seq: udp_frame(92, seq, BROADCAST, bytes([255, 255, 255, 255]), 137),
+	]
+
+def main():
+	parser = argparse.ArgumentParser(description="Send Ethernet frames to a tap interface.")
+	parser.add_argument("interface", help="tap interface, i.e. dan0")
+	parser.add_argument("-s", "--size", type=int, default=64, help="frame size, 60-1514 (default: 64)")
+	parser.add_argument("-n", "--count", type=int, default=0, help="number of frames (default: 0, unlimited)")
+	parser.add_argument("-r", "--rate", type=float, default=0, help="frames per second (default: 0, as fast as possible)")
+	parser.add_argument("-m", "--mix", action="store_true", help="mix of frames for us and for others (see mixed_frames)")
+	parser.add_argument("--mac", default="00:08:dc:00:00:01", help="our MAC address for --mix (default: the one of dan2host)")
+	parser.add_argument("--ip", default="192.168.99.2", help="our IP address for --mix (default: the one of dan2host)")
+	args = parser.parse_args()
+	if not 60 <= args.size <= 1514:
+		parser.error("invalid frame size")
+	generators = [lambda seq: frame(args.size, seq)]
+	if args.mix:
+		generators = mixed_frames(args.size, bytes.fromhex(args.mac.replace(":", "")), socket.inet_aton(args.ip))
+
+	sock = socket.socket(socket.AF_PACKET, socket.SOCK_RAW)
+	sock.bind((args.interface, 0))
+	seq = 0
+	start = time.time()
+	try:
+		while (args.count == 0) or (seq < args.count):
+			try:
+				sock.send(generators[seq % len(generators)](seq))
+			except OSError:
+				# the tap queue is full (nobody reads it): try again later
+				time.sleep(0.001)
+				continue
+			seq += 1
+			if args.rate > 0:
+				delay = start + seq / args.rate - time.time()
+				if delay > 0:
+					time.sleep(delay)
+	except KeyboardInterrupt:
+		pass
+	print("%d frames sent in %.1f s" % (seq, time.time() - start), file=sys.stderr)
+	return 0
+
+if __name__ == "__main__":
+	sys.exit(main())
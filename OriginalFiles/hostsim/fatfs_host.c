@@ -0,0 +1,77 @@
+/*-----------------------------------------------------------------------*/
+/* FatFs statistics of the DAN][ host build                              */
+/*-----------------------------------------------------------------------*/
+/* Link-time wrappers (-Wl,--wrap=...) around the FatFs API used by the  */
+/* volume layer and around the disk I/O functions used by FatFs. The     */
+/* window buffers of all mounted file systems are remembered, so loading */
+/* a window can be told apart from other sector transfers.               */
+/*-----------------------------------------------------------------------*/
+
+#include "ff.h"
+#include "diskio_sdc.h"
+#include "fatfs_host.h"
+
+#define MAX_WINDOWS	4
+
+FATFS_HOST_STATS fatfs_host_stats;
+
+static const BYTE* Windows[MAX_WINDOWS];	/* window buffers of the mounted file systems */
+
+FRESULT __real_f_mount (FATFS* fs, const TCHAR* path, BYTE opt);
+FRESULT __real_f_open (FIL* fp, const TCHAR* path, BYTE mode);
+DRESULT __real_disk_read (BYTE pdrv, BYTE* buff, LBA_t sector, UINT count);
+DRESULT __real_disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count);
+
+
+static
+int is_window (const BYTE* buff)
+{
+	UINT i;
+
+	for (i = 0; i < MAX_WINDOWS; i++) {
+		if (Windows[i] == buff) return 1;
+	}
+	return 0;
+}
+
+
+FRESULT __wrap_f_mount (FATFS* fs, const TCHAR* path, BYTE opt)
+{
+	UINT i;
+
+	if (fs) {
+		fatfs_host_stats.mounts++;
+		for (i = 0; i < MAX_WINDOWS && Windows[i] && Windows[i] != fs->win; i++) ;
+		if (i < MAX_WINDOWS) Windows[i] = fs->win;
+	}
+	return __real_f_mount(fs, path, opt);
+}
+
+
+FRESULT __wrap_f_open (FIL* fp, const TCHAR* path, BYTE mode)
+{
+	fatfs_host_stats.file_opens++;
+	return __real_f_open(fp, path, mode);
+}
+
+
+DRESULT __wrap_disk_read (BYTE pdrv, BYTE* buff, LBA_t sector, UINT count)
+{
+	if (is_window(buff)) {
+		fatfs_host_stats.window_reads += count;
+	} else {
+		fatfs_host_stats.direct_reads += count;
+	}
+	return __real_disk_read(pdrv, buff, sector, count);
+}
+
+
+DRESULT __wrap_disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count)
+{
+	if (is_window(buff)) {
+		fatfs_host_stats.window_writes += count;
+	} else {
+		fatfs_host_stats.direct_writes += count;
+	}
+	return __real_disk_write(pdrv, buff, sector, count);
+}
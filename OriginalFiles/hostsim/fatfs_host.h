@@ -0,0 +1,31 @@
+/*-----------------------------------------------------------------------
+/  FatFs statistics of the DAN][ host build
+/-----------------------------------------------------------------------*/
+
+#ifndef _FATFS_HOST_DEFINED
+#define _FATFS_HOST_DEFINED
+
+#include "ff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* FatFs operations of the volume layer. The linker redirects f_mount, f_open,
+   disk_read and disk_write to counting wrappers (see -Wl,--wrap in the Makefile). */
+typedef struct {
+	DWORD	mounts;			/* f_mount: file system mounted */
+	DWORD	file_opens;		/* f_open: volume file (re)opened */
+	DWORD	window_reads;	/* sectors loaded into a FatFs window (FAT, directory or file data) */
+	DWORD	window_writes;	/* dirty FatFs windows written back */
+	DWORD	direct_reads;	/* sectors read into other buffers (direct LBA access, multi-sector f_read) */
+	DWORD	direct_writes;	/* sectors written from other buffers */
+} FATFS_HOST_STATS;
+
+extern FATFS_HOST_STATS fatfs_host_stats;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
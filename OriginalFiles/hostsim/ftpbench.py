@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+# ftpbench.py - measure the FTP throughput of a DAN][ card (or of "dan2host ftp").
+#
+#  Copyright (c) 2023 Thorsten C. Brehm
+#
+#  This software is provided 'as-is', without any express or implied
+#  warranty. In no event will the authors be held liable for any damages
+#  arising from the use of this software.
+#
+#  Permission is granted to anyone to use this software for any purpose,
+#  including commercial applications, and to alter it and redistribute it
+#  freely, subject to the following restrictions:
+#
+#  1. The origin of this software must not be misrepresented; you must not
+#     claim that you wrote the original software. If you use this software
+#     in a product, an acknowledgment in the product documentation would be
+#     appreciated but is not required.
+#  2. Altered source versions must be plainly marked as such, and must not be
+#     misrepresented as being the original software.
+#  3. This notice may not be removed or altered from any source distribution.
+#
+# Downloads (and optionally uploads) a volume file several times and reports the throughput.
+# Uploads overwrite the volume with random data, so only use --stor with a scratch volume!
+
+import os
+import io
+import sys
+import time
+import ftplib
+import argparse
+
+def timed(func):
+	t = time.time()
+	func()
+	return time.time() - t
+
+def report(name, size, seconds):
+	print("%-5s %8d bytes  %7.3f s  %8.1f KB/s" % (name, size, seconds, size / 1024.0 / max(seconds, 1e-6)))
+
+def main():
+	parser = argparse.ArgumentParser(description="Measure the FTP throughput of a DAN][ card.")
+	parser.add_argument("host", nargs="?", default="127.0.0.1", help="IP address (default: 127.0.0.1)")
+	parser.add_argument("-p", "--port", type=int, default=21, help="FTP port (default: 21, dan2host: 2121)")
+	parser.add_argument("-d", "--dir", default="SD1", help="directory: SD1 or SD2 (default: SD1)")
+	parser.add_argument("-f", "--file", default="VOL01.PO", help="volume file (default: VOL01.PO)")
+	parser.add_argument("-n", "--count", type=int, default=3, help="number of runs (default: 3)")
+	parser.add_argument("--stor", action="store_true", help="also upload random data to the volume file")
+	args = parser.parse_args()
+
+	ftp = ftplib.FTP()
+	ftp.connect(args.host, args.port)
+	ftp.login()
+	ftp.cwd("/" + args.dir)
+
+	best = {}
+	size = 0
+	for run in range(args.count):
+		lines = []
+		seconds = timed(lambda: ftp.retrlines("LIST", lines.append))
+		report("LIST", sum(len(line) + 2 for line in lines), seconds)
+
+		buf = io.BytesIO()
+		seconds = timed(lambda: ftp.retrbinary("RETR " + args.file, buf.write))
+		size = len(buf.getvalue())
+		report("RETR", size, seconds)
+		best["RETR"] = min(best.get("RETR", seconds), seconds)
+
+		if args.stor:
+			# the server has no SIZE command: upload as much as was just downloaded
+			data = os.urandom(size)
+			seconds = timed(lambda: ftp.storbinary("STOR " + args.file, io.BytesIO(data)))
+			report("STOR", size, seconds)
+			best["STOR"] = min(best.get("STOR", seconds), seconds)
+			buf = io.BytesIO()
+			ftp.retrbinary("RETR " + args.file, buf.write)
+			if buf.getvalue() != data:
+				print("RETR data does not match STOR data!")
+				return 1
+
+	ftp.quit()
+	for name in sorted(best):
+		report("best " + name, size, best[name])
+	return 0
+
+if __name__ == "__main__":
+	sys.exit(main())
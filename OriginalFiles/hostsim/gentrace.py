@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+# gentrace.py - generate synthetic DAN][ command traces of typical ProDOS workloads.
+#
+#  Copyright (c) 2023 Thorsten C. Brehm
+#
+#  This software is provided 'as-is', without any express or implied
+#  warranty. In no event will the authors be held liable for any damages
+#  arising from the use of this software.
+#
+#  Permission is granted to anyone to use this software for any purpose,
+#  including commercial applications, and to alter it and redistribute it
+#  freely, subject to the following restrictions:
+#
+#  1. The origin of this software must not be misrepresented; you must not
+#     claim that you wrote the original software. If you use this software
+#     in a product, an acknowledgment in the product documentation would be
+#     appreciated but is not required.
+#  2. Altered source versions must be plainly marked as such, and must not be
+#     misrepresented as being the original software.
+#  3. This notice may not be removed or altered from any source distribution.
+#
+# The trace has the text format of dan2trace.py and can be replayed with "dan2host replay".
+#
+# Workloads:
+#   boot        boot blocks, volume directory, PRODOS and BASIC.SYSTEM loaded, STARTUP program
+#   catalog     repeated CATALOGs: volume directory and a subdirectory
+#   sequential  a large file loaded block by block (or with read_multi, see --multi)
+#   randwrite   random file blocks written, with ProDOS index, bitmap and directory updates
+#   mixed       all of the above
+
+import sys
+import random
+import argparse
+
+CMD_STATUS      = 0x00
+CMD_READ        = 0x01
+CMD_WRITE       = 0x02
+CMD_READ_MULTI  = 0x0C
+CMD_FLUSH       = 0x0E
+
+NAMES = {CMD_STATUS: "status", CMD_READ: "read", CMD_WRITE: "write", CMD_READ_MULTI: "read_multi", CMD_FLUSH: "flush"}
+
+# ProDOS volume layout (see dan2host mkfat): directory in blocks 2-5, bitmap from block 6
+VOLUME_DIR = [2, 3, 4, 5]
+BITMAP     = 6
+
+class Trace:
+	def __init__(self, unit, blocks):
+		self.unit = unit
+		self.blocks = blocks
+		self.time = 0
+		self.lines = []
+		# files are allocated after the bitmap, like on a freshly formatted volume
+		self.next_free = BITMAP + (blocks+4095)//4096
+
+	def cmd(self, cmd, blk=0, count=0, delay=1):
+		self.lines.append("%8d %8d %02X %02X %5d %3d %02X %s" % (self.time, 0, cmd, self.unit, blk, count, 0, NAMES[cmd]))
+		self.time += delay
+
+	def read(self, blk, delay=1):
+		self.cmd(CMD_READ, blk, delay=delay)
+
+	def write(self, blk, delay=1):
+		self.cmd(CMD_WRITE, blk, delay=delay)
+
+	def allocate(self, count):
+		# contiguous blocks of a new file (wraps in small volumes)
+		if self.next_free + count > self.blocks:
+			self.next_free = BITMAP + (self.blocks+4095)//4096
+		first = self.next_free
+		self.next_free += count
+		return list(range(first, first+count))
+
+	def load_file(self, size_blocks, multi=1):
+		# sapling file: index block, then the data blocks
+		blocks = self.allocate(size_blocks+1)
+		self.read(blocks[0])
+		data = blocks[1:]
+		if multi > 1:
+			for i in range(0, len(data), multi):
+				n = min(multi, len(data)-i)
+				self.cmd(CMD_READ_MULTI, data[i], n, delay=n)
+		else:
+			for blk in data:
+				self.read(blk)
+		return blocks
+
+def boot(t, args):
+	t.cmd(CMD_STATUS)
+	t.read(0)                   # boot loader (blocks 0+1)
+	t.read(1)
+	for blk in VOLUME_DIR:      # loader searches PRODOS
+		t.read(blk)
+	t.load_file(30)             # PRODOS
+	t.read(VOLUME_DIR[0], 20)   # ProDOS searches the first .SYSTEM file
+	t.load_file(21)             # BASIC.SYSTEM
+	t.read(VOLUME_DIR[0], 20)   # STARTUP
+	t.load_file(4)
+
+def catalog(t, args):
+	subdir = t.allocate(2)
+	for i in range(args.count):
+		t.cmd(CMD_STATUS)
+		for blk in VOLUME_DIR:
+			t.read(blk)
+		for blk in subdir:
+			t.read(blk)
+		t.read(BITMAP, delay=200) # free blocks, then the user looks at the listing
+
+def sequential(t, args):
+	for i in range(max(1, args.count // 128)):
+		t.read(VOLUME_DIR[0])
+		t.load_file(128, args.multi)
+		t.time += 100
+
+def randwrite(t, args):
+	rnd = random.Random(args.seed)
+	data = t.allocate(min(256, t.blocks//2))
+	index = data.pop(0)
+	t.read(VOLUME_DIR[0])
+	t.read(index)
+	for i in range(args.count):
+		t.write(rnd.choice(data))
+		if (i % 8) == 7:
+			# ProDOS flushes the file: index block, bitmap and directory entry
+			t.write(index)
+			t.read(BITMAP)
+			t.write(BITMAP)
+			t.write(VOLUME_DIR[0])
+	t.cmd(CMD_FLUSH)
+
+WORKLOADS = {"boot": [boot], "catalog": [catalog], "sequential": [sequential], "randwrite": [randwrite],
+             "mixed": [boot, catalog, sequential, randwrite]}
+
+def main():
+	parser = argparse.ArgumentParser(description="Generate a synthetic DAN][ command trace.")
+	parser.add_argument("workload", choices=sorted(WORKLOADS.keys()))
+	parser.add_argument("-u", "--unit", default="70", help="ProDOS unit (hex, default: 70)")
+	parser.add_argument("-b", "--blocks", type=int, default=65535, help="volume size in blocks (default: 65535)")
+	parser.add_argument("-n", "--count", type=int, default=256, help="blocks/commands per workload (default: 256)")
+	parser.add_argument("-m", "--multi", type=int, default=1, help="sequential: blocks per read_multi command (default: 1)")
+	parser.add_argument("-s", "--seed", type=int, default=1, help="random seed (default: 1)")
+	args = parser.parse_args()
+	if not (1 <= args.multi <= 255):
+		parser.error("--multi must be 1..255")
+
+	t = Trace(int(args.unit, 16), args.blocks)
+	for workload in WORKLOADS[args.workload]:
+		workload(t, args)
+
+	print("# synthetic trace: %s, unit %02X, %d commands" % (args.workload, t.unit, len(t.lines)))
+	print("# time(ms) duration(us) cmd unit blk count result name")
+	print("\n".join(t.lines))
+	return 0
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,323 @@
+/*-----------------------------------------------------------------------*/
+/* MMCv3/SDv1/SDv2 Controls emulated with image files (DAN][ host build) */
+/*-----------------------------------------------------------------------*/
+/* Drop-in replacement for mmc_avr_spi.c: each SD slot is mapped to a    */
+/* raw image file. The transfer functions keep the command sequence of   */
+/* the SPI driver (CMD17/18/24/25/12), so the number of card operations  */
+/* can be counted exactly.                                               */
+/*-----------------------------------------------------------------------*/
+
+#define _FILE_OFFSET_BITS 64
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "diskio_sdc.h"
+#include "mmc_host.h"
+
+#define CMD12	(12)		/* STOP_TRANSMISSION */
+#define CMD17	(17)		/* READ_SINGLE_BLOCK */
+#define CMD18	(18)		/* READ_MULTIPLE_BLOCK */
+#define CMD24	(24)		/* WRITE_BLOCK */
+#define CMD25	(25)		/* WRITE_MULTIPLE_BLOCK */
+
+static DSTATUS Stat[2] = { STA_NOINIT, STA_NOINIT };	/* Disk status */
+static int ImageFd[2] = { -1, -1 };		/* Image file of each slot */
+static DWORD ImageSectors[2];			/* Image size in sectors */
+
+BYTE slotno = 0;
+BYTE mmc_busy = 0; /* flag indicating when a MMC card is still busy with a write/program operation */
+
+MMC_HOST_STATS mmc_host_stats;
+BYTE mmc_host_dataport[512];
+BYTE mmc_host_abort;
+
+static BYTE read_cmd;	/* command of the current read transfer (CMD17/CMD18) */
+static BYTE write_cmd;	/* command of the current write transfer (CMD24/CMD25) */
+static DWORD xfer_sect;	/* next sector of the current transfer */
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Attach/Detach Image Files                                             */
+/*-----------------------------------------------------------------------*/
+
+int mmc_host_open (
+	BYTE pdrv,			/* SD slot 0 or 1 */
+	const char* path	/* Image file */
+)
+{
+	struct stat st;
+	int fd;
+
+	if (pdrv > 1) return 0;
+	fd = open(path, O_RDWR);
+	if (fd < 0) return 0;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return 0;
+	}
+	if (ImageFd[pdrv] >= 0) close(ImageFd[pdrv]);
+	ImageFd[pdrv] = fd;
+	ImageSectors[pdrv] = (DWORD)(st.st_size / 512);
+	Stat[pdrv] = STA_NOINIT;
+	return 1;
+}
+
+void mmc_host_close (void)
+{
+	BYTE pdrv;
+
+	for (pdrv = 0; pdrv < 2; pdrv++) {
+		if (ImageFd[pdrv] >= 0) close(ImageFd[pdrv]);
+		ImageFd[pdrv] = -1;
+		Stat[pdrv] = STA_NOINIT;
+	}
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Sector Access                                                         */
+/*-----------------------------------------------------------------------*/
+
+static
+int image_read (BYTE *buff)
+{
+	if (xfer_sect >= ImageSectors[slotno]) return 0;
+	if (pread(ImageFd[slotno], buff, 512, (off_t)xfer_sect * 512) != 512) return 0;
+	xfer_sect++;
+	mmc_host_stats.sectors_read++;
+	return 1;
+}
+
+static
+int image_write (const BYTE *buff)
+{
+	if (xfer_sect >= ImageSectors[slotno]) return 0;
+	if (pwrite(ImageFd[slotno], buff, 512, (off_t)xfer_sect * 512) != 512) return 0;
+	xfer_sect++;
+	mmc_host_stats.sectors_written++;
+	mmc_busy = 1;		/* the card is programming the sector now */
+	return 1;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Wait while a MMC card is still busy (and blocking the SPI bus)        */
+/*-----------------------------------------------------------------------*/
+
+void mmc_wait_busy_spi(void)
+{
+	if (mmc_busy) mmc_host_stats.busy_waits++;
+	mmc_busy = 0;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Initialize Disk Drive                                                 */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS mmc_disk_initialize (void)
+{
+	Stat[slotno] = (ImageFd[slotno] >= 0) ? 0 : (STA_NOINIT | STA_NODISK);
+	return Stat[slotno];
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Get Disk Status                                                       */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS mmc_disk_status (void)
+{
+	return Stat[slotno];
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT mmc_disk_read_start (
+	LBA_t sector,		/* Start sector number (LBA) */
+	UINT count			/* Sector count */
+)
+{
+	if (!count) return RES_PARERR;
+	if (Stat[slotno] & STA_NOINIT) return RES_NOTRDY;
+
+	read_cmd = count > 1 ? CMD18 : CMD17;
+	if (read_cmd == CMD18) mmc_host_stats.cmd_read_multi++; else mmc_host_stats.cmd_read++;
+	if (sector >= ImageSectors[slotno]) return RES_ERROR;	/* Address error */
+	xfer_sect = sector;
+	return RES_OK;
+}
+
+DRESULT mmc_disk_read_next (
+	BYTE *buff			/* Pointer to the 512 byte data buffer or NULL */
+)
+{
+	if (!buff) {	/* Stream to the Apple II */
+		if (!image_read(mmc_host_dataport)) return RES_ERROR;
+		mmc_host_stats.sectors_streamed++;
+		return RES_OK;
+	}
+	return image_read(buff) ? RES_OK : RES_ERROR;
+}
+
+DRESULT mmc_disk_read_idle (
+	BYTE *buff			/* Pointer to the 512 byte data buffer */
+)
+{
+	if (mmc_host_abort) {
+		mmc_host_stats.read_aborts++;
+		return RES_ABORTED;
+	}
+	return image_read(buff) ? RES_OK : RES_ERROR;
+}
+
+void mmc_disk_read_pause (void)
+{
+}
+
+void mmc_disk_read_resume (void)
+{
+}
+
+void mmc_disk_read_stop (void)
+{
+	if (read_cmd == CMD18) mmc_host_stats.cmd_stop++;
+	read_cmd = 0;
+}
+
+DRESULT mmc_disk_read (
+	BYTE *buff,			/* Pointer to the data buffer to store read data */
+	LBA_t sector,		/* Start sector number (LBA) */
+	UINT count			/* Sector count (1..128) */
+)
+{
+	DRESULT res = mmc_disk_read_start(sector, count);
+
+	if (res != RES_OK) return res;
+	do {
+		if (mmc_disk_read_next(buff) != RES_OK) break;
+		buff += 512;
+	} while (--count);
+	mmc_disk_read_stop();
+
+	return count ? RES_ERROR : RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT mmc_disk_write_start (
+	LBA_t sector,		/* Start sector number (LBA) */
+	UINT count,			/* Sector count */
+	BYTE preerase		/* Pre-erase the sectors (not modelled) */
+)
+{
+	if (!count) return RES_PARERR;
+	if (Stat[slotno] & STA_NOINIT) return RES_NOTRDY;
+	if (Stat[slotno] & STA_PROTECT) return RES_WRPRT;
+
+	write_cmd = count > 1 ? CMD25 : CMD24;
+	if (write_cmd == CMD25) mmc_host_stats.cmd_write_multi++; else mmc_host_stats.cmd_write++;
+	if (sector >= ImageSectors[slotno]) {	/* Address error */
+		write_cmd = 0;						/* No transfer in progress */
+		return RES_ERROR;
+	}
+	xfer_sect = sector;
+	return RES_OK;
+}
+
+DRESULT mmc_disk_write_next (
+	const BYTE *buff	/* Pointer to the 512 byte data block or NULL */
+)
+{
+	if (!buff) {	/* Stream from the Apple II (discarded without a write transfer) */
+		if (!write_cmd) return RES_ERROR;
+		if (!image_write(mmc_host_dataport)) return RES_ERROR;
+		mmc_host_stats.sectors_streamed++;
+		return RES_OK;
+	}
+	return image_write(buff) ? RES_OK : RES_ERROR;
+}
+
+void mmc_disk_write_pause (void)
+{
+}
+
+void mmc_disk_write_resume (void)
+{
+}
+
+DRESULT mmc_disk_write_stop (void)
+{
+	if (write_cmd == CMD25)
+	{
+		mmc_host_stats.cmd_stop++;
+		mmc_busy = 1;	/* the card programs the last block(s) after the STOP_TRAN token */
+	}
+	write_cmd = 0;									/* No transfer in progress */
+	return RES_OK;
+}
+
+DRESULT mmc_disk_write (
+	const BYTE *buff,	/* Pointer to the data to be written */
+	LBA_t sector,		/* Start sector number (LBA) */
+	UINT count			/* Sector count (1..128) */
+)
+{
+	DRESULT res = mmc_disk_write_start(sector, count, 1);
+
+	if (res != RES_OK) return res;
+	do {
+		if (mmc_disk_write_next(buff) != RES_OK) break;
+		buff += 512;
+	} while (--count);
+	if (mmc_disk_write_stop() != RES_OK) count = 1;
+
+	return count ? RES_ERROR : RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+DRESULT mmc_disk_ioctl (
+	BYTE cmd,		/* Control code */
+	void *buff		/* Buffer to send/receive control data */
+)
+{
+	if (Stat[slotno] & STA_NOINIT) return RES_NOTRDY;
+
+	switch (cmd) {
+	case CTRL_SYNC :		/* Make sure that no pending write process */
+		mmc_wait_busy_spi();
+		return RES_OK;
+
+	case GET_SECTOR_COUNT :	/* Get number of sectors on the disk (DWORD) */
+		*(LBA_t*)buff = ImageSectors[slotno];
+		return RES_OK;
+
+	case GET_BLOCK_SIZE :	/* Get erase block size in unit of sector (DWORD) */
+		*(DWORD*)buff = 128;
+		return RES_OK;
+
+	case MMC_GET_TYPE :		/* Get card type flags (1 byte) */
+		*(BYTE*)buff = CT_SDC2 | CT_BLOCK;
+		return RES_OK;
+	}
+	return RES_PARERR;
+}
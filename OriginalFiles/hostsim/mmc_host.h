@@ -0,0 +1,43 @@
+/*-----------------------------------------------------------------------
+/  File-backed MMC module for the DAN][ host build
+/-----------------------------------------------------------------------*/
+
+#ifndef _MMC_HOST_DEFINED
+#define _MMC_HOST_DEFINED
+
+#include "mmc_avr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* SD card operations, counted like they would be sent to a real card */
+typedef struct {
+	DWORD	cmd_read;		/* CMD17: single block reads */
+	DWORD	cmd_read_multi;	/* CMD18: multiple block reads */
+	DWORD	cmd_write;		/* CMD24: single block writes */
+	DWORD	cmd_write_multi;	/* CMD25: multiple block writes */
+	DWORD	cmd_stop;		/* CMD12/StopTran: multiple block transfers stopped */
+	DWORD	sectors_read;	/* sectors received from the card */
+	DWORD	sectors_written;	/* sectors sent to the card */
+	DWORD	sectors_streamed;	/* sectors streamed from/to the Apple II (not buffered) */
+	DWORD	read_aborts;	/* speculative reads aborted by an Apple II command */
+	DWORD	busy_waits;		/* waits for a card busy programming a written sector */
+} MMC_HOST_STATS;
+
+extern MMC_HOST_STATS mmc_host_stats;
+
+/* The Apple II side of streamed transfers (mmc_disk_read_next/write_next with NULL buffer) */
+extern BYTE mmc_host_dataport[512];
+
+/* Simulates a pending Apple II command: mmc_disk_read_idle aborts while this is set */
+extern BYTE mmc_host_abort;
+
+int  mmc_host_open (BYTE pdrv, const char* path);	/* Attach an image file to an SD slot (0/1) */
+void mmc_host_close (void);						/* Detach all image files */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
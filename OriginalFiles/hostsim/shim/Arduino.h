@@ -0,0 +1,80 @@
+/* Arduino.h - minimal Arduino environment for the DAN][ host build.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HEX 16
+#define DEC 10
+
+#define F(str) (str)
+
+#define LOW    0
+#define HIGH   1
+#define INPUT  0
+#define OUTPUT 1
+
+// default SPI chip select pin
+#define SS     10
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // milliseconds since the start of the program (wraps like on the AVR)
+  unsigned long millis(void);
+  unsigned long micros(void);
+  void          delay(unsigned long ms);
+
+  // the only pin used by the host build is the W5500 chip select (see w5500_host.cpp)
+  void          pinMode(uint8_t pin, uint8_t mode);
+  void          digitalWrite(uint8_t pin, uint8_t value);
+
+#ifdef __cplusplus
+}
+
+#include <avr/io.h>
+
+// serial debug output goes to stderr
+class HardwareSerial
+{
+public:
+  void   begin(unsigned long) {}
+  void   flush(void) {}
+  size_t write(const uint8_t* buf, size_t size);
+  size_t write(const char* buf, size_t size) { return write((const uint8_t*) buf, size); }
+  size_t print(const char* str);
+  size_t print(long value, int base=DEC);
+  size_t println(const char* str);
+  size_t println(long value, int base=DEC);
+};
+
+extern HardwareSerial Serial;
+#endif
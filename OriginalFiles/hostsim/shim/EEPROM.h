@@ -0,0 +1,42 @@
+/* EEPROM.h - EEPROM emulation for the DAN][ host build.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+
+#include <stdint.h>
+
+#define EEPROM_HOST_SIZE 1024
+
+// EEPROM contents only live in RAM. Erased cells read as 0xFF, just like a new AVR.
+class EEPROMClass
+{
+public:
+  EEPROMClass() { for (uint16_t i=0;i<EEPROM_HOST_SIZE;i++) data[i] = 0xff; }
+  uint8_t  read(int idx) { return data[idx % EEPROM_HOST_SIZE]; }
+  void     write(int idx, uint8_t val) { data[idx % EEPROM_HOST_SIZE] = val; writes++; }
+  void     update(int idx, uint8_t val) { if (read(idx) != val) write(idx, val); }
+  uint16_t length(void) { return EEPROM_HOST_SIZE; }
+
+  uint32_t writes; // statistics: number of write (erase/program) cycles
+private:
+  uint8_t  data[EEPROM_HOST_SIZE];
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,90 @@
+/* Ethernet.h - Arduino Ethernet API on top of POSIX sockets, for the DAN][ host build.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+
+#include <Arduino.h>
+
+// Privileged ports (<1024) are moved by this offset, so no root permissions are needed (FTP: 2121).
+#define ETHERNET_HOST_PORT_OFFSET 2100
+
+enum EthernetLinkStatus {Unknown, LinkON, LinkOFF};
+enum EthernetHardwareStatus {EthernetNoHardware, EthernetW5100, EthernetW5200, EthernetW5500};
+
+class IPAddress
+{
+public:
+  IPAddress() { bytes[0] = bytes[1] = bytes[2] = bytes[3] = 0; }
+  IPAddress(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3) { bytes[0]=b0;bytes[1]=b1;bytes[2]=b2;bytes[3]=b3; }
+  uint8_t  operator[](int idx) const { return bytes[idx]; }
+  uint8_t& operator[](int idx) { return bytes[idx]; }
+private:
+  uint8_t bytes[4];
+};
+
+class EthernetClass
+{
+public:
+  void init(uint8_t sspin) { (void) sspin; }
+  void begin(uint8_t* mac, IPAddress ip) { (void) mac; Ip = ip; }
+  EthernetHardwareStatus hardwareStatus(void) { return EthernetW5500; }
+  EthernetLinkStatus     linkStatus(void) { return LinkON; }
+  IPAddress              localIP(void) { return Ip; }
+private:
+  IPAddress Ip;
+};
+
+// A client only wraps the socket descriptor. Like on the Arduino, copies refer to the same
+// connection, which is only closed by stop().
+class EthernetClient
+{
+public:
+  EthernetClient() : fd(-1) {}
+  explicit EthernetClient(int sockfd) : fd(sockfd) {}
+
+  uint8_t connected(void);
+  int     available(void);
+  int     read(void);
+  int     read(uint8_t* buf, size_t size);
+  size_t  write(const uint8_t* buf, size_t size);
+  size_t  write(const char* buf, size_t size) { return write((const uint8_t*) buf, size); }
+  // the socket write does not wait for the data to be acknowledged, so nothing is pending
+  size_t  writeQueued(const uint8_t* buf, size_t size) { return write(buf, size); }
+  bool    sendPending(void) { return false; }
+  void    stop(void);
+  int     availableForWrite(void);
+  uint8_t status(void); // SnSR::CLOSED, SnSR::ESTABLISHED or SnSR::CLOSE_WAIT
+  void    setConnectionTimeout(uint16_t timeout) { (void) timeout; }
+private:
+  int fd;
+};
+
+class EthernetServer
+{
+public:
+  EthernetServer(uint16_t port, bool large_buffers=false) : Port(port), fd(-1) { (void) large_buffers; }
+  void           begin(void);
+  EthernetClient accept(void);
+private:
+  uint16_t Port;
+  int      fd;
+};
+
+extern EthernetClass Ethernet;
@@ -0,0 +1,37 @@
+/* avr/io.h - ATmega I/O registers for the DAN][ host build.
+
+  Only the registers used by w5500.cpp and pindefs.h. Register accesses call the models of the
+  82C55 (PORTC, PINC, PORTD, PIND) and of the W5500 (SPDR) in w5500_host.cpp.
+*/
+#pragma once
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+// SPCR, SPSR
+#define SPE   6
+#define MSTR  4
+#define SPIF  7
+#define SPI2X 0
+
+#define loop_until_bit_is_set(sfr, bit) do { } while (!((sfr) & _BV(bit)))
+
+#define cli()
+#define sei()
+
+#ifdef __cplusplus
+struct avr_register
+{
+  uint8_t value;
+  void    (*write)(uint8_t value); // NULL: plain register
+  uint8_t (*read)(void);           // NULL: returns the written value
+
+  operator uint8_t() { return (read) ? read() : value; }
+  avr_register& operator=(uint8_t v) { value = v; if (write) write(v); return *this; }
+  avr_register& operator|=(uint8_t v) { return *this = (value | v); }
+  avr_register& operator&=(uint8_t v) { return *this = (value & v); }
+};
+
+extern avr_register PORTB, DDRB, PORTC, PINC, DDRC, PORTD, PIND, DDRD, SPCR, SPSR, SPDR;
+#endif
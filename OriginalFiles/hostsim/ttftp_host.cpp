@@ -0,0 +1,34 @@
+/* ttftp_host.cpp - TinyTinyFTP server of the firmware, compiled for the DAN][ host build.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// The Arduino IDE compiles ttftp.ino as part of Apple2Arduino.ino, which provides these headers.
+#include <Arduino.h>
+#include "pindefs.h"
+#include "mmc_avr.h"
+#include "config.h"
+#include "dan2volumes.h"
+#include "mmc_host.h"
+
+// a pending Apple II command (82C55 OBF flag low) is simulated by mmc_host_abort
+#undef  READ_OBFA
+#define READ_OBFA() (mmc_host_abort ? 0 : 1)
+
+#include "ttftp.ino"
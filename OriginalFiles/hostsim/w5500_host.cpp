@@ -0,0 +1,617 @@
+/* w5500_host.cpp - W5500 and 82C55 models for the DAN][ host build.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// w5500.cpp is compiled unmodified: it accesses the W5500 through the SPI data register and streams
+// data through the 82C55 port registers (see shim/avr/io.h). The W5500 is modelled at register level:
+// common registers, socket registers and buffers of 8 sockets. Socket 0 in MACRAW mode exchanges
+// frames with a Linux tap interface. TCP and UDP sockets are mapped to sockets of the host.
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+#include <Arduino.h>
+#include "pindefs.h"
+#include "w5500_host.h"
+
+W5500_HOST_STATS w5500_host_stats;
+
+/* 82C55 ***************************************************************************************************/
+
+static uint8_t  PioOut[65536];
+static uint32_t PioOutLen;
+static uint8_t  PioIn[65536];
+static uint32_t PioInPos, PioInLen;
+static uint8_t  PortC = 0xff;
+static uint32_t PioWaits;
+
+static void portc_write(uint8_t value)
+{
+  PioWaits = 0;
+  // STB rising edge: the Apple II received the byte on port D
+  if ((!(PortC & _BV(STBA)))&&(value & _BV(STBA))&&(PioOutLen < sizeof(PioOut)))
+  {
+    PioOut[PioOutLen++] = PORTD.value;
+    w5500_host_stats.pio_out++;
+  }
+  // ACK rising edge: the firmware has read the byte from the Apple II
+  if ((!(PortC & _BV(ACKA)))&&(value & _BV(ACKA))&&(PioInPos < PioInLen))
+  {
+    PioInPos++;
+    w5500_host_stats.pio_in++;
+  }
+  PortC = value;
+}
+
+static uint8_t pinc_read(void)
+{
+  // IBF is always low: the Apple II reads each byte immediately. OBF is low while bytes are queued.
+  if (PioInPos < PioInLen)
+    return 0;
+  // the firmware polls OBF without any handshake in between
+  if (++PioWaits > 1000000)
+  {
+    fprintf(stderr, "82C55: firmware waits for data from the Apple II\n");
+    exit(1);
+  }
+  return _BV(OBFA);
+}
+
+static uint8_t pind_read(void)
+{
+  return (PioInPos < PioInLen) ? PioIn[PioInPos] : 0xff;
+}
+
+void w5500_host_pio_write(const uint8_t* data, uint16_t len)
+{
+  if (PioInPos > 0)
+  {
+    memmove(PioIn, &PioIn[PioInPos], PioInLen - PioInPos);
+    PioInLen -= PioInPos;
+    PioInPos = 0;
+  }
+  if (PioInLen + len > sizeof(PioIn))
+    len = sizeof(PioIn) - PioInLen;
+  memcpy(&PioIn[PioInLen], data, len);
+  PioInLen += len;
+}
+
+void w5500_host_pio_discard(void)
+{
+  PioInPos = PioInLen = 0;
+}
+
+uint16_t w5500_host_pio_read(uint8_t* buf, uint16_t size)
+{
+  uint16_t len = (PioOutLen < size) ? PioOutLen : size;
+  memcpy(buf, PioOut, len);
+  memmove(PioOut, &PioOut[len], PioOutLen - len);
+  PioOutLen -= len;
+  return len;
+}
+
+/* W5500 ***************************************************************************************************/
+
+#define SOCKETS     8
+#define BUFFER_SIZE 16384
+
+// register addresses, see w5500.h
+#define MR          0x00
+#define PHYCFGR     0x2E
+#define VERSIONR    0x39
+#define Sn_MR       0x00
+#define Sn_CR       0x01
+#define Sn_IR       0x02
+#define Sn_SR       0x03
+#define Sn_PORT     0x04
+#define Sn_DIPR     0x0C
+#define Sn_DPORT    0x10
+#define Sn_TTL      0x16
+#define Sn_RXBUF_SIZE 0x1E
+#define Sn_TXBUF_SIZE 0x1F
+#define Sn_TX_FSR   0x20
+#define Sn_TX_RD    0x22
+#define Sn_TX_WR    0x24
+#define Sn_RX_RSR   0x26
+#define Sn_RX_RD    0x28
+#define Sn_RX_WR    0x2A
+
+// socket states
+#define SOCK_CLOSED      0x00
+#define SOCK_INIT        0x13
+#define SOCK_LISTEN      0x14
+#define SOCK_ESTABLISHED 0x17
+#define SOCK_CLOSE_WAIT  0x1C
+#define SOCK_UDP         0x22
+#define SOCK_MACRAW      0x42
+
+typedef struct
+{
+  uint8_t  reg[0x30];
+  uint16_t rx_rsr;     // received size, updated by arriving data and the RECV command
+  uint16_t rx_freed;   // RX read pointer of the last RECV command: the buffer is free up to here
+  int      fd;         // host socket of a TCP/UDP socket (TCP listen: the listening socket)
+  uint8_t  tx[BUFFER_SIZE];
+  uint8_t  rx[BUFFER_SIZE];
+} w5500_socket_t;
+
+static uint8_t        CommonReg[0x40];
+static w5500_socket_t Socket[SOCKETS];
+static int            TapFd = -1;
+
+// SPI frame: address (16bit), control byte (block select, read/write), data
+static bool     Selected;
+static uint8_t  Phase;
+static uint16_t Address;
+static uint8_t  Control;
+static uint8_t  SpiResult;
+
+static uint16_t get16(const uint8_t* p)            { return (p[0] << 8) | p[1]; }
+static void     put16(uint8_t* p, uint16_t value)  { p[0] = value >> 8; p[1] = value & 0xff; }
+
+static uint16_t buffer_size(uint8_t kb)
+{
+  return (kb > 16) ? BUFFER_SIZE : kb*1024;
+}
+
+static void host_socket_close(w5500_socket_t* s)
+{
+  if (s->fd >= 0)
+    close(s->fd);
+  s->fd = -1;
+}
+
+// address of the socket's peer (Sn_DIPR, Sn_DPORT)
+static struct sockaddr_in peer_address(w5500_socket_t* s)
+{
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  memcpy(&addr.sin_addr, &s->reg[Sn_DIPR], 4);
+  addr.sin_port = htons(get16(&s->reg[Sn_DPORT]));
+  return addr;
+}
+
+// host socket bound to the socket's local port (Sn_PORT)
+static int host_socket_open(w5500_socket_t* s, int type)
+{
+  struct sockaddr_in addr;
+  int one = 1;
+  int fd = socket(AF_INET, type, 0);
+  if (fd < 0)
+    return -1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(get16(&s->reg[Sn_PORT]));
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void w5500_reset(void)
+{
+  memset(CommonReg, 0, sizeof(CommonReg));
+  CommonReg[PHYCFGR]  = 0xBF; // link up, 100MBit full duplex
+  CommonReg[VERSIONR] = 0x04;
+  for (uint8_t n=0;n<SOCKETS;n++)
+  {
+    w5500_socket_t* s = &Socket[n];
+    memset(s->reg, 0, sizeof(s->reg));
+    s->reg[Sn_TTL]        = 0x80;
+    s->reg[Sn_RXBUF_SIZE] = 2;
+    s->reg[Sn_TXBUF_SIZE] = 2;
+    s->rx_rsr   = 0;
+    s->rx_freed = 0;
+    host_socket_close(s);
+  }
+}
+
+static void socket_command(w5500_socket_t* s, uint8_t cmd)
+{
+  switch (cmd)
+  {
+    case 0x01: // OPEN
+      memset(&s->reg[Sn_TX_RD], 0, Sn_RX_WR+2-Sn_TX_RD);
+      s->rx_rsr   = 0;
+      s->rx_freed = 0;
+      host_socket_close(s);
+      switch (s->reg[Sn_MR] & 0x0f)
+      {
+        case 0x01: s->reg[Sn_SR] = SOCK_INIT; break;
+        case 0x02: // UDP
+          s->fd = host_socket_open(s, SOCK_DGRAM);
+          s->reg[Sn_SR] = (s->fd >= 0) ? SOCK_UDP : SOCK_CLOSED;
+          break;
+        case 0x04: s->reg[Sn_SR] = (s == &Socket[0]) ? SOCK_MACRAW : SOCK_CLOSED; break; // socket 0 only
+        default:   s->reg[Sn_SR] = SOCK_CLOSED; break;
+      }
+      break;
+    case 0x02: // LISTEN
+      if (s->reg[Sn_SR] == SOCK_INIT)
+      {
+        s->fd = host_socket_open(s, SOCK_STREAM);
+        if ((s->fd >= 0)&&(listen(s->fd, 1) == 0))
+        {
+          fcntl(s->fd, F_SETFL, O_NONBLOCK);
+          s->reg[Sn_SR] = SOCK_LISTEN;
+        }
+        else
+        {
+          host_socket_close(s);
+          s->reg[Sn_SR] = SOCK_CLOSED;
+        }
+      }
+      break;
+    case 0x04: // CONNECT: the host connects immediately (or fails with a timeout)
+      if (s->reg[Sn_SR] == SOCK_INIT)
+      {
+        struct sockaddr_in addr = peer_address(s);
+        s->fd = socket(AF_INET, SOCK_STREAM, 0);
+        if ((s->fd >= 0)&&(connect(s->fd, (struct sockaddr*) &addr, sizeof(addr)) == 0))
+        {
+          fcntl(s->fd, F_SETFL, O_NONBLOCK);
+          s->reg[Sn_SR] = SOCK_ESTABLISHED;
+          s->reg[Sn_IR] |= 0x01; // CON
+        }
+        else
+        {
+          host_socket_close(s);
+          s->reg[Sn_SR] = SOCK_CLOSED;
+          s->reg[Sn_IR] |= 0x08; // TIMEOUT
+        }
+      }
+      break;
+    case 0x08: // DISCON: all data was already sent, the peer acknowledges immediately
+    case 0x10: // CLOSE
+      host_socket_close(s);
+      s->reg[Sn_SR] = SOCK_CLOSED;
+      break;
+    case 0x20: // SEND
+    {
+      uint16_t rd   = get16(&s->reg[Sn_TX_RD]);
+      uint16_t wr   = get16(&s->reg[Sn_TX_WR]);
+      uint16_t mask = buffer_size(s->reg[Sn_TXBUF_SIZE])-1;
+      uint8_t  frame[BUFFER_SIZE];
+      uint16_t len = 0;
+      while ((rd != wr)&&(len < sizeof(frame)))
+        frame[len++] = s->tx[(rd++) & mask];
+      put16(&s->reg[Sn_TX_RD], wr);
+      if ((s->reg[Sn_SR] == SOCK_MACRAW)&&(TapFd >= 0))
+      {
+        if (write(TapFd, frame, len) == len)
+          w5500_host_stats.frames_sent++;
+      }
+      else
+      if ((s->reg[Sn_SR] == SOCK_UDP)&&(len > 0))
+      {
+        struct sockaddr_in addr = peer_address(s);
+        sendto(s->fd, frame, len, 0, (struct sockaddr*) &addr, sizeof(addr));
+      }
+      else
+      if (((s->reg[Sn_SR] == SOCK_ESTABLISHED)||(s->reg[Sn_SR] == SOCK_CLOSE_WAIT))&&(len > 0))
+      {
+        // blocking: the data is in the host's socket buffer, when SEND completes
+        fcntl(s->fd, F_SETFL, 0);
+        if (send(s->fd, frame, len, MSG_NOSIGNAL) != len)
+        {
+          host_socket_close(s);
+          s->reg[Sn_SR] = SOCK_CLOSED;
+        }
+        else
+          fcntl(s->fd, F_SETFL, O_NONBLOCK);
+      }
+      s->reg[Sn_IR] |= 0x10; // SENDOK
+      break;
+    }
+    case 0x40: // RECV
+      s->rx_freed = get16(&s->reg[Sn_RX_RD]);
+      s->rx_rsr   = get16(&s->reg[Sn_RX_WR]) - s->rx_freed;
+      break;
+  }
+}
+
+static uint8_t register_read(uint8_t block, uint16_t address)
+{
+  if (block == 0)
+    return (address < sizeof(CommonReg)) ? CommonReg[address] : 0;
+
+  w5500_socket_t* s = &Socket[block >> 2];
+  switch (block & 3)
+  {
+    case 1:
+      switch (address)
+      {
+        case Sn_CR:
+          return 0; // commands complete immediately
+        case Sn_TX_FSR:
+        case Sn_TX_FSR+1:
+        {
+          uint8_t fsr[2];
+          put16(fsr, buffer_size(s->reg[Sn_TXBUF_SIZE]) - (uint16_t)(get16(&s->reg[Sn_TX_WR]) - get16(&s->reg[Sn_TX_RD])));
+          return fsr[address-Sn_TX_FSR];
+        }
+        case Sn_RX_RSR:
+          return s->rx_rsr >> 8;
+        case Sn_RX_RSR+1:
+          return s->rx_rsr & 0xff;
+      }
+      return (address < sizeof(s->reg)) ? s->reg[address] : 0;
+    case 2:
+      return s->tx[address & (buffer_size(s->reg[Sn_TXBUF_SIZE])-1)];
+    case 3:
+      return s->rx[address & (buffer_size(s->reg[Sn_RXBUF_SIZE])-1)];
+  }
+  return 0;
+}
+
+static void register_write(uint8_t block, uint16_t address, uint8_t value)
+{
+  if (block == 0)
+  {
+    if ((address == MR)&&(value & 0x80))
+      w5500_reset();
+    else
+    if ((address < sizeof(CommonReg))&&(address != VERSIONR))
+      CommonReg[address] = value;
+    return;
+  }
+
+  w5500_socket_t* s = &Socket[block >> 2];
+  switch (block & 3)
+  {
+    case 1:
+      switch (address)
+      {
+        case Sn_CR:
+          socket_command(s, value);
+          break;
+        case Sn_IR:
+          s->reg[Sn_IR] &= ~value;
+          break;
+        case Sn_SR:
+        case Sn_TX_FSR: case Sn_TX_FSR+1:
+        case Sn_TX_RD:  case Sn_TX_RD+1:
+        case Sn_RX_RSR: case Sn_RX_RSR+1:
+        case Sn_RX_WR:  case Sn_RX_WR+1:
+          break; // read-only
+        default:
+          if (address < sizeof(s->reg))
+            s->reg[address] = value;
+      }
+      break;
+    case 2:
+      s->tx[address & (buffer_size(s->reg[Sn_TXBUF_SIZE])-1)] = value;
+      break;
+  }
+}
+
+static uint8_t spi_transfer(uint8_t value)
+{
+  w5500_host_stats.spi_bytes++;
+  switch (Phase)
+  {
+    case 0: Address = value << 8; Phase++; return 0;
+    case 1: Address |= value;     Phase++; return 0;
+    case 2: Control = value;      Phase++; return 0;
+  }
+  uint8_t result = 0;
+  if (Control & 0x04)
+    register_write(Control >> 3, Address, value);
+  else
+    result = register_read(Control >> 3, Address);
+  Address++;
+  return result;
+}
+
+static void spdr_write(uint8_t value)
+{
+  SpiResult = (Selected) ? spi_transfer(value) : 0xff;
+}
+
+static uint8_t spdr_read(void)
+{
+  return SpiResult;
+}
+
+static uint8_t spsr_read(void)
+{
+  return _BV(SPIF); // transfers complete immediately
+}
+
+extern "C" void pinMode(uint8_t pin, uint8_t mode)
+{
+  (void) pin;
+  (void) mode;
+}
+
+extern "C" void digitalWrite(uint8_t pin, uint8_t value)
+{
+  (void) pin;
+  Selected = (value == LOW);
+  if (Selected)
+  {
+    Phase = 0;
+    w5500_host_stats.spi_selects++;
+  }
+}
+
+avr_register PORTB = {0xff, NULL, NULL};
+avr_register DDRB  = {0x00, NULL, NULL};
+avr_register PORTC = {0xff, portc_write, NULL};
+avr_register PINC  = {0x00, NULL, pinc_read};
+avr_register DDRC  = {0x00, NULL, NULL};
+avr_register PORTD = {0x00, NULL, NULL};
+avr_register PIND  = {0x00, NULL, pind_read};
+avr_register DDRD  = {0x00, NULL, NULL};
+avr_register SPCR  = {0x00, NULL, NULL};
+avr_register SPSR  = {0x00, NULL, spsr_read};
+avr_register SPDR  = {0x00, spdr_write, spdr_read};
+
+bool w5500_host_open(const char* tap)
+{
+  for (uint8_t n=0;n<SOCKETS;n++)
+    Socket[n].fd = -1;
+  w5500_reset();
+  if (tap == NULL)
+    return true;
+  TapFd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+  if (TapFd < 0)
+  {
+    perror("/dev/net/tun");
+    return false;
+  }
+  struct ifreq ifr;
+  memset(&ifr, 0, sizeof(ifr));
+  ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+  strncpy(ifr.ifr_name, tap, IFNAMSIZ-1);
+  if (ioctl(TapFd, TUNSETIFF, &ifr) < 0)
+  {
+    perror(tap);
+    close(TapFd);
+    TapFd = -1;
+    return false;
+  }
+  return true;
+}
+
+// copy data to the RX buffer
+static void rx_write(w5500_socket_t* s, const uint8_t* data, uint16_t len)
+{
+  uint16_t size = buffer_size(s->reg[Sn_RXBUF_SIZE]);
+  uint16_t wr   = get16(&s->reg[Sn_RX_WR]);
+  for (uint16_t i=0;i<len;i++)
+    s->rx[(wr++) & (size-1)] = data[i];
+  put16(&s->reg[Sn_RX_WR], wr);
+  s->rx_rsr += len;
+  s->reg[Sn_IR] |= 0x04; // RECV
+}
+
+// receive from the host sockets of the TCP/UDP sockets, returns the number of bytes in their RX buffers
+static uint16_t host_socket_receive(void)
+{
+  uint16_t total = 0;
+  for (uint8_t n=0;n<SOCKETS;n++)
+  {
+    w5500_socket_t* s = &Socket[n];
+    uint16_t size = buffer_size(s->reg[Sn_RXBUF_SIZE]);
+    uint16_t room = size - (uint16_t)(get16(&s->reg[Sn_RX_WR]) - s->rx_freed);
+    uint8_t  data[BUFFER_SIZE];
+    ssize_t  len;
+
+    if ((s->fd < 0)||(size == 0))
+      continue;
+    switch (s->reg[Sn_SR])
+    {
+      case SOCK_LISTEN:
+      {
+        int fd = accept(s->fd, NULL, NULL);
+        if (fd >= 0)
+        {
+          close(s->fd);
+          s->fd = fd;
+          fcntl(s->fd, F_SETFL, O_NONBLOCK);
+          s->reg[Sn_SR] = SOCK_ESTABLISHED;
+          s->reg[Sn_IR] |= 0x01; // CON
+        }
+        break;
+      }
+      case SOCK_ESTABLISHED:
+        if (room == 0)
+          break;
+        len = recv(s->fd, data, room, MSG_DONTWAIT);
+        if (len > 0)
+          rx_write(s, data, len);
+        else
+        if (len == 0)
+        {
+          // the peer closed the connection
+          s->reg[Sn_SR] = SOCK_CLOSE_WAIT;
+          s->reg[Sn_IR] |= 0x02; // DISCON
+        }
+        break;
+      case SOCK_UDP:
+      {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        // each datagram is preceded by a header: IP address, port, data length (big endian)
+        while ((len = recvfrom(s->fd, data, sizeof(data), MSG_DONTWAIT|MSG_PEEK, (struct sockaddr*) &addr, &addr_len)) >= 0)
+        {
+          if (room < len+8)
+            break;
+          uint8_t head[8];
+          memcpy(head, &addr.sin_addr, 4);
+          put16(&head[4], ntohs(addr.sin_port));
+          put16(&head[6], len);
+          recv(s->fd, data, sizeof(data), MSG_DONTWAIT);
+          rx_write(s, head, 8);
+          rx_write(s, data, len);
+          room -= len+8;
+        }
+        break;
+      }
+    }
+    total += get16(&s->reg[Sn_RX_WR]) - s->rx_freed;
+  }
+  return total;
+}
+
+uint16_t w5500_host_receive(void)
+{
+  w5500_socket_t* s = &Socket[0];
+  if (s->reg[Sn_SR] != SOCK_MACRAW)
+    return host_socket_receive();
+  if (TapFd < 0)
+    return 0;
+
+  uint16_t size = buffer_size(s->reg[Sn_RXBUF_SIZE]);
+  uint8_t  frame[2048];
+  ssize_t  len;
+  while ((len = read(TapFd, frame, sizeof(frame))) > 0)
+  {
+    w5500_host_stats.frames_received++;
+
+    // MACRAW: each frame is preceded by its length (16bit, big endian, including the 2 length bytes)
+    uint16_t wr   = get16(&s->reg[Sn_RX_WR]);
+    uint16_t need = len + 2;
+    if ((uint16_t)(size - (uint16_t)(wr - s->rx_freed)) < need)
+    {
+      w5500_host_stats.frames_dropped++;
+      continue;
+    }
+    s->rx[(wr++) & (size-1)] = need >> 8;
+    s->rx[(wr++) & (size-1)] = need & 0xff;
+    for (ssize_t i=0;i<len;i++)
+      s->rx[(wr++) & (size-1)] = frame[i];
+    put16(&s->reg[Sn_RX_WR], wr);
+    s->rx_rsr += need;
+    s->reg[Sn_IR] |= 0x04; // RECV
+  }
+  return get16(&s->reg[Sn_RX_WR]) - s->rx_freed;
+}
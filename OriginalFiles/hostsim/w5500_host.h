@@ -0,0 +1,52 @@
+/* w5500_host.h - W5500 and 82C55 models for the DAN][ host build.
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+
+#include <stdint.h>
+
+// W5500 SPI transactions and 82C55 transfers, counted like they would happen on the card
+typedef struct
+{
+  uint32_t spi_selects;     // W5500 chip selects (one register or buffer access each)
+  uint32_t spi_bytes;       // bytes sent to the W5500, including address and control bytes
+  uint32_t pio_out;         // bytes sent to the Apple II through the 82C55
+  uint32_t pio_in;          // bytes received from the Apple II
+  uint32_t frames_received; // frames received from the tap interface
+  uint32_t frames_dropped;  // frames dropped, because the socket's RX buffer was full
+  uint32_t frames_sent;     // frames sent to the tap interface
+} W5500_HOST_STATS;
+
+extern W5500_HOST_STATS w5500_host_stats;
+
+// attach the W5500 to a tap interface (i.e. "dan0"), NULL: TCP/UDP sockets only
+bool     w5500_host_open(const char* tap);
+
+// move the frames queued by the tap interface to the RX buffer of the MACRAW socket, or the data
+// received by the host sockets to the RX buffers of the TCP/UDP sockets, like the W5500 does while
+// the firmware is busy with other things. Returns the number of bytes in the RX buffers.
+uint16_t w5500_host_receive(void);
+
+// the Apple II side of the 82C55: queue bytes for the firmware, fetch the bytes sent by the firmware
+void     w5500_host_pio_write(const uint8_t* data, uint16_t len);
+uint16_t w5500_host_pio_read(uint8_t* buf, uint16_t size);
+
+// drop the queued bytes, which the firmware did not read
+void     w5500_host_pio_discard(void);
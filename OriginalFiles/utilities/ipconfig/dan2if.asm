@@ -35,8 +35,21 @@ TMPVOL1      =  8  ; set temporary volume configuration, single byte response
 GETVOLCFG    =  5  ; get EEPROM volume configuration
 GETVOLTMP    =  9  ; get temporary volume configuration
 SAFEREAD     = 10  ; failsafe read. Reads block from volume. Reads from bootprogram if volume was missing.
+GETVERSION   = 11  ; get firmware version and feature flags
+READBLOCKS   = 12  ; multi-block read. Block count passed in buflo. Each block is preceded by a status byte and followed by a check byte.
+WRITEBLOCKS  = 13  ; multi-block write. Block count passed in buflo. Each block is confirmed with a status byte.
+FLUSH        = 14  ; write all deferred blocks to disk (write-back mode)
+SETWRBACK    = 15  ; enable (blklo=1) or disable (blklo=0) the write-back mode. Setting is stored in EEPROM.
+ETHINIT      = $10 ; initialize the WIZnet in MACRAW mode (6 byte MAC address), stops the FTP server
+ETHPOLL      = $11 ; receive one frame (16bit buffer size, returns 16bit length and data)
+ETHSEND      = $12 ; send one frame (16bit length and data)
+ETHPOLLN     = $13 ; receive all frames which fit into the 16bit budget (length prefixed, 0 terminated)
+ETHFILTER    = $14 ; set the receive filter (flags, IP address, 2 EtherTypes, 4 ports), after ETHINIT
+ETHSENDN     = $15 ; send a list of frames (length prefixed, 0 terminated), returns 0 if all were sent
 SETIPCFG     = $20 ; set FTP/IP configuration
 GETIPCFG     = $21 ; get FTP/IP configuration
+VOLINFO      = $30 ; get volume diagnostics (format, fragments, start sector, size)
+VOLCATALOG   = $31 ; get names and sizes of 16 volumes per block (boot menu)
 ILLEGALCMD   = $FF ; An illegal command, always returning error $27.
 MAGICDAN     = $AC ; magic byte for all commands
 
@@ -0,0 +1,236 @@
+; DAN][ interface to the WIZnet's TCP/UDP sockets (firmware commands $40-$47)
+; by Thorsten C. Brehm, based on firmware by DL Marks
+;
+; The W5500 handles ARP, IP, TCP and UDP, so the 6502 only copies the payload.
+; Fill the parameter block "_dan2sock" and call "_dan2sock_do" (from C: see dan2sock.h):
+;
+;   offset  parameter
+;   $00     slot of the DAN][ card
+;   $01     command ($40-$47, see below)
+;   $02     socket number (SOCKOPEN: protocol PROTO_TCP or PROTO_UDP)
+;   $03     16bit value: port, length, buffer size or close mode
+;   $05     pointer to the data (SOCKINIT: 18 byte configuration, SOCKCONNECT: IP address, SOCKSEND/SOCKRECV: data)
+;   $07     returned: status (0=ok), socket number (SOCKOPEN) or socket state (SOCKSTATUS)
+;   $08     returned: 16bit length (SOCKSEND: bytes accepted, SOCKRECV: bytes received, SOCKSTATUS: bytes received)
+;   $0A     returned: 16bit free TX buffer space (SOCKSTATUS)
+;
+; The returned status/socket/state is also passed in A (X=0).
+
+.setcpu		"6502"
+
+; export the interface function and its parameter block
+.export _dan2sock_do
+.export _dan2sock
+
+;temp variables, in the ProDOS command area (like the DAN][ block driver)
+ptrlo   = $44  ; data pointer
+ptrhi   = $45
+cntlo   = $46  ; negative byte count
+cnthi   = $47
+
+MAGICDAN     = $AC ; magic byte for all commands
+
+; DAN][ socket commands
+SOCKINIT     = $40 ; initialize the WIZnet for its sockets (MAC, IP, subnet, gateway), stops the FTP server
+SOCKOPEN     = $41 ; open a socket (protocol, local port), returns the socket number ($FF: none free)
+SOCKCONNECT  = $42 ; TCP: connect to the IP address/port, UDP: set the destination
+SOCKLISTEN   = $43 ; wait for a TCP connection
+SOCKSEND     = $44 ; send data (length), returns the number of bytes accepted
+SOCKRECV     = $45 ; receive data (buffer size), returns the length (UDP: one datagram with an 8 byte header)
+SOCKSTATUS   = $46 ; returns the socket state (W5500 Sn_SR), received bytes, free TX buffer space
+SOCKCLOSE    = $47 ; close a socket (0=disconnect, 1=close immediately)
+
+; protocols (SOCKOPEN)
+PROTO_TCP        = 1
+PROTO_UDP        = 2
+
+; socket states (SOCKSTATUS)
+SOCK_CLOSED      = $00
+SOCK_INIT        = $13
+SOCK_LISTEN      = $14
+SOCK_ESTABLISHED = $17
+SOCK_CLOSE_WAIT  = $1C
+SOCK_UDP         = $22
+
+.segment	"DATA"
+
+_dan2sock:
+slot:    .byte $00
+command: .byte $00
+socket:  .byte $00
+value:   .word $0000
+data:    .word $0000
+result:  .byte $00
+length:  .word $0000
+txfree:  .word $0000
+
+  ; code is relocatable
+.segment	"CODE"
+
+_dan2sock_do:
+    lda  slot
+    asl  a
+    asl  a
+    asl  a
+    asl  a
+    ora  #$88        ; add $88 to it so we can address from page $BF ($BFF8-$BFFB)
+                     ; this works around 6502 phantom read
+    tax
+
+    lda  data        ; data pointer
+    sta  ptrlo
+    lda  data+1
+    sta  ptrhi
+
+    lda  #$FA        ; set register A control mode to 2
+    sta  $BFFB,x     ; write to 82C55 mode register (mode 2 reg A, mode 0 reg B)
+
+    lda  #MAGICDAN   ; send this byte first as a magic byte
+    jsr  putbyte
+    lda  command
+    jsr  putbyte
+    cmp  #SOCKINIT
+    bne  sockparams
+
+    lda  #18         ; MAC address, IP address, subnet mask, gateway
+    ldy  #$00
+    jsr  setcount
+    jsr  sendbytes
+    jmp  getresult
+
+sockparams:
+    lda  socket      ; socket number (or protocol) and 16bit value
+    jsr  putbyte
+    lda  value
+    jsr  putbyte
+    lda  value+1
+    jsr  putbyte
+
+    lda  command
+    cmp  #SOCKCONNECT
+    bne  notconnect
+    lda  #4          ; IP address
+    ldy  #$00
+    jsr  setcount
+    jsr  sendbytes
+    jmp  getresult
+
+notconnect:
+    cmp  #SOCKSEND
+    bne  notsend
+    jsr  getlength   ; number of bytes accepted
+    jsr  sendbytes
+    jmp  quitok
+
+notsend:
+    cmp  #SOCKRECV
+    bne  notrecv
+    jsr  getlength   ; number of bytes received
+    jsr  readbytes
+    jmp  quitok
+
+notrecv:
+    cmp  #SOCKSTATUS
+    bne  getresult
+    jsr  getbyte     ; socket state
+    sta  result
+    jsr  getlength   ; received bytes
+    jsr  getbyte     ; free TX buffer space
+    sta  txfree
+    jsr  getbyte
+    sta  txfree+1
+    lda  result
+    ldx  #$00
+    rts
+
+getresult:
+    jsr  getbyte     ; status or socket number
+    sta  result
+    ldx  #$00
+    rts
+
+quitok:
+    lda  #$00
+    sta  result
+    tax
+    rts
+
+getlength:           ; read a 16bit length, prepare the byte count
+    jsr  getbyte
+    sta  length
+    pha
+    jsr  getbyte
+    sta  length+1
+    tay
+    pla
+setcount:            ; byte count in A (low) and Y (high), stored negated
+    eor  #$FF
+    sta  cntlo
+    tya
+    eor  #$FF
+    sta  cnthi
+    inc  cntlo
+    bne  setdone
+    inc  cnthi
+setdone:
+    rts
+
+sendbytes:           ; send the counted bytes from the data pointer
+    ldy  #$00
+    lda  cntlo
+    ora  cnthi
+    beq  senddone
+sendloop:
+    lda  (ptrlo),y   ; write a byte to the Arduino
+    sta  $BFF8,x
+waitwrite:
+    lda  $BFFA,x     ; wait until its received
+    bpl  waitwrite
+    iny
+    bne  sendnext
+    inc  ptrhi
+sendnext:
+    inc  cntlo
+    bne  sendloop
+    inc  cnthi
+    bne  sendloop
+senddone:
+    rts
+
+readbytes:           ; read the counted bytes to the data pointer
+    ldy  #$00
+    lda  cntlo
+    ora  cnthi
+    beq  readdone
+readloop:
+    lda  $BFFA,x     ; wait until there's a byte available
+    and  #$20
+    beq  readloop
+    lda  $BFF8,x     ; get the byte
+    sta  (ptrlo),y   ; store in the buffer
+    iny
+    bne  readnext
+    inc  ptrhi
+readnext:
+    inc  cntlo
+    bne  readloop
+    inc  cnthi
+    bne  readloop
+readdone:
+    rts
+
+putbyte:             ; send A to the Arduino (A is preserved)
+    sta  $BFF8,x     ; push it to the Arduino
+    pha
+waitput:
+    lda  $BFFA,x     ; get port C
+    bpl  waitput     ; wait until its received (OBFA is high)
+    pla
+    rts
+
+getbyte:             ; read a byte from the Arduino to A
+    lda  $BFFA,x     ; wait until there's a byte available
+    and  #$20
+    beq  getbyte
+    lda  $BFF8,x     ; get the byte
+    rts
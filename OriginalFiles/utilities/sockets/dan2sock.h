@@ -0,0 +1,73 @@
+/* dan2sock.h - C interface to the DAN][ socket commands (see dan2sock.asm).
+
+  Copyright (c) 2023 Thorsten C. Brehm
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#ifndef _DAN2SOCK_H
+#define _DAN2SOCK_H
+
+#include <stdint.h>
+
+// commands
+#define SOCKINIT     0x40 // data: MAC(6), IP(4), subnet(4), gateway(4). Stops the FTP server.
+#define SOCKOPEN     0x41 // socket: protocol, value: local port (0=any). Returns the socket number (0xFF: none free).
+#define SOCKCONNECT  0x42 // value: remote port, data: IP address(4)
+#define SOCKLISTEN   0x43
+#define SOCKSEND     0x44 // value: length, data: bytes to send. Returns the accepted length.
+#define SOCKRECV     0x45 // value: buffer size, data: buffer. Returns the received length.
+#define SOCKSTATUS   0x46 // returns the state, the received length and the free TX buffer space
+#define SOCKCLOSE    0x47 // value: 0=disconnect, 1=close immediately
+
+// protocols
+#define SOCK_PROTO_TCP 1
+#define SOCK_PROTO_UDP 2
+
+// socket states (W5500 Sn_SR register)
+#define SOCK_CLOSED       0x00
+#define SOCK_INIT         0x13
+#define SOCK_LISTEN       0x14
+#define SOCK_ESTABLISHED  0x17
+#define SOCK_CLOSE_WAIT   0x1C
+#define SOCK_UDP          0x22
+
+typedef struct
+{
+  uint8_t  slot;     // slot of the DAN][ card
+  uint8_t  command;  // SOCKINIT...SOCKCLOSE
+  uint8_t  socket;   // socket number (SOCKOPEN: protocol)
+  uint16_t value;    // port, length, buffer size or close mode
+  uint8_t* data;     // configuration, IP address or data
+  uint8_t  result;   // returned status (0=ok), socket number or socket state
+  uint16_t length;   // returned length (accepted, received)
+  uint16_t txfree;   // returned free TX buffer space (SOCKSTATUS)
+} DAN2SOCK;
+
+extern DAN2SOCK dan2sock;
+
+// execute the command in "dan2sock", returns dan2sock.result
+uint8_t dan2sock_do(void);
+
+// UDP datagrams received by SOCKRECV start with this header (big-endian, as stored by the W5500)
+typedef struct
+{
+  uint8_t  ip[4];
+  uint8_t  port[2];
+  uint8_t  length[2];
+} DAN2SOCK_UDP_HEADER;
+
+#endif